@@ -38,6 +38,22 @@ struct PS_INPUT
     float3 Norm : NORMAL;
 };
 
+// インスタンシングで描画する球の入力（スロット1がインスタンスごとのデータ）
+struct VS_INSTANCED_INPUT
+{
+    float4 Pos : POSITION;
+    float3 Norm : NORMAL;
+    float3 InstancePos : INSTANCEPOS;
+    float InstanceColor : INSTANCECOLOR;
+};
+
+struct PS_INSTANCED_INPUT
+{
+    float4 Pos : SV_POSITION;
+    float3 Norm : NORMAL;
+    float4 Color : COLOR0;
+};
+
 //--------------------------------------------------------------------------------------
 // Vertex Shader
 //--------------------------------------------------------------------------------------
@@ -52,6 +68,20 @@ PS_INPUT VS( VS_INPUT input )
     return output;
 }
 
+//--------------------------------------------------------------------------------------
+// 球をインスタンスの座標だけ平行移動し、赤の成分をインスタンスの色で置き換える
+PS_INSTANCED_INPUT VS_Instanced( VS_INSTANCED_INPUT input )
+{
+    PS_INSTANCED_INPUT output = (PS_INSTANCED_INPUT)0;
+    output.Pos = mul( float4(input.Pos.xyz + input.InstancePos, 1.0f), World );
+    output.Pos = mul( output.Pos, View );
+    output.Pos = mul( output.Pos, Projection );
+    output.Norm = mul( input.Norm, World );
+    output.Color = float4( input.InstanceColor, Color.yzw );
+    
+    return output;
+}
+
 //--------------------------------------------------------------------------------------
 float4 PS( PS_INPUT input ) : SV_Target
 { 
@@ -59,6 +89,12 @@ float4 PS( PS_INPUT input ) : SV_Target
     return Color * ( saturate(dot(normalize(input.Norm),g_vLightDir)) * 0.7f + 0.3f);
 }
 
+//--------------------------------------------------------------------------------------
+float4 PS_Instanced( PS_INSTANCED_INPUT input ) : SV_Target
+{ 
+    return input.Color * ( saturate(dot(normalize(input.Norm),g_vLightDir)) * 0.7f + 0.3f);
+}
+
 //--------------------------------------------------------------------------------------
 technique10 Render
 {
@@ -70,3 +106,14 @@ technique10 Render
     }
 }
 
+
+//--------------------------------------------------------------------------------------
+technique10 RenderInstanced
+{
+    pass P0
+    {
+        SetVertexShader( CompileShader( vs_4_0, VS_Instanced() ) );
+        SetGeometryShader( NULL );
+        SetPixelShader( CompileShader( ps_4_0, PS_Instanced() ) );
+    }
+}
@@ -0,0 +1,689 @@
+﻿/*! \file ljmd_benchmark.cpp
+    \brief 分子動力学シミュレーションの各段階にかかる時間を測定し、JSON形式で出力するベンチマーク
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "../moleculardynamics/Ar_moleculardynamics.h"
+#include <algorithm>                        // for std::copy, std::find_if
+#include <chrono>                           // for std::chrono
+#include <cmath>                            // for std::fabs, std::sqrt
+#include <cstddef>                          // for std::size_t
+#include <cstdint>                          // for std::int32_t
+#include <cstdlib>                          // for EXIT_SUCCESS, EXIT_FAILURE
+#include <fstream>                          // for std::ofstream
+#include <functional>                       // for std::function
+#include <iostream>                         // for std::cout, std::cerr
+#include <sstream>                          // for std::ostringstream
+#include <string>                           // for std::string
+#include <thread>                           // for std::thread::hardware_concurrency
+#include <vector>                           // for std::vector
+#include <boost/algorithm/string/split.hpp> // for boost::algorithm::split
+#include <boost/format.hpp>                 // for boost::format
+#include <boost/lexical_cast.hpp>           // for boost::lexical_cast
+#include <boost/optional.hpp>               // for boost::optional
+#include <tbb/task_arena.h>                 // for tbb::task_arena
+
+namespace {
+    //! A struct.
+    /*!
+        一つの段階の測定結果
+    */
+    struct PhaseResult {
+        //! A public member variable.
+        /*!
+            1回の呼び出しにかかった時間（秒）
+        */
+        double seconds;
+
+        //! A public member variable.
+        /*!
+            1回の呼び出しで読み書きするバイト数の見積もり（0なら見積もらない）
+        */
+        double bytes;
+
+        //! A public member variable.
+        /*!
+            1回の呼び出しで処理するペアの数（0ならペアを扱わない）
+        */
+        double pairs;
+    };
+
+    //! A struct.
+    /*!
+        コマンドライン引数で与えられた設定
+    */
+    struct Options {
+        //! A public member variable.
+        /*!
+            -h, --helpで使い方の表示を求められたならtrue
+        */
+        bool help = false;
+
+        //! A public member variable.
+        /*!
+            測定するカーネル（空ならCPUIDにより選んだもの）
+        */
+        std::vector<moleculardynamics::ForceKernelType> kernels;
+
+        //! A public member variable.
+        /*!
+            結果に付けるラベル（コミットのハッシュなど）
+        */
+        std::string label;
+
+        //! A public member variable.
+        /*!
+            一つの測定にかける最小の時間（秒）
+        */
+        double mintime = 0.05;
+
+        //! A public member variable.
+        /*!
+            測定するスーパーセルの大きさの最大値
+        */
+        std::int32_t ncmax = 20;
+
+        //! A public member variable.
+        /*!
+            測定するスーパーセルの大きさの最小値
+            箱の一辺が2(rc + スキン)以下だと最小イメージ規約でカットオフ内の周期イメージを落とすので、
+            どのスケールでもそうならない4を既定値とする
+        */
+        std::int32_t ncmin = 4;
+
+        //! A public member variable.
+        /*!
+            結果を書き出すファイル（空なら標準出力）
+        */
+        std::string output;
+
+        //! A public member variable.
+        /*!
+            原子間力の計算の精度
+        */
+        moleculardynamics::PrecisionType precision = moleculardynamics::PrecisionType::DOUBLE;
+
+        //! A public member variable.
+        /*!
+            原子の配列を並べ替える間隔（指定されなければ既定値）
+        */
+        boost::optional<std::int32_t> reorderinterval;
+
+        //! A public member variable.
+        /*!
+            calculate()で物理量をサンプリングする間隔
+        */
+        std::int32_t sampleinterval = 1;
+
+        //! A public member variable.
+        /*!
+            測定する格子定数のスケール（密度）
+        */
+        std::vector<double> scales = { 0.9, 1.0, 1.2 };
+
+        //! A public member variable.
+        /*!
+            表による補間の区間の数（指定されなければ既定値）
+        */
+        boost::optional<std::int32_t> tablesize;
+
+        //! A public member variable.
+        /*!
+            測定するスレッド数（空ならハードウェアのスレッド数まで2倍ずつ）
+        */
+        std::vector<std::int32_t> threads;
+    };
+
+    //! A global variable (constant).
+    /*!
+        原子間力の計算の精度の名前（PrecisionTypeの順）
+    */
+    char const * const PRECISIONNAME[] = { "double", "mixed" };
+
+    //! A global variable (constant).
+    /*!
+        描画用のレコードを作るときに、力の大きさを色に変換する比率（LJ_Argon_MD.cppと同じ値）
+    */
+    float const COLORRATIO = 0.025f;
+
+    //! A global variable (constant).
+    /*!
+        原子間力の計算に使うカーネルの名前（ForceKernelTypeの順）
+    */
+    char const * const KERNELNAME[] = { "reference", "scalar", "avx2", "avx512", "table" };
+
+    //! A global variable (constant).
+    /*!
+        ベンチマークで使うペアリストのスキンの厚さ
+    */
+    double const SKIN = 0.3;
+
+    //! A function.
+    /*!
+        文字列をJSONの文字列の中に書けるようにエスケープする
+        \param str 元の文字列
+        \return エスケープした文字列（前後の引用符は含まない）
+    */
+    std::string json_escape(std::string const & str);
+
+    //! A function.
+    /*!
+        関数の1回の呼び出しにかかる時間を測定する
+        合計の時間がmintimeを超えるまで、呼び出す回数を2倍ずつ増やす
+        \param func 測定する関数
+        \param mintime 測定にかける最小の時間（秒）
+        \return 1回の呼び出しにかかった時間（秒）
+    */
+    double measure(std::function<void()> const & func, double mintime);
+
+    //! A function.
+    /*!
+        カンマ区切りのカーネルの名前を、カーネルの種類の配列に変換する
+        \param str カンマ区切りのカーネルの名前
+        \param kernels 変換した結果を格納する配列
+        \return 全ての名前が正しければtrue
+    */
+    bool parse_kernels(std::string const & str, std::vector<moleculardynamics::ForceKernelType> & kernels);
+
+    //! A function.
+    /*!
+        コマンドライン引数を解析する
+        \param argc コマンドライン引数の数
+        \param argv コマンドライン引数
+        \param opts 解析した結果を格納する構造体
+        \return 解析に成功し、ベンチマークを実行すべきならtrue（使い方を表示したときはfalseで、opts.helpがtrue）
+    */
+    bool parse_options(int argc, char * argv[], Options & opts);
+
+    template <typename T>
+    //! A template function.
+    /*!
+        カンマ区切りの文字列を数値の配列に変換する
+        \tparam T 数値の型
+        \param str カンマ区切りの文字列
+        \return 数値の配列
+    */
+    std::vector<T> split_list(std::string const & str);
+
+    //! A function.
+    /*!
+        表による補間の誤差をJSONのオブジェクトとして書き出す
+        関数としての誤差に加えて、現在の配置で解析的な式（スカラー版）と比べた力とエネルギーの誤差も求める
+        \param os 出力先
+        \param armd 表による補間のカーネルを使うオブジェクト（比べた後、カーネルは元に戻す）
+    */
+    void write_table_accuracy(std::ostream & os, moleculardynamics::Ar_moleculardynamics & armd);
+
+    //! A function.
+    /*!
+        一つの段階の測定結果をJSONのオブジェクトとして書き出す
+        \param os 出力先
+        \param name 段階の名前
+        \param res 測定結果
+        \param numatom 原子数
+        \param last 最後の要素ならtrue
+    */
+    void write_phase(std::ostream & os, char const * name, PhaseResult const & res, std::int32_t numatom, bool last);
+
+    //! A function.
+    /*!
+        使い方を表示する
+        \param prog プログラム名
+    */
+    void usage(char const * prog);
+}
+
+//! A function.
+/*!
+    メイン関数
+    \param argc コマンドライン引数の数
+    \param argv コマンドライン引数
+    \return 終了コード
+*/
+int main(int argc, char * argv[])
+{
+    Options opts;
+    if (!parse_options(argc, argv, opts)) {
+        return opts.help ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    auto const hwthreads = static_cast<std::int32_t>(std::thread::hardware_concurrency());
+    if (opts.threads.empty()) {
+        for (auto t = 1; t < hwthreads; t *= 2) {
+            opts.threads.push_back(t);
+        }
+
+        opts.threads.push_back(hwthreads > 0 ? hwthreads : 1);
+    }
+
+    if (opts.kernels.empty()) {
+        opts.kernels.push_back(moleculardynamics::selectForceKernel());
+    }
+
+    std::ostringstream json;
+    json << "{\n";
+    json << boost::format("  \"label\": \"%s\",\n") % json_escape(opts.label);
+    json << boost::format("  \"hardware_concurrency\": %d,\n") % hwthreads;
+    json << boost::format("  \"min_time_s\": %g,\n") % opts.mintime;
+    json << boost::format("  \"sample_interval\": %d,\n") % opts.sampleinterval;
+    json << boost::format("  \"precision\": \"%s\",\n") % PRECISIONNAME[static_cast<std::int32_t>(opts.precision)];
+    json << boost::format("  \"reorder_interval\": %d,\n") % opts.reorderinterval.get_value_or(static_cast<std::int32_t>(moleculardynamics::Ar_moleculardynamics::FIRSTREORDERINTERVAL));
+    json << "  \"results\": [";
+
+    auto first = true;
+    for (auto const nthreads : opts.threads) {
+        // 各スレッド数ごとにアリーナを作り、その中で全ての計算を行う
+        tbb::task_arena arena(nthreads);
+
+        for (auto nc = opts.ncmin; nc <= opts.ncmax; nc++) {
+            for (auto const scale : opts.scales) {
+                for (auto const kernel : opts.kernels) {
+                    std::cerr << boost::format("threads = %d, Nc = %d, scale = %g, kernel = %s\n") % nthreads % nc % scale % KERNELNAME[static_cast<std::int32_t>(kernel)];
+
+                    arena.execute([&] {
+                        moleculardynamics::Ar_moleculardynamics armd;
+                        armd.setForceKernel(kernel);
+                        armd.setPrecision(opts.precision);
+                        if (opts.tablesize) {
+                            armd.setTableSize(*opts.tablesize);
+                        }
+
+                        if (opts.reorderinterval) {
+                            armd.setReorderInterval(*opts.reorderinterval);
+                        }
+
+                        armd.setSampleInterval(opts.sampleinterval);
+                        armd.setSkin(SKIN);
+                        armd.setScale(scale);
+                        armd.setNc(nc);
+
+                        // 箱が小さすぎると最小イメージ規約が成り立たず、物理的に正しくない系を測ることになる
+                        auto const sigma = moleculardynamics::Ar_moleculardynamics::SIGMA * 1.0E+9;
+                        if (armd.getPeriodiclen() <= 2.0 * (armd.getCutoff() + SKIN * sigma)) {
+                            std::cerr << boost::format("skipped: the box (%g nm) is not longer than 2 (rc + skin) = %g nm\n")
+                                % armd.getPeriodiclen()
+                                % (2.0 * (armd.getCutoff() + SKIN * sigma));
+                            return;
+                        }
+
+                        // 初期配置から少し動かしてから測定する
+                        for (auto i = 0; i < 10; i++) {
+                            armd.calculate();
+                        }
+
+                        // 表による補間の誤差は、測定で配置が崩れる前に求めておく
+                        auto const table = armd.getForceKernel() == moleculardynamics::ForceKernelType::TABLE;
+                        std::ostringstream tablejson;
+                        if (table) {
+                            write_table_accuracy(tablejson, armd);
+                        }
+
+                        auto const n = static_cast<double>(armd.NumAtom);
+                        auto const stride = static_cast<double>(armd.atoms().stride());
+                        auto const pairs = static_cast<double>(armd.getNumPairs());
+
+                        // 座標と速度の更新だけを繰り返すと力と釣り合わずに系が壊れ、毎ステップペアリストを作り直すようになるので、
+                        // 1ステップの時間は系を動かす測定より先に、正しく時間発展している系で測る
+                        PhaseResult const step = {
+                            measure([&armd] { armd.calculate(); }, opts.mintime),
+                            0.0,
+                            pairs
+                        };
+
+                        // バイト数の見積もり
+                        // ペアリストの作成：座標の読み込みと作成時の座標の保存、セルへの登録、ペアごとに相手の座標の読み込みと番号の書き込み
+                        // 原子間力：ペアごとに番号、相手の座標、相手の力の読み書き、原子ごとに座標と力、
+                        //           最初に力をゼロにする
+                        // 座標の更新：力を読み、速度と座標を読み書きする
+                        // 速度の更新：力を読み、速度を読み書きする
+                        // 描画用のレコード：座標と力を読み、原子ごとに16バイト書き込む
+                        PhaseResult const makepair = {
+                            measure([&armd] { armd.setSkin(SKIN); armd.make_pair(); }, opts.mintime),
+                            n * (24.0 + 24.0 + 8.0) + pairs * (4.0 + 24.0),
+                            pairs
+                        };
+
+                        PhaseResult const force = {
+                            measure([&armd] { armd.calculate_force_pair(true); }, opts.mintime),
+                            pairs * (4.0 + 24.0 + 48.0) + n * (24.0 + 48.0 + 8.0) + 3.0 * stride * 8.0,
+                            pairs
+                        };
+
+                        // エネルギーとビリアルを計算しない（サンプリングしないステップの）原子間力
+                        PhaseResult const forceonly = {
+                            measure([&armd] { armd.calculate_force_pair(false); }, opts.mintime),
+                            pairs * (4.0 + 24.0 + 48.0) + n * (24.0 + 48.0 + 8.0) + 3.0 * stride * 8.0,
+                            pairs
+                        };
+
+                        std::vector<float> frame(4 * static_cast<std::size_t>(armd.NumAtom));
+                        PhaseResult const renderframe = {
+                            measure([&armd, &frame] { armd.exportRenderFrame(frame.data(), COLORRATIO); }, opts.mintime),
+                            n * (48.0 + 16.0),
+                            0.0
+                        };
+
+                        // 以下の二つは系を壊すので最後に測る（この後は原子数とペアの数しか使わない）
+                        PhaseResult const position = {
+                            measure([&armd] { armd.update_position(1.0, 1.0, 1.0); }, opts.mintime),
+                            3.0 * stride * 8.0 * 5.0,
+                            0.0
+                        };
+
+                        PhaseResult const velocity = {
+                            measure([&armd] { armd.update_velocity(true); }, opts.mintime),
+                            3.0 * stride * 8.0 * 3.0,
+                            0.0
+                        };
+
+                        json << (first ? "\n" : ",\n");
+                        first = false;
+
+                        json << "    {\n";
+                        json << boost::format("      \"Nc\": %d,\n") % nc;
+                        json << boost::format("      \"atoms\": %d,\n") % armd.NumAtom;
+                        json << boost::format("      \"scale\": %g,\n") % scale;
+                        json << boost::format("      \"threads\": %d,\n") % nthreads;
+                        json << boost::format("      \"kernel\": \"%s\",\n") % KERNELNAME[static_cast<std::int32_t>(armd.getForceKernel())];
+                        json << boost::format("      \"pairs\": %d,\n") % armd.getNumPairs();
+                        json << "      \"phases\": {\n";
+                        write_phase(json, "make_pair", makepair, armd.NumAtom, false);
+                        write_phase(json, "calculate_force_pair", force, armd.NumAtom, false);
+                        write_phase(json, "calculate_force_pair_force_only", forceonly, armd.NumAtom, false);
+                        write_phase(json, "update_position", position, armd.NumAtom, false);
+                        write_phase(json, "update_velocity", velocity, armd.NumAtom, false);
+                        write_phase(json, "export_render_frame", renderframe, armd.NumAtom, false);
+                        write_phase(json, "calculate", step, armd.NumAtom, true);
+
+                        json << (table ? "      },\n" : "      }\n");
+                        json << tablejson.str();
+
+                        json << "    }";
+                    });
+                }
+            }
+        }
+    }
+
+    json << "\n  ]\n}\n";
+
+    if (opts.output.empty()) {
+        std::cout << json.str();
+    }
+    else {
+        std::ofstream ofs(opts.output);
+        if (!ofs) {
+            std::cerr << boost::format("%s: cannot open '%s'\n") % argv[0] % opts.output;
+            return EXIT_FAILURE;
+        }
+
+        ofs << json.str();
+    }
+
+    return EXIT_SUCCESS;
+}
+
+namespace {
+    std::string json_escape(std::string const & str)
+    {
+        std::string res;
+        res.reserve(str.size());
+        for (auto const c : str) {
+            switch (c) {
+            case '"':
+                res += "\\\"";
+                break;
+
+            case '\\':
+                res += "\\\\";
+                break;
+
+            case '\n':
+                res += "\\n";
+                break;
+
+            case '\t':
+                res += "\\t";
+                break;
+
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    res += (boost::format("\\u%04x") % static_cast<std::int32_t>(c)).str();
+                }
+                else {
+                    res += c;
+                }
+                break;
+            }
+        }
+
+        return res;
+    }
+
+    double measure(std::function<void()> const & func, double mintime)
+    {
+        func();
+
+        for (auto reps = 1; ; reps *= 2) {
+            auto const begin = std::chrono::steady_clock::now();
+
+            for (auto i = 0; i < reps; i++) {
+                func();
+            }
+
+            auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            if (elapsed >= mintime) {
+                return elapsed / static_cast<double>(reps);
+            }
+        }
+    }
+
+    bool parse_kernels(std::string const & str, std::vector<moleculardynamics::ForceKernelType> & kernels)
+    {
+        std::vector<std::string> items;
+        boost::algorithm::split(items, str, [](char c) { return c == ','; });
+
+        kernels.clear();
+        for (auto const & item : items) {
+            auto const first = std::begin(KERNELNAME);
+            auto const it = std::find_if(first, std::end(KERNELNAME), [&item](char const * name) { return item == name; });
+            if (it == std::end(KERNELNAME)) {
+                return false;
+            }
+
+            kernels.push_back(static_cast<moleculardynamics::ForceKernelType>(it - first));
+        }
+
+        return true;
+    }
+
+    bool parse_options(int argc, char * argv[], Options & opts)
+    {
+        try {
+            for (auto i = 1; i < argc; i++) {
+                std::string const arg(argv[i]);
+
+                if (arg == "-h" || arg == "--help") {
+                    opts.help = true;
+                    usage(argv[0]);
+                    return false;
+                }
+
+                if (i + 1 >= argc) {
+                    std::cerr << boost::format("%s: missing value for %s\n") % argv[0] % arg;
+                    return false;
+                }
+
+                std::string const val(argv[++i]);
+
+                if (arg == "--nc-min") {
+                    opts.ncmin = boost::lexical_cast<std::int32_t>(val);
+                }
+                else if (arg == "--nc-max") {
+                    opts.ncmax = boost::lexical_cast<std::int32_t>(val);
+                }
+                else if (arg == "-s" || arg == "--scales") {
+                    opts.scales = split_list<double>(val);
+                }
+                else if (arg == "-j" || arg == "--threads") {
+                    opts.threads = split_list<std::int32_t>(val);
+                }
+                else if (arg == "-k" || arg == "--kernels") {
+                    if (!parse_kernels(val, opts.kernels)) {
+                        std::cerr << boost::format("%s: unknown kernel in '%s'\n") % argv[0] % val;
+                        return false;
+                    }
+                }
+                else if (arg == "-P" || arg == "--precision") {
+                    if (val == "double") {
+                        opts.precision = moleculardynamics::PrecisionType::DOUBLE;
+                    }
+                    else if (val == "mixed") {
+                        opts.precision = moleculardynamics::PrecisionType::MIXED;
+                    }
+                    else {
+                        std::cerr << boost::format("%s: unknown precision '%s'\n") % argv[0] % val;
+                        return false;
+                    }
+                }
+                else if (arg == "--table-size") {
+                    opts.tablesize = boost::lexical_cast<std::int32_t>(val);
+                }
+                else if (arg == "--reorder-interval") {
+                    opts.reorderinterval = boost::lexical_cast<std::int32_t>(val);
+                }
+                else if (arg == "-S" || arg == "--sample-interval") {
+                    opts.sampleinterval = boost::lexical_cast<std::int32_t>(val);
+                }
+                else if (arg == "-t" || arg == "--min-time") {
+                    opts.mintime = boost::lexical_cast<double>(val);
+                }
+                else if (arg == "-l" || arg == "--label") {
+                    opts.label = val;
+                }
+                else if (arg == "-o" || arg == "--output") {
+                    opts.output = val;
+                }
+                else {
+                    std::cerr << boost::format("%s: unknown option '%s'\n") % argv[0] % arg;
+                    usage(argv[0]);
+                    return false;
+                }
+            }
+        }
+        catch (boost::bad_lexical_cast const &) {
+            std::cerr << boost::format("%s: invalid numeric value\n") % argv[0];
+            return false;
+        }
+
+        if (opts.ncmin <= 0 || opts.ncmax < opts.ncmin || opts.mintime <= 0.0 || opts.scales.empty() || opts.sampleinterval <= 0 || (opts.tablesize && *opts.tablesize <= 0) || (opts.reorderinterval && *opts.reorderinterval < 0)) {
+            std::cerr << boost::format("%s: invalid range of Nc, scale, time, sample interval, table size or reorder interval\n") % argv[0];
+            return false;
+        }
+
+        for (auto const t : opts.threads) {
+            if (t <= 0) {
+                std::cerr << boost::format("%s: threads must be positive\n") % argv[0];
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    std::vector<T> split_list(std::string const & str)
+    {
+        std::vector<std::string> items;
+        boost::algorithm::split(items, str, [](char c) { return c == ','; });
+
+        std::vector<T> result;
+        for (auto const & item : items) {
+            result.push_back(boost::lexical_cast<T>(item));
+        }
+
+        return result;
+    }
+
+    void write_table_accuracy(std::ostream & os, moleculardynamics::Ar_moleculardynamics & armd)
+    {
+        auto const acc = armd.getTableAccuracy();
+
+        // 同じ配置で、表による補間と解析的な式の力を求めて比べる
+        auto const & atoms = armd.atoms();
+        auto const n = static_cast<std::int32_t>(armd.NumAtom);
+
+        armd.calculate_force_pair(true);
+        std::vector<double> ftable(3 * n);
+        for (auto k = 0; k < 3; k++) {
+            auto const f = atoms.data(moleculardynamics::Atoms::F, k);
+            std::copy(f, f + n, ftable.begin() + k * n);
+        }
+        double const uptable = armd.Up;
+
+        armd.setForceKernel(moleculardynamics::ForceKernelType::SCALAR);
+        armd.calculate_force_pair(true);
+        double const upexact = armd.Up;
+
+        auto diff2 = 0.0;
+        auto norm2 = 0.0;
+        for (auto k = 0; k < 3; k++) {
+            auto const f = atoms.data(moleculardynamics::Atoms::F, k);
+            for (auto i = 0; i < n; i++) {
+                auto const d = ftable[k * n + i] - f[i];
+                diff2 += d * d;
+                norm2 += f[i] * f[i];
+            }
+        }
+
+        armd.setForceKernel(moleculardynamics::ForceKernelType::TABLE);
+
+        os << "      \"table\": {";
+        os << boost::format(" \"size\": %d,") % armd.getTableSize();
+        os << boost::format(" \"max_rel_force_error\": %.3e,") % acc.force;
+        os << boost::format(" \"max_energy_error_epsilon\": %.3e,") % acc.energy;
+        os << boost::format(" \"rms_rel_force_error\": %.3e,") % (norm2 > 0.0 ? std::sqrt(diff2 / norm2) : 0.0);
+        os << boost::format(" \"rel_energy_error\": %.3e") % (upexact != 0.0 ? std::fabs((uptable - upexact) / upexact) : 0.0);
+        os << " }\n";
+    }
+
+    void write_phase(std::ostream & os, char const * name, PhaseResult const & res, std::int32_t numatom, bool last)
+    {
+        os << boost::format("        \"%s\": {") % name;
+        os << boost::format(" \"ns_per_call\": %.1f,") % (res.seconds * 1.0E+9);
+        os << boost::format(" \"ns_per_atom_step\": %.3f") % (res.seconds * 1.0E+9 / static_cast<double>(numatom));
+
+        if (res.pairs > 0.0) {
+            os << boost::format(", \"pairs_per_s\": %.4e") % (res.pairs / res.seconds);
+        }
+
+        if (res.bytes > 0.0) {
+            os << boost::format(", \"est_bandwidth_GBps\": %.3f") % (res.bytes / res.seconds * 1.0E-9);
+        }
+
+        os << (last ? " }\n" : " },\n");
+    }
+
+    void usage(char const * prog)
+    {
+        std::cerr << boost::format(
+            "Usage: %s [options]\n"
+            "  --nc-min N            smallest supercell size (default: 4)\n"
+            "                        sizes whose box is not longer than 2 (rc + skin) are skipped\n"
+            "  --nc-max N            largest supercell size (default: 20)\n"
+            "  -s, --scales LIST     comma separated lattice constant scales (default: 0.9,1.0,1.2)\n"
+            "  -j, --threads LIST    comma separated thread counts (default: 1, 2, 4, ... up to all)\n"
+            "  -k, --kernels LIST    comma separated kernels out of reference, scalar, avx2, avx512 and table\n"
+            "                        (default: best for the CPU)\n"
+            "  -P, --precision X     double or mixed (default: double)\n"
+            "  --table-size N        number of intervals of the table kernel (default: 1024)\n"
+            "  --reorder-interval N  sort the atoms in Morton order every N list rebuilds, 0 to disable (default: 10)\n"
+            "  -S, --sample-interval N  sample the energies every N steps in calculate (default: 1)\n"
+            "  -t, --min-time SEC    minimum time spent on one measurement (default: 0.05)\n"
+            "  -l, --label TEXT      label stored in the output, e.g. a commit hash\n"
+            "  -o, --output FILE     write the JSON to FILE instead of the standard output\n"
+            "  -h, --help            show this message\n") % prog;
+    }
+}
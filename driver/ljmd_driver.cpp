@@ -0,0 +1,678 @@
+﻿/*! \file ljmd_driver.cpp
+    \brief 描画を行わずに分子動力学シミュレーションを実行するコマンドラインドライバ
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "../moleculardynamics/Ar_moleculardynamics.h"
+#include "../moleculardynamics/compressedtrajectory.h"
+#include "../moleculardynamics/trajectory.h"
+#include <chrono>                       // for std::chrono
+#include <cstdint>                      // for std::int32_t
+#include <cstdlib>                      // for EXIT_SUCCESS, EXIT_FAILURE
+#include <iostream>                     // for std::cout, std::cerr
+#include <memory>                       // for std::unique_ptr
+#include <string>                       // for std::string
+#include <vector>                       // for std::vector
+#include <boost/algorithm/string/split.hpp> // for boost::algorithm::split
+#include <boost/format.hpp>             // for boost::format
+#include <boost/lexical_cast.hpp>       // for boost::lexical_cast
+#include <boost/optional.hpp>           // for boost::optional
+#include <tbb/global_control.h>         // for tbb::global_control
+
+namespace {
+    //! A struct.
+    /*!
+        コマンドライン引数で与えられた設定
+    */
+    struct Options {
+        //! A public member variable.
+        /*!
+            NPTアンサンブルの圧力制御の方法
+        */
+        moleculardynamics::BarostatType barostat = moleculardynamics::BarostatType::BERENDSEN;
+
+        //! A public member variable.
+        /*!
+            最後に状態を保存するチェックポイントファイルの名前
+        */
+        boost::optional<std::string> checkpoint;
+
+        //! A public member variable.
+        /*!
+            アンサンブル
+        */
+        moleculardynamics::EnsembleType ensemble = moleculardynamics::EnsembleType::NVT;
+
+        //! A public member variable.
+        /*!
+            -h, --helpで使い方の表示を求められたならtrue
+        */
+        bool help = false;
+
+        //! A public member variable.
+        /*!
+            何ステップごとに物理量を出力するか
+        */
+        std::int32_t interval = 100;
+
+        //! A public member variable.
+        /*!
+            原子間力の計算に使うカーネル（指定されなければCPUIDにより選ぶ）
+        */
+        boost::optional<moleculardynamics::ForceKernelType> kernel;
+
+        //! A public member variable.
+        /*!
+            スーパーセルの大きさ
+        */
+        boost::optional<std::int32_t> Nc;
+
+        //! A public member variable.
+        /*!
+            圧力（atm）
+        */
+        boost::optional<double> pressure;
+
+        //! A public member variable.
+        /*!
+            原子間力の計算の精度
+        */
+        moleculardynamics::PrecisionType precision = moleculardynamics::PrecisionType::DOUBLE;
+
+        //! A public member variable.
+        /*!
+            原子の配列を並べ替える間隔（指定されなければ既定値）
+        */
+        boost::optional<std::int32_t> reorderinterval;
+
+        //! A public member variable.
+        /*!
+            続きから計算するチェックポイントファイルの名前
+        */
+        boost::optional<std::string> restart;
+
+        //! A public member variable.
+        /*!
+            格子定数のスケール
+        */
+        boost::optional<double> scale;
+
+        //! A public member variable.
+        /*!
+            MDのステップ数
+        */
+        std::int32_t steps = 1000;
+
+        //! A public member variable.
+        /*!
+            表による補間の区間の数（指定されなければ既定値）
+        */
+        boost::optional<std::int32_t> tablesize;
+
+        //! A public member variable.
+        /*!
+            温度（絶対温度）
+        */
+        boost::optional<double> temperature;
+
+        //! A public member variable.
+        /*!
+            NVTアンサンブルの温度制御の方法
+        */
+        moleculardynamics::ThermostatType thermostat = moleculardynamics::ThermostatType::WOODCOCK;
+
+        //! A public member variable.
+        /*!
+            使用するスレッド数（指定されなければTBBに任せる）
+        */
+        boost::optional<std::int32_t> threads;
+
+        //! A public member variable.
+        /*!
+            トラジェクトリファイルの名前（指定されなければ書き出さない）
+        */
+        boost::optional<std::string> trajectory;
+
+        //! A public member variable.
+        /*!
+            圧縮したトラジェクトリの量子化のビット数
+        */
+        std::int32_t trajectorybits = moleculardynamics::CompressedTrajectoryEncoder::FIRSTBITS;
+
+        //! A public member variable.
+        /*!
+            トラジェクトリに力も書き出すならtrue
+        */
+        bool trajectoryforce = false;
+
+        //! A public member variable.
+        /*!
+            トラジェクトリファイルの形式
+        */
+        moleculardynamics::TrajectoryFormat trajectoryformat = moleculardynamics::TrajectoryFormat::XYZ;
+
+        //! A public member variable.
+        /*!
+            何ステップごとにトラジェクトリのフレームを書き出すか
+        */
+        std::int32_t trajectoryinterval = 100;
+
+        //! A public member variable.
+        /*!
+            トラジェクトリのキューに積めるフレームの数
+        */
+        std::int32_t trajectoryqueue = moleculardynamics::TrajectoryWriter::FIRSTCAPACITY;
+
+        //! A public member variable.
+        /*!
+            トラジェクトリに速度も書き出すならtrue
+        */
+        bool trajectoryvelocity = false;
+    };
+
+    //! A global variable (constant).
+    /*!
+        原子間力の計算の精度の名前（PrecisionTypeの順）
+    */
+    char const * const PRECISIONNAME[] = { "double", "mixed" };
+
+    //! A global variable (constant).
+    /*!
+        原子間力の計算に使うカーネルの名前（ForceKernelTypeの順）
+    */
+    char const * const KERNELNAME[] = { "reference", "scalar", "avx2", "avx512", "table" };
+
+    //! A global variable (constant).
+    /*!
+        アンサンブルの名前（EnsembleTypeの順）
+    */
+    char const * const ENSEMBLENAME[] = { "NVE", "NVT", "NPT" };
+
+    //! A global variable (constant).
+    /*!
+        圧力制御の方法の名前（BarostatTypeの順）
+    */
+    char const * const BAROSTATNAME[] = { "berendsen", "mtk" };
+
+    //! A global variable (constant).
+    /*!
+        温度制御の方法の名前（ThermostatTypeの順）
+    */
+    char const * const THERMOSTATNAME[] = { "woodcock", "berendsen", "nosehoover", "langevin" };
+
+#ifdef LJMD_ENABLE_TIMERS
+    //! A function.
+    /*!
+        MDの各段階にかかった時間（1ステップあたり）を出力する
+        \param title 行の先頭に付ける説明
+        \param timings 各段階にかかった時間
+        \param func 1ステップあたりの時間を求める関数
+    */
+    template <typename Func>
+    void print_timings(char const * title, moleculardynamics::Timings const & timings, Func func)
+    {
+        using moleculardynamics::PhaseType;
+
+        std::cout << boost::format("# %s (ms/step): neighbor %.4f, force %.4f, integration %.4f, reduction %.4f\n")
+            % title
+            % (func(timings, PhaseType::NEIGHBOR) * 1.0E+3)
+            % (func(timings, PhaseType::FORCE) * 1.0E+3)
+            % (func(timings, PhaseType::INTEGRATION) * 1.0E+3)
+            % (func(timings, PhaseType::REDUCTION) * 1.0E+3);
+    }
+#endif
+
+    //! A function.
+    /*!
+        使い方を表示する
+        \param prog プログラム名
+    */
+    void usage(char const * prog);
+
+    //! A function.
+    /*!
+        コマンドライン引数を解析する
+        \param argc コマンドライン引数の数
+        \param argv コマンドライン引数
+        \param opts 解析した結果を格納する構造体
+        \return 解析に成功し、シミュレーションを実行すべきならtrue（使い方を表示したときはfalseで、opts.helpがtrue）
+    */
+    bool parse_options(int argc, char * argv[], Options & opts);
+}
+
+//! A function.
+/*!
+    メイン関数
+    \param argc コマンドライン引数の数
+    \param argv コマンドライン引数
+    \return 終了コード
+*/
+int main(int argc, char * argv[])
+{
+    Options opts;
+    if (!parse_options(argc, argv, opts)) {
+        return opts.help ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    std::unique_ptr<tbb::global_control> gc;
+    if (opts.threads) {
+        gc.reset(new tbb::global_control(tbb::global_control::max_allowed_parallelism, *opts.threads));
+    }
+
+    moleculardynamics::Ar_moleculardynamics armd;
+
+    // 原子の配置と速度は最後に呼ばれたsetNc()（recalc()）で初期化される
+    if (opts.temperature) {
+        armd.setTgiven(*opts.temperature);
+    }
+
+    if (opts.kernel) {
+        armd.setForceKernel(*opts.kernel);
+    }
+
+    if (opts.tablesize) {
+        armd.setTableSize(*opts.tablesize);
+    }
+
+    if (opts.reorderinterval) {
+        armd.setReorderInterval(*opts.reorderinterval);
+    }
+
+    armd.setPrecision(opts.precision);
+
+    armd.setEnsemble(opts.ensemble);
+    armd.setThermostat(opts.thermostat);
+    armd.setBarostat(opts.barostat);
+
+    // エネルギーとビリアルは出力するステップでだけ計算する
+    armd.setSampleInterval(opts.interval);
+
+    if (opts.pressure) {
+        armd.setPgiven(*opts.pressure);
+    }
+
+    if (opts.scale) {
+        armd.setScale(*opts.scale);
+    }
+
+    if (opts.restart) {
+        // 原子の配置、箱、アンサンブルと熱浴・ピストンの状態はファイルから読み込む
+        if (!armd.loadCheckpoint(*opts.restart)) {
+            std::cerr << boost::format("%s: cannot restart from '%s'\n") % argv[0] % *opts.restart;
+            return EXIT_FAILURE;
+        }
+
+        // 温度と圧力は指定されたときだけ変える
+        if (opts.temperature) {
+            armd.setTgiven(*opts.temperature);
+        }
+
+        if (opts.pressure) {
+            armd.setPgiven(*opts.pressure);
+        }
+    }
+    else {
+        armd.setNc(opts.Nc ? *opts.Nc : armd.Nc);
+    }
+
+    // 箱が小さすぎると最小イメージ規約が成り立たず、ペアリストも力も正しくない
+    if (armd.getPeriodiclen() <= 2.0 * (armd.getCutoff() + armd.getSkin())) {
+        std::cerr << boost::format("%s: the box (%g nm) must be longer than 2 (rc + skin) = %g nm; use a larger Nc\n")
+            % argv[0]
+            % armd.getPeriodiclen()
+            % (2.0 * (armd.getCutoff() + armd.getSkin()));
+        return EXIT_FAILURE;
+    }
+
+    std::cout << boost::format("# atoms: %d, Nc: %d, lattice constant: %.5f (nm), box length: %.5f (nm)\n")
+        % armd.NumAtom % armd.Nc % armd.getLatticeconst() % armd.getPeriodiclen();
+    std::cout << boost::format("# ensemble: %s, thermostat: %s, barostat: %s, given temperature: %.3f (K), given pressure: %.3f (atm), force kernel: %s, precision: %s\n")
+        % ENSEMBLENAME[static_cast<std::int32_t>(armd.getEnsemble())]
+        % (armd.getEnsemble() != moleculardynamics::EnsembleType::NVE ? THERMOSTATNAME[static_cast<std::int32_t>(armd.getThermostat())] : "none")
+        % (armd.getEnsemble() == moleculardynamics::EnsembleType::NPT ? BAROSTATNAME[static_cast<std::int32_t>(armd.getBarostat())] : "none")
+        % armd.getTgiven()
+        % armd.getPgiven()
+        % KERNELNAME[static_cast<std::int32_t>(armd.getForceKernel())]
+        % PRECISIONNAME[static_cast<std::int32_t>(armd.getPrecision())];
+    if (armd.getForceKernel() == moleculardynamics::ForceKernelType::TABLE) {
+        auto const acc = armd.getTableAccuracy();
+        std::cout << boost::format("# table size: %d, max relative force error: %.3e, max energy error: %.3e (epsilon)\n")
+            % armd.getTableSize() % acc.force % acc.energy;
+    }
+    std::cout << "# step  time(ps)  T(K)  P(atm)  L(nm)  Uk(Hartree)  Up(Hartree)  Utot(Hartree)  Ubath(Hartree)\n";
+
+    std::unique_ptr<moleculardynamics::TrajectoryWriter> trajectory;
+    if (opts.trajectory) {
+        trajectory.reset(new moleculardynamics::TrajectoryWriter(
+            *opts.trajectory,
+            opts.trajectoryformat,
+            opts.trajectoryinterval,
+            opts.trajectoryvelocity,
+            opts.trajectoryforce,
+            opts.trajectoryqueue,
+            opts.trajectorybits));
+        if (!trajectory->good()) {
+            std::cerr << boost::format("%s: cannot open the trajectory '%s'\n") % argv[0] % *opts.trajectory;
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto const begin = std::chrono::steady_clock::now();
+
+    for (auto i = 1; i <= opts.steps; i++) {
+        armd.calculate();
+
+        // フレームもループの回数ではなくMD_iterで選ぶ
+        // （--restartしても元の計算と同じステップのフレームになり、DCDのヘッダの開始ステップと間隔がフレームと合う）
+        if (trajectory && (armd.MD_iter - 1) % opts.trajectoryinterval == 0) {
+            trajectory->write(armd);
+        }
+
+        // calculate()はMD_iterが-iの倍数のステップでだけ物理量を求めるので、ループの回数ではなくMD_iterで判定する
+        // （--restartで-iの倍数でないステップから始めても、求めたばかりの値を出力する）
+        if ((armd.MD_iter - 1) % opts.interval == 0) {
+            std::cout << boost::format("%d %.6f %.6f %.6f %.6f %.10e %.10e %.10e %.10e\n")
+                % armd.MD_iter
+                % armd.getDeltat()
+                % armd.getTcalc()
+                % armd.getPressure()
+                % armd.getPeriodiclen()
+                % armd.Uk
+                % armd.Up
+                % armd.Utot
+                % (armd.getThermostatEnergy() + armd.getBarostatEnergy());
+#ifdef LJMD_ENABLE_TIMERS
+            print_timings("rolling", armd.getTimings(), [](moleculardynamics::Timings const & t, moleculardynamics::PhaseType p) { return t.rolling(p); });
+#endif
+        }
+    }
+
+    auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << boost::format("# elapsed: %.3f (s), %.4f (ms/step), %.2f (steps/s), pair list lifetime: %.2f (steps)\n")
+        % elapsed
+        % (elapsed * 1.0E+3 / static_cast<double>(opts.steps))
+        % (static_cast<double>(opts.steps) / elapsed)
+        % armd.getListLifetime();
+#ifdef LJMD_ENABLE_TIMERS
+    print_timings("average", armd.getTimings(), [](moleculardynamics::Timings const & t, moleculardynamics::PhaseType p) { return t.average(p); });
+#endif
+
+    if (trajectory) {
+        // 待たされた時間が長ければ、キューを大きくするか間隔を広げる
+        trajectory->close();
+        std::cout << boost::format("# trajectory: %d frames, stalled %d times, %.4f (s)\n")
+            % trajectory->getFrames() % trajectory->getStalls() % trajectory->getStallTime();
+        if (!trajectory->good()) {
+            std::cerr << boost::format("%s: cannot write the trajectory '%s'\n") % argv[0] % *opts.trajectory;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (opts.checkpoint && !armd.saveCheckpoint(*opts.checkpoint)) {
+        std::cerr << boost::format("%s: cannot write the checkpoint '%s'\n") % argv[0] % *opts.checkpoint;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+namespace {
+    void usage(char const * prog)
+    {
+        std::cerr << boost::format(
+            "Usage: %s [options]\n"
+            "  -n, --nc N            size of the supercell (number of atoms = 4 N^3)\n"
+            "  -s, --scale X         scale of the lattice constant\n"
+            "  -t, --temperature T   given temperature (K)\n"
+            "  -p, --pressure P      given pressure (atm)\n"
+            "  -e, --ensemble E      nve, nvt or npt (default: nvt)\n"
+            "  -T, --thermostat X    woodcock, berendsen, nosehoover or langevin (default: woodcock)\n"
+            "  -b, --barostat X      berendsen or mtk (default: berendsen)\n"
+            "  -N, --steps N         number of MD steps (default: 1000)\n"
+            "  -i, --interval N      sample and output every N steps (default: 100)\n"
+            "  -k, --kernel K        reference, scalar, avx2, avx512 or table (default: best for the CPU)\n"
+            "  -P, --precision X     double or mixed (default: double)\n"
+            "  --table-size N        number of intervals of the table kernel (default: 1024)\n"
+            "  --reorder-interval N  sort the atoms in Morton order every N list rebuilds, 0 to disable (default: 10)\n"
+            "  --restart FILE        continue from a checkpoint; the atoms, box, ensemble and baths come from the file\n"
+            "  --checkpoint FILE     save the final state to a checkpoint\n"
+            "  --trajectory FILE     write a trajectory on a background thread\n"
+            "  --trajectory-format X xyz, dcd, raw or compressed (default: xyz)\n"
+            "  --trajectory-bits N   quantization bits of the compressed trajectory, 8 to 30 (default: 16)\n"
+            "  --trajectory-interval N  write a frame every N steps (default: 100)\n"
+            "  --trajectory-fields X comma separated list of positions, velocities and forces (default: positions)\n"
+            "  --trajectory-queue N  number of frames the writer can fall behind before the MD waits (default: 4)\n"
+            "  -j, --threads N       number of worker threads (default: all)\n"
+            "  -h, --help            show this message\n") % prog;
+    }
+
+    bool parse_options(int argc, char * argv[], Options & opts)
+    {
+        try {
+            for (auto i = 1; i < argc; i++) {
+                std::string const arg(argv[i]);
+
+                if (arg == "-h" || arg == "--help") {
+                    opts.help = true;
+                    usage(argv[0]);
+                    return false;
+                }
+
+                if (i + 1 >= argc) {
+                    std::cerr << boost::format("%s: missing value for %s\n") % argv[0] % arg;
+                    return false;
+                }
+
+                std::string const val(argv[++i]);
+
+                if (arg == "-n" || arg == "--nc") {
+                    opts.Nc = boost::lexical_cast<std::int32_t>(val);
+                }
+                else if (arg == "-s" || arg == "--scale") {
+                    opts.scale = boost::lexical_cast<double>(val);
+                }
+                else if (arg == "-t" || arg == "--temperature") {
+                    opts.temperature = boost::lexical_cast<double>(val);
+                }
+                else if (arg == "-p" || arg == "--pressure") {
+                    opts.pressure = boost::lexical_cast<double>(val);
+                }
+                else if (arg == "-e" || arg == "--ensemble") {
+                    if (val == "nve" || val == "NVE") {
+                        opts.ensemble = moleculardynamics::EnsembleType::NVE;
+                    }
+                    else if (val == "nvt" || val == "NVT") {
+                        opts.ensemble = moleculardynamics::EnsembleType::NVT;
+                    }
+                    else if (val == "npt" || val == "NPT") {
+                        opts.ensemble = moleculardynamics::EnsembleType::NPT;
+                    }
+                    else {
+                        std::cerr << boost::format("%s: unknown ensemble '%s'\n") % argv[0] % val;
+                        return false;
+                    }
+                }
+                else if (arg == "-T" || arg == "--thermostat") {
+                    if (val == "woodcock") {
+                        opts.thermostat = moleculardynamics::ThermostatType::WOODCOCK;
+                    }
+                    else if (val == "berendsen") {
+                        opts.thermostat = moleculardynamics::ThermostatType::BERENDSEN;
+                    }
+                    else if (val == "nosehoover") {
+                        opts.thermostat = moleculardynamics::ThermostatType::NOSEHOOVER;
+                    }
+                    else if (val == "langevin") {
+                        opts.thermostat = moleculardynamics::ThermostatType::LANGEVIN;
+                    }
+                    else {
+                        std::cerr << boost::format("%s: unknown thermostat '%s'\n") % argv[0] % val;
+                        return false;
+                    }
+                }
+                else if (arg == "-b" || arg == "--barostat") {
+                    if (val == "berendsen") {
+                        opts.barostat = moleculardynamics::BarostatType::BERENDSEN;
+                    }
+                    else if (val == "mtk") {
+                        opts.barostat = moleculardynamics::BarostatType::MTK;
+                    }
+                    else {
+                        std::cerr << boost::format("%s: unknown barostat '%s'\n") % argv[0] % val;
+                        return false;
+                    }
+                }
+                else if (arg == "-N" || arg == "--steps") {
+                    opts.steps = boost::lexical_cast<std::int32_t>(val);
+                }
+                else if (arg == "-i" || arg == "--interval") {
+                    opts.interval = boost::lexical_cast<std::int32_t>(val);
+                }
+                else if (arg == "-k" || arg == "--kernel") {
+                    if (val == "reference") {
+                        opts.kernel = moleculardynamics::ForceKernelType::REFERENCE;
+                    }
+                    else if (val == "scalar") {
+                        opts.kernel = moleculardynamics::ForceKernelType::SCALAR;
+                    }
+                    else if (val == "avx2") {
+                        opts.kernel = moleculardynamics::ForceKernelType::AVX2;
+                    }
+                    else if (val == "avx512") {
+                        opts.kernel = moleculardynamics::ForceKernelType::AVX512;
+                    }
+                    else if (val == "table") {
+                        opts.kernel = moleculardynamics::ForceKernelType::TABLE;
+                    }
+                    else {
+                        std::cerr << boost::format("%s: unknown kernel '%s'\n") % argv[0] % val;
+                        return false;
+                    }
+                }
+                else if (arg == "-P" || arg == "--precision") {
+                    if (val == "double") {
+                        opts.precision = moleculardynamics::PrecisionType::DOUBLE;
+                    }
+                    else if (val == "mixed") {
+                        opts.precision = moleculardynamics::PrecisionType::MIXED;
+                    }
+                    else {
+                        std::cerr << boost::format("%s: unknown precision '%s'\n") % argv[0] % val;
+                        return false;
+                    }
+                }
+                else if (arg == "--table-size") {
+                    opts.tablesize = boost::lexical_cast<std::int32_t>(val);
+                }
+                else if (arg == "--reorder-interval") {
+                    opts.reorderinterval = boost::lexical_cast<std::int32_t>(val);
+                }
+                else if (arg == "--restart") {
+                    opts.restart = val;
+                }
+                else if (arg == "--checkpoint") {
+                    opts.checkpoint = val;
+                }
+                else if (arg == "--trajectory") {
+                    opts.trajectory = val;
+                }
+                else if (arg == "--trajectory-format") {
+                    if (val == "xyz") {
+                        opts.trajectoryformat = moleculardynamics::TrajectoryFormat::XYZ;
+                    }
+                    else if (val == "dcd") {
+                        opts.trajectoryformat = moleculardynamics::TrajectoryFormat::DCD;
+                    }
+                    else if (val == "raw") {
+                        opts.trajectoryformat = moleculardynamics::TrajectoryFormat::RAW;
+                    }
+                    else if (val == "compressed") {
+                        opts.trajectoryformat = moleculardynamics::TrajectoryFormat::COMPRESSED;
+                    }
+                    else {
+                        std::cerr << boost::format("%s: unknown trajectory format '%s'\n") % argv[0] % val;
+                        return false;
+                    }
+                }
+                else if (arg == "--trajectory-bits") {
+                    opts.trajectorybits = boost::lexical_cast<std::int32_t>(val);
+                }
+                else if (arg == "--trajectory-interval") {
+                    opts.trajectoryinterval = boost::lexical_cast<std::int32_t>(val);
+                }
+                else if (arg == "--trajectory-fields") {
+                    std::vector<std::string> fields;
+                    boost::algorithm::split(fields, val, [](char c) { return c == ','; });
+
+                    opts.trajectoryvelocity = false;
+                    opts.trajectoryforce = false;
+                    for (auto const & field : fields) {
+                        if (field == "velocities") {
+                            opts.trajectoryvelocity = true;
+                        }
+                        else if (field == "forces") {
+                            opts.trajectoryforce = true;
+                        }
+                        else if (field != "positions") {
+                            std::cerr << boost::format("%s: unknown trajectory field '%s'\n") % argv[0] % field;
+                            return false;
+                        }
+                    }
+                }
+                else if (arg == "--trajectory-queue") {
+                    opts.trajectoryqueue = boost::lexical_cast<std::int32_t>(val);
+                }
+                else if (arg == "-j" || arg == "--threads") {
+                    opts.threads = boost::lexical_cast<std::int32_t>(val);
+                }
+                else {
+                    std::cerr << boost::format("%s: unknown option '%s'\n") % argv[0] % arg;
+                    usage(argv[0]);
+                    return false;
+                }
+            }
+        }
+        catch (boost::bad_lexical_cast const &) {
+            std::cerr << boost::format("%s: invalid numeric value\n") % argv[0];
+            return false;
+        }
+
+        if ((opts.Nc && *opts.Nc <= 0) || opts.steps <= 0 || opts.interval <= 0 || (opts.threads && *opts.threads <= 0) || (opts.tablesize && *opts.tablesize <= 0)) {
+            std::cerr << boost::format("%s: Nc, steps, interval, threads and table size must be positive\n") % argv[0];
+            return false;
+        }
+
+        if (opts.trajectoryinterval <= 0 || opts.trajectoryqueue <= 0) {
+            std::cerr << boost::format("%s: trajectory interval and queue must be positive\n") % argv[0];
+            return false;
+        }
+
+        if (opts.trajectoryformat == moleculardynamics::TrajectoryFormat::DCD && (opts.trajectoryvelocity || opts.trajectoryforce)) {
+            std::cerr << boost::format("%s: the dcd trajectory holds positions only\n") % argv[0];
+            return false;
+        }
+
+        if (opts.trajectoryformat == moleculardynamics::TrajectoryFormat::COMPRESSED && (opts.trajectoryvelocity || opts.trajectoryforce)) {
+            std::cerr << boost::format("%s: the compressed trajectory holds positions only\n") % argv[0];
+            return false;
+        }
+
+        if (opts.trajectorybits < moleculardynamics::CompressedTrajectoryEncoder::MINBITS || opts.trajectorybits > moleculardynamics::CompressedTrajectoryEncoder::MAXBITS) {
+            std::cerr << boost::format("%s: trajectory bits must be between %d and %d\n")
+                % argv[0]
+                % static_cast<std::int32_t>(moleculardynamics::CompressedTrajectoryEncoder::MINBITS)
+                % static_cast<std::int32_t>(moleculardynamics::CompressedTrajectoryEncoder::MAXBITS);
+            return false;
+        }
+
+        if (opts.reorderinterval && *opts.reorderinterval < 0) {
+            std::cerr << boost::format("%s: reorder interval must not be negative\n") % argv[0];
+            return false;
+        }
+
+        return true;
+    }
+}
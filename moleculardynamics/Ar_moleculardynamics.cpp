@@ -1,531 +1,1333 @@
-﻿/*! \file Ar_moleculardynamics.h
-    \brief アルゴンに対して、分子動力学シミュレーションを行うクラスの実装
-
-    Copyright ©  2015 @dc1394 All Rights Reserved.
-    This software is released under the BSD 2-Clause License.
-*/
-
-#include "DXUT.h"
-#include "Ar_moleculardynamics.h"
-#include "../myrandom/myrand.h"
-#include <cmath>                    // for std::sqrt, std::pow
-#include <boost/assert.hpp>         // for BOOST_ASSERT
-#include <tbb/combinable.h>         // for tbb::combinable
-#include <tbb/parallel_for.h>       // for tbb::parallel_for
-
-namespace moleculardynamics {
-    // #region static private 定数
-
-    double const Ar_moleculardynamics::FIRSTSCALE = 1.0;
-
-    double const Ar_moleculardynamics::FIRSTTEMP = 50.0;
-
-    double const Ar_moleculardynamics::SIGMA = 3.405E-10;
-
-    double const Ar_moleculardynamics::VDW_RADIUS = 1.88E-10;
-
-    double const Ar_moleculardynamics::ALPHA = 0.2;
-
-    double const Ar_moleculardynamics::ATM = 9.86923266716013E-6;
-
-    double const Ar_moleculardynamics::AVOGADRO_CONSTANT = 6.022140857E+23;
-
-    double const Ar_moleculardynamics::DT = 0.001;
-
-    double const Ar_moleculardynamics::HARTREE = 4.35974465054E-18;
-
-    double const Ar_moleculardynamics::KB = 1.3806488E-23;
-
-    double const Ar_moleculardynamics::TAU =
-        std::sqrt(0.039948 / Ar_moleculardynamics::AVOGADRO_CONSTANT * Ar_moleculardynamics::SIGMA * Ar_moleculardynamics::SIGMA / Ar_moleculardynamics::YPSILON);
-
-    double const Ar_moleculardynamics::YPSILON = 1.6540172624E-21;
-
-    // #endregion static private 定数
-
-    // #region コンストラクタ
-
-    Ar_moleculardynamics::Ar_moleculardynamics()
-        :
-        atoms([this] { return std::cref(atoms_); }, nullptr),
-        MD_iter([this] { return MD_iter_; }, nullptr),
-        Nc([this] { return Nc_; }, nullptr),
-        NumAtom([this] { return NumAtom_; }, nullptr),
-        periodiclen([this] { return periodiclen_; }, nullptr),
-        Uk([this] { return DimensionlessToHartree(Uk_); }, nullptr),
-        Up([this] { return DimensionlessToHartree(Up_); }, nullptr),
-        Utot([this] { return DimensionlessToHartree(Utot_); }, nullptr),
-        atoms_(Nc_ * Nc_ * Nc_ * 4),
-        dt2(DT * DT),
-        rc2_(rc_ * rc_),
-        rcm6_(std::pow(rc_, -6.0)),
-        rcm12_(std::pow(rc_, -12.0)),
-        Tg_(Ar_moleculardynamics::FIRSTTEMP * Ar_moleculardynamics::KB / Ar_moleculardynamics::YPSILON),
-        Vrc_(4.0 * (rcm12_ - rcm6_))
-    {
-        // initalize parameters
-        lat_ = std::pow(2.0, 2.0 / 3.0) * scale_;
-
-        recalc();
-
-        periodiclen_ = lat_ * static_cast<double>(Nc_);
-    }
-
-    // #endregion コンストラクタ
-
-    // #region publicメンバ関数
-
-    void Ar_moleculardynamics::calculate()
-    {
-        update_position();
-        make_pair();
-        calculate_force_pair();
-        update_position();
-        
-        // 運動エネルギーの初期化
-        Uk_ = 0.0;
-
-        // calculate temperture
-        for (auto n = 0; n < NumAtom_; n++) {
-            Uk_ += atoms_[n].v.squaredNorm();
-        }
-
-        // 運動エネルギーの計算
-        Uk_ *= 0.5;
-
-        // 全エネルギー（運動エネルギー+ポテンシャルエネルギー）の計算
-        Utot_ = Uk_ + Up_;
-
-        // 温度の計算
-        Tc_ = Uk_ / (1.5 * static_cast<double>(NumAtom_));
-
-        update_position();
-        periodic();
-        
-        // 繰り返し回数と時間を増加
-        t_ = static_cast<double>(MD_iter_)* Ar_moleculardynamics::DT;
-        MD_iter_++;
-
-    }
-
-    void Ar_moleculardynamics::calculate_force_pair()
-    {
-        // ポテンシャルエネルギーの初期化
-        Up_ = 0.0;
-        virial_ = 0.0;
-
-        //tbb::combinable<double> Up;
-        //tbb::combinable<double> virial;
-
-        for (auto && a : atoms_) {
-            a.f = Eigen::Vector4d::Zero();
-        }
-
-        auto const pp = atom_pairs_.size();
-        for (auto k = 0; k < pp; k++) {
-            auto const i = atom_pairs_[k].first;
-            auto const j = atom_pairs_[k].second;
-            auto const dv = adjust_periodic(atoms_[j].r - atoms_[i].r);
-            auto const r2 = dv.squaredNorm();
-
-            if (r2 > rc2_) {
-                continue;
-            }
-
-            auto const r = std::sqrt(r2);
-            auto const r6 = r2 * r2 * r2;
-            auto const rm6 = 1.0 / r6;
-            auto const rm7 = rm6 / r;
-            auto const rm12 = rm6 * rm6;
-            auto const rm13 = rm12 / r;
-
-            auto const Fr = 48.0 * rm13 - 24.0 * rm7;
-            auto const df = (24.0 * r6 - 48.0) * rm12 / r2 * Ar_moleculardynamics::DT;
-            Up_ += 0.5 * (4.0 * (rm12 - rm6) - Vrc_);
-            virial_ += 0.5 * r * Fr;
-
-            atoms_[i].p += df * dv;
-            atoms_[j].p -= df * dv;
-            atoms_[i].f += dv / r * Fr;
-            atoms_[j].f -= dv / r * Fr;
-        }
-
-        //tbb::parallel_for(
-        //    tbb::blocked_range<std::int32_t>(0, NumAtom_),
-        //    [this, &Up, &virial](tbb::blocked_range<std::int32_t> const & range) {
-        //    for (auto && n = range.begin(); n != range.end(); ++n) {
-        //        for (auto m = 0; m < NumAtom_; m++) {
-
-        //            // ±ncp_分のセル内の原子との相互作用を計算
-        //            for (auto i = -ncp_; i <= ncp_; i++) {
-        //                for (auto j = -ncp_; j <= ncp_; j++) {
-        //                    for (auto k = -ncp_; k <= ncp_; k++) {
-        //                        auto const sx = static_cast<double>(i) * periodiclen_;
-        //                        auto const sy = static_cast<double>(j) * periodiclen_;
-        //                        auto const sz = static_cast<double>(k) * periodiclen_;
-
-        //                        // 自分自身との相互作用を排除
-        //                        if (n != m || i != 0 || j != 0 || k != 0) {
-        //                            auto const dx = atoms_[n].r[0] - (atoms_[m].r[0] + sx);
-        //                            auto const dy = atoms_[n].r[1] - (atoms_[m].r[1] + sy);
-        //                            auto const dz = atoms_[n].r[2] - (atoms_[m].r[2] + sz);
-
-        //                            Eigen::Vector3d r2vec(dx, dy, dz);
-        //                            auto const r2 = r2vec.squaredNorm();
-        //                            // 打ち切り距離内であれば計算
-        //                            if (r2 <= rc2_) {
-        //                                auto const r = std::sqrt(r2);
-        //                                auto const rm6 = 1.0 / (r2 * r2 * r2);
-        //                                auto const rm7 = rm6 / r;
-        //                                auto const rm12 = rm6 * rm6;
-        //                                auto const rm13 = rm12 / r;
-
-        //                                auto const Fr = 48.0 * rm13 - 24.0 * rm7;
-
-        //                                atoms_[n].f += Eigen::Vector4d(dx / r * Fr, dy / r * Fr, dz / r * Fr, 0.0);
-
-        //                                // エネルギーの計算、ただし二重計算のために0.5をかけておく
-        //                                Up.local() += 0.5 * (4.0 * (rm12 - rm6) - Vrc_);
-        //                                virial.local() += 0.5 * r * Fr;
-        //                            }
-        //                        }
-        //                    }
-        //                }
-        //            }
-        //        }
-        //    }
-        //});
-
-        //Up_ = Up.combine(std::plus<double>());
-        //virial_ = virial.combine(std::plus<double>());
-    }
-    
-    double Ar_moleculardynamics::getDeltat() const
-    {
-        return Ar_moleculardynamics::TAU * t_ * 1.0E+12;
-    }
-
-    float Ar_moleculardynamics::getForce(std::int32_t n) const
-    {
-        return static_cast<float>(atoms_[n].f.norm());
-    }
-
-    double Ar_moleculardynamics::getLatticeconst() const
-    {
-        return Ar_moleculardynamics::SIGMA * lat_ * 1.0E+9;
-    }
-    
-    double Ar_moleculardynamics::getPeriodiclen() const
-    {
-        return Ar_moleculardynamics::SIGMA * periodiclen_ * 1.0E+9;
-    }
-
-    double Ar_moleculardynamics::getPressure() const
-    {
-        auto const V = std::pow(Ar_moleculardynamics::SIGMA * periodiclen_, 3);
-        auto const ideal = NumAtom * Ar_moleculardynamics::YPSILON * Tc_;
-
-        return (ideal - virial_ * Ar_moleculardynamics::YPSILON / 3.0) / V * Ar_moleculardynamics::ATM;
-    }
-
-    double Ar_moleculardynamics::getTcalc() const
-    {
-        return Ar_moleculardynamics::YPSILON / Ar_moleculardynamics::KB * Tc_;
-    }
-
-    double Ar_moleculardynamics::getTgiven() const
-    {
-        return Ar_moleculardynamics::YPSILON / Ar_moleculardynamics::KB * Tg_;
-    }
-    
-    void Ar_moleculardynamics::make_pair()
-    {
-        atom_pairs_.clear();
-        for (auto i = 0; i < NumAtom_ - 1; i++) {
-            for (auto j = i + 1; j < NumAtom_; j++) {
-                auto const dv = adjust_periodic(atoms_[j].r - atoms_[i].r);
-                auto const r2 = dv.squaredNorm();
-
-                if (r2 > rc2_) {
-                    continue;
-                }
-                atom_pairs_.push_back(std::make_pair(i, j));
-            }
-        }
-    }
-
-    void Ar_moleculardynamics::Move_Atoms()
-    {
-
-
-        //auto const s = std::sqrt((Tg_ + Ar_moleculardynamics::ALPHA * (Tc_ - Tg_)) / Tc_);
-
-        //switch (MD_iter_) {
-        //case 1:
-        //    // update the coordinates by the second order Euler method
-        //    // 最初のステップだけ修正Euler法で時間発展
-        //    tbb::parallel_for(
-        //        tbb::blocked_range<std::int32_t>(0, NumAtom_),
-        //        [this, s](tbb::blocked_range<std::int32_t> const & range) {
-        //        for (auto && n = range.begin(); n != range.end(); ++n) {
-        //            atoms_[n].r1 = atoms_[n].r;
-        //            
-        //            // scaling of velocity
-        //            atoms_[n].v *= s;
-
-        //            // update coordinates and velocity
-        //            atoms_[n].r += Ar_moleculardynamics::DT * atoms_[n].v + 0.5 * atoms_[n].f * dt2;
-
-        //            atoms_[n].v += Ar_moleculardynamics::DT * atoms_[n].f;
-        //        }
-        //    });
-        //    break;
-
-        //default:
-
-        //    // update the coordinates by the Verlet method
-        //    tbb::parallel_for(
-        //        tbb::blocked_range<std::int32_t>(0, NumAtom_),
-        //        [this, s](tbb::blocked_range<std::int32_t> const & range) {
-        //            for (auto && n = range.begin(); n != range.end(); ++n) {
-        //                auto const rtmp = atoms_[n].r;
-
-        //                switch (ensemble_) {
-        //                case EnsembleType::NVE:
-        //                    atoms_[n].r = 2.0 * atoms_[n].r - atoms_[n].r1 + atoms_[n].f * dt2;
-        //                    break;
-
-        //                case EnsembleType::NVT:
-        //                    // update coordinates and velocity
-        //                    // Verlet法の座標更新式において速度成分を抜き出し、その部分をスケールする
-        //                    atoms_[n].r += s * (atoms_[n].r - atoms_[n].r1) + atoms_[n].f * dt2;
-        //                    break;
-
-        //                default:
-        //                    BOOST_ASSERT(!"何かがおかしい！");
-        //                }
-
-        //                atoms_[n].v = 0.5 * (atoms_[n].r - atoms_[n].r1) / Ar_moleculardynamics::DT;
-
-        //                atoms_[n].r1 = rtmp;
-        //            }
-        //    });
-        //    break;
-        //}
-    }
-
-    void Ar_moleculardynamics::recalc()
-    {
-        t_ = 0.0;
-        MD_iter_ = 1;
-
-        MD_initPos();
-        MD_initVel();
-    }
-
-    void Ar_moleculardynamics::update_position()
-    {
-        for (auto && a : atoms_) {
-            a.r += a.p * dt2;
-        }
-    }
-
-    void Ar_moleculardynamics::setEnsemble(EnsembleType ensemble)
-    {
-        ensemble_ = ensemble;
-        recalc();
-    }
-
-    void Ar_moleculardynamics::setNc(std::int32_t Nc)
-    {
-        Nc_ = Nc;
-        atoms_.resize(Nc_ * Nc_ * Nc_ * 4);
-
-        ModLattice();
-    }
-
-    void Ar_moleculardynamics::setScale(double scale)
-    {
-        scale_ = scale;
-        ModLattice();
-    }
-
-    void Ar_moleculardynamics::setTgiven(double Tgiven)
-    {
-        Tg_ = Tgiven * Ar_moleculardynamics::KB / Ar_moleculardynamics::YPSILON;
-    }
-
-    // #endregion publicメンバ関数
-
-    // #region privateメンバ関数
-
-    Eigen::Vector4d Ar_moleculardynamics::adjust_periodic(Eigen::Vector4d const & dv)
-    {
-        auto dvtmp = dv;
-        auto const lh = periodiclen_ * 0.5;
-        if (dv[0] < -lh) {
-            dvtmp[0] += periodiclen_;
-        }
-        
-        if (dv[0] > lh) {
-            dvtmp[0] -= periodiclen_;
-        }
-        
-        if (dv[1] < -lh) {
-            dvtmp[1] += periodiclen_;
-        }
-
-        if (dv[1] > lh) {
-            dvtmp[1] -= periodiclen_;
-        }
-
-        if (dv[2] < -lh) {
-            dvtmp[2] += periodiclen_;
-        }
-
-        if (dv[2] > lh) {
-            dvtmp[2] -= periodiclen_;
-        }
-
-        return dvtmp;
-    }
-
-    double Ar_moleculardynamics::DimensionlessToHartree(double e) const
-    {
-        return e * Ar_moleculardynamics::YPSILON / Ar_moleculardynamics::HARTREE;
-    }
-
-    void Ar_moleculardynamics::MD_initPos()
-    {
-        double sx, sy, sz;
-        auto n = 0;
-
-        for (auto i = 0; i < Nc_; i++) {
-            for (auto j = 0; j < Nc_; j++) {
-                for (auto k = 0; k < Nc_; k++) {
-                    // 基本セルをコピーする
-                    sx = static_cast<double>(i) * lat_;
-                    sy = static_cast<double>(j) * lat_;
-                    sz = static_cast<double>(k) * lat_;
-
-                    // 基本セル内には4つの原子がある
-                    atoms_[n].r = Eigen::Vector4d(sx, sy, sz, 0.0);
-                    n++;
-
-                    atoms_[n].r = Eigen::Vector4d(0.5 * lat_ + sx, 0.5 * lat_ + sy, sz, 0.0);
-                    n++;
-
-                    atoms_[n].r = Eigen::Vector4d(sx, 0.5 * lat_ + sy, 0.5 * lat_ + sz, 0.0);
-                    n++;
-
-                    atoms_[n].r = Eigen::Vector4d(0.5 * lat_ + sx, sy, 0.5 * lat_ + sz, 0.0);
-                    n++;
-                }
-            }
-        }
-
-        NumAtom_ = n;
-
-        // move the center of mass to the origin
-        // 系の重心を座標系の原点とする
-        sx = 0.0;
-        sy = 0.0;
-        sz = 0.0;
-
-        for (auto n = 0; n < NumAtom_; n++) {
-            sx += atoms_[n].r[0];
-            sy += atoms_[n].r[1];
-            sz += atoms_[n].r[2];
-        }
-
-        sx /= static_cast<double>(NumAtom_);
-        sy /= static_cast<double>(NumAtom_);
-        sz /= static_cast<double>(NumAtom_);
-
-        for (auto n = 0; n < NumAtom_; n++) {
-            atoms_[n].r -= Eigen::Vector4d(sx, sy, sz, 0.0);
-        }
-    }
-
-    void Ar_moleculardynamics::MD_initVel()
-    {
-        auto const v = std::sqrt(3.0 * Tg_);
-
-        myrandom::MyRand mr(-1.0, 1.0);
-
-        for (auto n = 0; n < NumAtom_; n++) {
-            auto rnd = Eigen::Vector4d(mr.myrand(), mr.myrand(), mr.myrand(), 0.0);
-            auto const tmp = 1.0 / rnd.norm();
-            rnd *= tmp;
-
-            // 方向はランダムに与える
-            atoms_[n].v = v * rnd;
-            atoms_[n].p = v * rnd;
-        }
-
-        auto sx = 0.0;
-        auto sy = 0.0;
-        auto sz = 0.0;
-
-        for (auto n = 0; n < NumAtom_; n++) {
-            sx += atoms_[n].v[0];
-            sy += atoms_[n].v[1];
-            sz += atoms_[n].v[2];
-        }
-
-        sx /= static_cast<double>(NumAtom_);
-        sy /= static_cast<double>(NumAtom_);
-        sz /= static_cast<double>(NumAtom_);
-
-        // 重心の並進運動を避けるために、速度の和がゼロになるように補正
-        for (auto n = 0; n < NumAtom_; n++) {
-            atoms_[n].v -= Eigen::Vector4d(sx, sy, sz, 0.0);
-            atoms_[n].p -= Eigen::Vector4d(sx, sy, sz, 0.0);
-        }
-    }
-
-    void Ar_moleculardynamics::ModLattice()
-    {
-        lat_ = std::pow(2.0, 2.0 / 3.0) * scale_;
-        recalc();
-        periodiclen_ = lat_ * static_cast<double>(Nc_);
-    }
-
-    void Ar_moleculardynamics::periodic()
-    {
-        // consider the periodic boundary condination
-        // セルの外側に出たら座標をセル内に戻す
-        tbb::parallel_for(
-            tbb::blocked_range<std::int32_t>(0, NumAtom_),
-            [this](tbb::blocked_range<std::int32_t> const & range) {
-            for (auto && n = range.begin(); n != range.end(); ++n) {
-                if (atoms_[n].r[0] > periodiclen_) {
-                    atoms_[n].r[0] -= periodiclen_;
-                    //atoms_[n].r1[0] -= periodiclen_;
-                }
-                else if (atoms_[n].r[0] < 0.0) {
-                    atoms_[n].r[0] += periodiclen_;
-                    //atoms_[n].r1[0] += periodiclen_;
-                }
-                if (atoms_[n].r[1] > periodiclen_) {
-                    atoms_[n].r[1] -= periodiclen_;
-                    //atoms_[n].r1[1] -= periodiclen_;
-                }
-                else if (atoms_[n].r[1] < 0.0) {
-                    atoms_[n].r[1] += periodiclen_;
-                    //atoms_[n].r1[1] += periodiclen_;
-                }
-                if (atoms_[n].r[2] > periodiclen_) {
-                    atoms_[n].r[2] -= periodiclen_;
-                    //atoms_[n].r1[2] -= periodiclen_;
-                }
-                else if (atoms_[n].r[2] < 0.0) {
-                    atoms_[n].r[2] += periodiclen_;
-                    //atoms_[n].r1[2] += periodiclen_;
-                }
-            }
-        });
-    }
-
-    // #endregion privateメンバ関数
-}
+﻿/*! \file Ar_moleculardynamics.h
+    \brief アルゴンに対して、分子動力学シミュレーションを行うクラスの実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "Ar_moleculardynamics.h"
+#include "checkpoint.h"
+#include "periodic.h"
+#include "renderframe.h"
+#include "trajectory.h"
+#include "../myrandom/myrand.h"
+#include <algorithm>                // for std::fill, std::max, std::min, std::sort
+#include <array>                    // for std::array
+#include <cmath>                    // for std::sqrt, std::pow
+#include <cstring>                  // for std::memcpy
+#include <fstream>                  // for std::filebuf
+#include <functional>               // for std::plus
+#include <numeric>                  // for std::iota
+#include <boost/assert.hpp>                     // for BOOST_ASSERT
+#include <boost/interprocess/file_mapping.hpp>  // for boost::interprocess::file_mapping
+#include <boost/interprocess/mapped_region.hpp> // for boost::interprocess::mapped_region
+#include <tbb/combinable.h>         // for tbb::combinable
+#include <tbb/parallel_for.h>       // for tbb::parallel_for
+#include <tbb/parallel_sort.h>      // for tbb::parallel_sort
+#include <tbb/task_arena.h>         // for tbb::this_task_arena::max_concurrency
+
+namespace moleculardynamics {
+    // #region static private 定数
+
+    double const Ar_moleculardynamics::FIRSTPRESSURE = 1.0;
+
+    double const Ar_moleculardynamics::FIRSTSCALE = 1.0;
+
+    double const Ar_moleculardynamics::FIRSTTEMP = 50.0;
+
+    double const Ar_moleculardynamics::FIRSTSKIN = 0.3;
+
+    double const Ar_moleculardynamics::SIGMA = 3.405E-10;
+
+    double const Ar_moleculardynamics::VDW_RADIUS = 1.88E-10;
+
+    double const Ar_moleculardynamics::ATM = 9.86923266716013E-6;
+
+    double const Ar_moleculardynamics::AVOGADRO_CONSTANT = 6.022140857E+23;
+
+    double const Ar_moleculardynamics::DT = 0.001;
+
+    double const Ar_moleculardynamics::HARTREE = 4.35974465054E-18;
+
+    double const Ar_moleculardynamics::KB = 1.3806488E-23;
+
+    double const Ar_moleculardynamics::TAU =
+        std::sqrt(0.039948 / Ar_moleculardynamics::AVOGADRO_CONSTANT * Ar_moleculardynamics::SIGMA * Ar_moleculardynamics::SIGMA / Ar_moleculardynamics::YPSILON);
+
+    double const Ar_moleculardynamics::YPSILON = 1.6540172624E-21;
+
+    // #endregion static private 定数
+
+    // #region コンストラクタ
+
+    Ar_moleculardynamics::Ar_moleculardynamics()
+        :
+        atoms([this] { return std::cref(atoms_); }, nullptr),
+        MD_iter([this] { return MD_iter_; }, nullptr),
+        Nc([this] { return Nc_; }, nullptr),
+        NumAtom([this] { return NumAtom_; }, nullptr),
+        NumRebuild([this] { return nrebuild_; }, nullptr),
+        periodiclen([this] { return periodiclen_; }, nullptr),
+        Uk([this] { return DimensionlessToHartree(Uk_); }, nullptr),
+        Up([this] { return DimensionlessToHartree(Up_); }, nullptr),
+        Utot([this] { return DimensionlessToHartree(Utot_); }, nullptr),
+        atoms_(Nc_ * Nc_ * Nc_ * 4),
+        Pg_(Ar_moleculardynamics::FIRSTPRESSURE / Ar_moleculardynamics::ATM * std::pow(Ar_moleculardynamics::SIGMA, 3) / Ar_moleculardynamics::YPSILON),
+        rc2_(rc_ * rc_),
+        rcm6_(std::pow(rc_, -6.0)),
+        rcm12_(std::pow(rc_, -12.0)),
+        Tg_(Ar_moleculardynamics::FIRSTTEMP * Ar_moleculardynamics::KB / Ar_moleculardynamics::YPSILON),
+        Vrc_(4.0 * (rcm12_ - rcm6_))
+    {
+        // initalize parameters
+        lat_ = std::pow(2.0, 2.0 / 3.0) * scale_;
+
+        ljtable_.build(LJTable::FIRSTSIZE, rc2_, Vrc_);
+
+        recalc();
+
+        periodiclen_ = lat_ * static_cast<double>(Nc_);
+        invperiodiclen_ = 1.0 / periodiclen_;
+    }
+
+    // #endregion コンストラクタ
+
+    // #region publicメンバ関数
+
+    void Ar_moleculardynamics::calculate()
+    {
+        // 速度Verlet法は前のステップの力を使うので、最初に初期配置での力を求めておく
+        if (needforce_) {
+            make_pair();
+            calculate_force_pair(true);
+            needforce_ = false;
+        }
+
+        // 物理量をサンプリングするステップかどうか
+        auto const sample = MD_iter_ % sampleinterval_ == 0;
+
+        // ポテンシャルエネルギーとビリアルは、サンプリングするステップと、圧力制御にビリアルが要るときだけ求める
+        auto const energy = sample || ensemble_ == EnsembleType::NPT;
+
+        // 運動エネルギーは温度制御でも使う
+        auto const kinetic = sample || ensemble_ != EnsembleType::NVE;
+
+        auto const nf = degrees_of_freedom();
+
+        // 温度制御と圧力制御による速度のスケーリングの係数は、update_position()のループで速度に掛ける
+        // 前のステップから遅らせたスケーリングがあれば、それもまとめて掛ける
+        auto scale = vscale_;
+        vscale_ = 1.0;
+        auto uk = Uk_;
+        if (ensemble_ != EnsembleType::NVE) {
+            auto const s = thermostat_.begin_step(uk, Tg_, nf, Ar_moleculardynamics::DT);
+            scale *= s;
+            uk *= s * s;
+        }
+
+        // 箱の大きさは座標を更新する前に変えておき、座標は同じループでスケーリングする
+        BarostatScale bs = { 1.0, 1.0, 1.0 };
+        if (ensemble_ == EnsembleType::NPT) {
+            bs = barostat_.begin_step(uk, virial_, volume(), Pg_, Tg_, nf, Ar_moleculardynamics::DT);
+            rescale_box(bs.rscale);
+        }
+
+        // 速度Verlet法で時間発展させる
+        // 速度の半ステップ分の更新と座標の更新 → 力の計算 → 速度の半ステップ分の更新
+        update_position(scale * bs.vscale, bs.rscale, bs.drift);
+        make_pair();
+        calculate_force_pair(energy);
+        update_velocity(kinetic);
+
+        // 後半の半ステップのスケーリングは次のステップまで遅らせ、
+        // 運動エネルギーだけをスケーリング後の値にしておく
+        if (ensemble_ == EnsembleType::NPT) {
+            auto const s = barostat_.end_step(Uk_, virial_, volume(), Pg_, Tg_, nf, Ar_moleculardynamics::DT);
+            vscale_ *= s;
+            Uk_ *= s * s;
+        }
+
+        if (ensemble_ != EnsembleType::NVE) {
+            auto const s = thermostat_.end_step(Uk_, Tg_, nf, Ar_moleculardynamics::DT);
+            vscale_ *= s;
+            Uk_ *= s * s;
+        }
+
+        if (sample) {
+            // 全エネルギー（運動エネルギー+ポテンシャルエネルギー）の計算
+            Utot_ = Uk_ + Up_;
+
+            // 温度の計算
+            Tc_ = 2.0 * Uk_ / static_cast<double>(nf);
+        }
+
+        // 繰り返し回数と時間を増加
+        t_ = static_cast<double>(MD_iter_)* Ar_moleculardynamics::DT;
+        MD_iter_++;
+
+        LJMD_END_STEP(timings_);
+    }
+
+    void Ar_moleculardynamics::calculate_force_pair(bool energy)
+    {
+        auto const stride = atoms_.stride();
+
+        // 混合精度はSIMD版のカーネルで、単精度の座標を用意できたときだけ使う
+        // 単精度の座標は毎回作り直すので、その時間も原子間力の計算に含める
+        auto mixed = false;
+        if (precision_ == PrecisionType::MIXED && (forcekernel_ == ForceKernelType::AVX2 || forcekernel_ == ForceKernelType::AVX512)) {
+            LJMD_PHASE_TIMER(timings_, PhaseType::FORCE);
+            mixed = mixed_.update(atoms_, NumAtom_, periodiclen_, rc_);
+        }
+
+        // 倍精度のSIMD版のカーネルは、原子のペアリストを作り直した後に一度だけクラスタのペアリストを作る
+        if (!mixed && (forcekernel_ == ForceKernelType::AVX2 || forcekernel_ == ForceKernelType::AVX512) && cluster_pairs_.offsets.empty()) {
+            LJMD_PHASE_TIMER(timings_, PhaseType::NEIGHBOR);
+            build_cluster_pair();
+        }
+
+        // スレッドが1つのときは、結果がビット単位で一致するように逐次版で計算する
+        if (tbb::this_task_arena::max_concurrency() == 1) {
+            LJMD_PHASE_TIMER(timings_, PhaseType::FORCE);
+
+            // ポテンシャルエネルギーの初期化（求めないときは前の値をそのまま残す）
+            if (energy) {
+                Up_ = 0.0;
+                virial_ = 0.0;
+            }
+
+            std::fill(atoms_.data(Atoms::F, 0), atoms_.data(Atoms::F, 0) + 3 * stride, 0.0);
+
+            calculate_force_range(
+                energy,
+                mixed,
+                0,
+                NumAtom_,
+                atoms_.data(Atoms::F, 0),
+                atoms_.data(Atoms::F, 1),
+                atoms_.data(Atoms::F, 2),
+                Up_,
+                virial_);
+        }
+        else {
+            tbb::combinable<double> Up;
+            tbb::combinable<double> virial;
+
+            {
+                LJMD_PHASE_TIMER(timings_, PhaseType::FORCE);
+
+                // 前のステップで使ったスレッドごとの力のバッファを初期化
+                for (auto && buf : forcebuffers_) {
+                    std::fill(buf.begin(), buf.end(), 0.0);
+                }
+
+                // 作用・反作用の法則による原子jへの寄与は、スレッドごとのバッファに書き込む
+                tbb::parallel_for(
+                    tbb::blocked_range<std::int32_t>(0, NumAtom_),
+                    [this, energy, mixed, stride, &Up, &virial](tbb::blocked_range<std::int32_t> const & range) {
+                    auto & buf = forcebuffers_.local();
+                    if (buf.size() != 3 * stride) {
+                        buf.assign(3 * stride, 0.0);
+                    }
+
+                    calculate_force_range(
+                        energy,
+                        mixed,
+                        range.begin(),
+                        range.end(),
+                        buf.data(),
+                        buf.data() + stride,
+                        buf.data() + 2 * stride,
+                        Up.local(),
+                        virial.local());
+                });
+            }
+
+            LJMD_PHASE_TIMER(timings_, PhaseType::REDUCTION);
+
+            // スレッドごとのバッファを足し合わせる
+            tbb::parallel_for(
+                tbb::blocked_range<std::size_t>(0, 3 * stride),
+                [this, stride](tbb::blocked_range<std::size_t> const & range) {
+                auto const f = atoms_.data(Atoms::F, 0);
+                std::fill(f + range.begin(), f + range.end(), 0.0);
+
+                for (auto const & buf : forcebuffers_) {
+                    if (buf.size() != 3 * stride) {
+                        continue;
+                    }
+
+                    for (auto m = range.begin(); m != range.end(); ++m) {
+                        f[m] += buf[m];
+                    }
+                }
+            });
+
+            if (energy) {
+                Up_ = Up.combine(std::plus<double>());
+                virial_ = virial.combine(std::plus<double>());
+            }
+        }
+    }
+    
+    void Ar_moleculardynamics::exportRenderFrame(float * frame, float colorratio) const
+    {
+        auto const avx2 = isSupported(ForceKernelType::AVX2);
+        auto const center = 0.5 * periodiclen_;
+
+        tbb::parallel_for(
+            tbb::blocked_range<std::int32_t>(0, NumAtom_),
+            [this, avx2, center, colorratio, frame](tbb::blocked_range<std::int32_t> const & range) {
+            if (avx2) {
+                export_frame_avx2(atoms_, range.begin(), range.end(), center, colorratio, frame);
+            }
+            else {
+                export_frame_scalar(atoms_, range.begin(), range.end(), center, colorratio, frame);
+            }
+        });
+    }
+
+    void Ar_moleculardynamics::exportTrajectoryFrame(TrajectoryFrame & frame, bool velocity, bool force) const
+    {
+        // 無次元単位からÅ、Å/ps、Hartree/Åへの換算係数
+        auto const lenfac = Ar_moleculardynamics::SIGMA * 1.0E+10;
+        auto const velfac = vscale_ * lenfac / (Ar_moleculardynamics::TAU * 1.0E+12);
+        auto const forcefac = Ar_moleculardynamics::YPSILON / Ar_moleculardynamics::HARTREE / lenfac;
+
+        frame.box = periodiclen_ * lenfac;
+        frame.MD_iter = MD_iter_;
+        frame.NumAtom = NumAtom_;
+        frame.time = getDeltat();
+        frame.timestep = Ar_moleculardynamics::TAU * Ar_moleculardynamics::DT * 1.0E+12;
+
+        auto const size = 3 * static_cast<std::size_t>(NumAtom_);
+        frame.position.resize(size);
+        frame.velocity.resize(velocity ? size : 0);
+        frame.force.resize(force ? size : 0);
+
+        // 通し番号の順に並べるので、配列の中の番号はindices_で引く
+        tbb::parallel_for(
+            tbb::blocked_range<std::int32_t>(0, NumAtom_),
+            [this, &frame, velocity, force, lenfac, velfac, forcefac](tbb::blocked_range<std::int32_t> const & range) {
+            for (auto id = range.begin(); id != range.end(); ++id) {
+                auto const n = indices_[id];
+                auto const m = 3 * static_cast<std::size_t>(id);
+                for (auto k = 0; k < 3; k++) {
+                    frame.position[m + k] = lenfac * atoms_.data(Atoms::R, k)[n];
+
+                    if (velocity) {
+                        frame.velocity[m + k] = velfac * atoms_.data(Atoms::V, k)[n];
+                    }
+
+                    if (force) {
+                        frame.force[m + k] = forcefac * atoms_.data(Atoms::F, k)[n];
+                    }
+                }
+            }
+        });
+    }
+
+    double Ar_moleculardynamics::getCutoff() const
+    {
+        return Ar_moleculardynamics::SIGMA * rc_ * 1.0E+9;
+    }
+
+    double Ar_moleculardynamics::getDeltat() const
+    {
+        return Ar_moleculardynamics::TAU * t_ * 1.0E+12;
+    }
+
+    std::int32_t Ar_moleculardynamics::getAtomId(std::int32_t n) const
+    {
+        return ids_[n];
+    }
+
+    std::int32_t Ar_moleculardynamics::getAtomIndex(std::int32_t id) const
+    {
+        return indices_[id];
+    }
+
+    BarostatType Ar_moleculardynamics::getBarostat() const
+    {
+        return barostat_.getType();
+    }
+
+    double Ar_moleculardynamics::getBarostatEnergy() const
+    {
+        return ensemble_ == EnsembleType::NPT ? DimensionlessToHartree(barostat_.energy(volume(), Pg_, Tg_, degrees_of_freedom())) : 0.0;
+    }
+
+    EnsembleType Ar_moleculardynamics::getEnsemble() const
+    {
+        return ensemble_;
+    }
+
+    ForceKernelType Ar_moleculardynamics::getForceKernel() const
+    {
+        return forcekernel_;
+    }
+
+    float Ar_moleculardynamics::getForce(std::int32_t n) const
+    {
+        return static_cast<float>(atoms_[n].f.norm());
+    }
+
+    double Ar_moleculardynamics::getLatticeconst() const
+    {
+        return Ar_moleculardynamics::SIGMA * lat_ * 1.0E+9;
+    }
+    
+    double Ar_moleculardynamics::getListLifetime() const
+    {
+        return nrebuild_ > 0 ? static_cast<double>(nstep_) / static_cast<double>(nrebuild_) : 0.0;
+    }
+
+    std::size_t Ar_moleculardynamics::getNumPairs() const
+    {
+        return atom_pairs_.size();
+    }
+
+    double Ar_moleculardynamics::getPeriodiclen() const
+    {
+        return Ar_moleculardynamics::SIGMA * periodiclen_ * 1.0E+9;
+    }
+
+    double Ar_moleculardynamics::getPgiven() const
+    {
+        return Pg_ * Ar_moleculardynamics::YPSILON / std::pow(Ar_moleculardynamics::SIGMA, 3) * Ar_moleculardynamics::ATM;
+    }
+
+    PrecisionType Ar_moleculardynamics::getPrecision() const
+    {
+        return precision_;
+    }
+
+    double Ar_moleculardynamics::getPressure() const
+    {
+        // P = (2Uk + W) / (3V)
+        auto const P = (2.0 * Uk_ + virial_) / (3.0 * volume());
+
+        return P * Ar_moleculardynamics::YPSILON / std::pow(Ar_moleculardynamics::SIGMA, 3) * Ar_moleculardynamics::ATM;
+    }
+
+    std::int32_t Ar_moleculardynamics::getReorderInterval() const
+    {
+        return reorderinterval_;
+    }
+
+    double Ar_moleculardynamics::getTcalc() const
+    {
+        return Ar_moleculardynamics::YPSILON / Ar_moleculardynamics::KB * Tc_;
+    }
+
+    std::int32_t Ar_moleculardynamics::getSampleInterval() const
+    {
+        return sampleinterval_;
+    }
+
+    double Ar_moleculardynamics::getSkin() const
+    {
+        return Ar_moleculardynamics::SIGMA * skin_ * 1.0E+9;
+    }
+
+    TableAccuracy Ar_moleculardynamics::getTableAccuracy() const
+    {
+        return ljtable_.accuracy(Ar_moleculardynamics::TABLESAMPLES);
+    }
+
+    std::int32_t Ar_moleculardynamics::getTableSize() const
+    {
+        return ljtable_.size();
+    }
+
+    double Ar_moleculardynamics::getTgiven() const
+    {
+        return Ar_moleculardynamics::YPSILON / Ar_moleculardynamics::KB * Tg_;
+    }
+
+    Timings const & Ar_moleculardynamics::getTimings() const
+    {
+        return timings_;
+    }
+
+    ThermostatType Ar_moleculardynamics::getThermostat() const
+    {
+        return thermostat_.getType();
+    }
+
+    double Ar_moleculardynamics::getThermostatEnergy() const
+    {
+        return ensemble_ != EnsembleType::NVE ? DimensionlessToHartree(thermostat_.energy(Tg_, degrees_of_freedom())) : 0.0;
+    }
+
+    bool Ar_moleculardynamics::loadCheckpoint(std::string const & filename)
+    {
+        using namespace boost::interprocess;
+
+        try {
+            file_mapping const file(filename.c_str(), read_only);
+            mapped_region const region(file, read_only);
+
+            auto const base = static_cast<char const *>(region.get_address());
+            auto const size = region.get_size();
+            if (size < sizeof(CheckpointHeader)) {
+                return false;
+            }
+
+            CheckpointHeader header;
+            std::memcpy(&header, base, sizeof(header));
+            if (!checkpoint_header_valid(header, size) ||
+                header.ensemble < static_cast<std::int32_t>(EnsembleType::NVE) ||
+                header.ensemble > static_cast<std::int32_t>(EnsembleType::NPT)) {
+                return false;
+            }
+
+            auto const payload = base + sizeof(header);
+            if (checkpoint_checksum(payload, header.payloadsize) != header.checksum) {
+                return false;
+            }
+
+            auto const atomsbytes = header.stride * 3 * Atoms::NUMQUANTITY * sizeof(double);
+            auto const idsbytes = static_cast<std::size_t>(header.NumAtom) * sizeof(std::int32_t);
+            auto const r0bytes = header.stride * 3 * sizeof(double);
+            auto const r0 = payload + atomsbytes + idsbytes;
+            auto const thermostat = r0 + r0bytes;
+            auto const barostat = thermostat + header.thermostatsize;
+
+            // 通し番号はindices_の添字になるので、0からNumAtom - 1までの並べ替えになっているか確かめる
+            std::vector<std::int32_t> ids(static_cast<std::size_t>(header.NumAtom));
+            std::memcpy(ids.data(), payload + atomsbytes, idsbytes);
+            std::vector<char> seen(ids.size(), 0);
+            for (auto const id : ids) {
+                if (id < 0 || id >= header.NumAtom || seen[id]) {
+                    return false;
+                }
+
+                seen[id] = 1;
+            }
+
+            // ピストンの状態は数値を三つ並べただけなので、チェックサムが合えば必ず読める
+            // 熱浴の乱数エンジンの形式は標準ライブラリによって違い得るので、ここまでで失敗したら状態を変えずに返す
+            if (!thermostat_.loadState(std::string(thermostat, header.thermostatsize))) {
+                return false;
+            }
+
+            auto const ok = barostat_.loadState(std::string(barostat, header.barostatsize));
+            BOOST_ASSERT(ok);
+            static_cast<void>(ok);
+
+            Nc_ = header.Nc;
+            NumAtom_ = header.NumAtom;
+            atoms_.resize(NumAtom_);
+
+            // 同じ設定でビルドしていれば成分の長さも同じなので、原子の配列はまとめて一度にコピーする
+            auto const copy = [this, &header](double * dst, char const * src, std::int32_t ncomponent) {
+                if (atoms_.stride() == header.stride) {
+                    std::memcpy(dst, src, header.stride * ncomponent * sizeof(double));
+                    return;
+                }
+
+                for (auto c = 0; c < ncomponent; c++) {
+                    std::memcpy(
+                        dst + static_cast<std::size_t>(c) * atoms_.stride(),
+                        src + static_cast<std::size_t>(c) * header.stride * sizeof(double),
+                        static_cast<std::size_t>(NumAtom_) * sizeof(double));
+                }
+            };
+            copy(atoms_.data(Atoms::F, 0), payload, 3 * Atoms::NUMQUANTITY);
+
+            ids_ = std::move(ids);
+            indices_.resize(NumAtom_);
+            for (auto n = 0; n < NumAtom_; n++) {
+                indices_[ids_[n]] = n;
+            }
+
+            MD_iter_ = header.MD_iter;
+            t_ = header.t;
+            ensemble_ = static_cast<EnsembleType>(header.ensemble);
+            lat_ = header.lat;
+            scale_ = header.scale;
+            periodiclen_ = header.periodiclen;
+            invperiodiclen_ = 1.0 / periodiclen_;
+            Tg_ = header.Tg;
+            Pg_ = header.Pg;
+            Uk_ = header.Uk;
+            Up_ = header.Up;
+            Utot_ = header.Utot;
+            Tc_ = header.Tc;
+            virial_ = header.virial;
+            vscale_ = header.vscale;
+
+            // ペアリストは、保存したときのリストを作ったときの座標と箱の長さから作り直す
+            // 作り直すステップと原子を並べ替えるステップが続けて計算したときと同じになり、結果がビット単位で一致する
+            nrebuild_ = header.nrebuild;
+            nstep_ = header.nstep;
+            needrebuild_ = !(header.listlen > 0.0);
+            if (!needrebuild_) {
+                auto const rx = atoms_.data(Atoms::R, 0);
+                std::vector<double> r(rx, rx + 3 * atoms_.stride());
+                copy(rx, r0, 3);
+
+                periodiclen_ = header.listlen;
+                invperiodiclen_ = 1.0 / periodiclen_;
+                build_pair();
+
+                std::copy(r.begin(), r.end(), rx);
+                listlen_ = header.listlen;
+                periodiclen_ = header.periodiclen;
+                invperiodiclen_ = 1.0 / periodiclen_;
+            }
+        }
+        catch (interprocess_exception const &) {
+            return false;
+        }
+
+        // 力は保存した値がそのまま使えるので、最初のステップで求め直さない
+        needforce_ = false;
+
+        timings_.reset();
+
+        return true;
+    }
+    
+    void Ar_moleculardynamics::make_pair()
+    {
+        LJMD_PHASE_TIMER(timings_, PhaseType::NEIGHBOR);
+
+        nstep_++;
+
+        // 前回ペアを作ってからの最大変位がスキンの半分を超えていなければ、ペアリストをそのまま使う
+        // 圧力制御で箱の大きさが変わったときは、ペアを作ったときの座標も同じ比率でスケーリングして変位を求める
+        // 箱が縮んだときは、原子間の距離も縮むので、その分だけスキンが減る
+        auto const ratio = periodiclen_ / listlen_;
+        auto const margin = std::min(ratio, 1.0) * (rc_ + skin_) - rc_;
+        if (!needrebuild_ && margin > 0.0) {
+            auto const stride = atoms_.stride();
+            auto const rx = atoms_.data(Atoms::R, 0);
+            auto const ry = atoms_.data(Atoms::R, 1);
+            auto const rz = atoms_.data(Atoms::R, 2);
+
+            auto maxdisp2 = 0.0;
+            for (auto n = 0; n < NumAtom_; n++) {
+                auto const dx = adjust_periodic(rx[n] - ratio * r0_[n]);
+                auto const dy = adjust_periodic(ry[n] - ratio * r0_[stride + n]);
+                auto const dz = adjust_periodic(rz[n] - ratio * r0_[2 * stride + n]);
+                auto const disp2 = dx * dx + dy * dy + dz * dz;
+                if (disp2 > maxdisp2) {
+                    maxdisp2 = disp2;
+                }
+            }
+
+            if (4.0 * maxdisp2 <= margin * margin) {
+                return;
+            }
+        }
+
+        needrebuild_ = false;
+        nrebuild_++;
+        listlen_ = periodiclen_;
+
+        // 時間が経つと空間的に近い原子が配列の中で散らばるので、ときどき並べ替えてからペアを作る
+        if (reorderinterval_ > 0 && (nrebuild_ - 1) % reorderinterval_ == 0) {
+            reorder();
+        }
+
+        build_pair();
+    }
+
+    void Ar_moleculardynamics::recalc()
+    {
+        t_ = 0.0;
+        MD_iter_ = 1;
+
+        // 原子の配置が変わるのでペアリストを作り直す
+        needrebuild_ = true;
+        nrebuild_ = 0;
+        nstep_ = 0;
+
+        // 原子の配置が変わるので力を求め直す
+        needforce_ = true;
+
+        // 熱浴とピストンも初期状態に戻す
+        thermostat_.reset();
+        barostat_.reset();
+        vscale_ = 1.0;
+
+        timings_.reset();
+
+        MD_initPos();
+        MD_initVel();
+
+        // 初期配置では通し番号と配列の中の番号が一致する
+        ids_.resize(NumAtom_);
+        std::iota(ids_.begin(), ids_.end(), 0);
+        indices_ = ids_;
+    }
+
+    void Ar_moleculardynamics::update_position(double vscale, double rscale, double drift)
+    {
+        LJMD_PHASE_TIMER(timings_, PhaseType::INTEGRATION);
+
+        // x, y, z成分の配列は連続しているので、まとめて一つのループで更新する
+        auto const f = atoms_.data(Atoms::F, 0);
+        auto const r = atoms_.data(Atoms::R, 0);
+        auto const v = atoms_.data(Atoms::V, 0);
+        auto const size = 3 * atoms_.stride();
+        auto const halfdt = 0.5 * Ar_moleculardynamics::DT;
+        auto const driftdt = drift * Ar_moleculardynamics::DT;
+        for (auto m = 0U; m < size; m++) {
+            v[m] = vscale * v[m] + halfdt * f[m];
+            r[m] = wrap_periodic(rscale * r[m] + driftdt * v[m], periodiclen_, invperiodiclen_);
+        }
+    }
+
+    void Ar_moleculardynamics::update_velocity(bool kinetic)
+    {
+        LJMD_PHASE_TIMER(timings_, PhaseType::INTEGRATION);
+
+        auto const halfdt = 0.5 * Ar_moleculardynamics::DT;
+
+        auto vv = 0.0;
+        if (ensemble_ != EnsembleType::NVE && thermostat_.getType() == ThermostatType::LANGEVIN) {
+            // 半ステップ分の更新の後に、摩擦と揺動力を加える（パディングの速度はゼロのままにする）
+            auto const c1 = thermostat_.damping(Ar_moleculardynamics::DT);
+            auto const c2 = thermostat_.noise(Tg_, Ar_moleculardynamics::DT);
+            for (auto k = 0; k < 3; k++) {
+                auto const f = atoms_.data(Atoms::F, k);
+                auto const v = atoms_.data(Atoms::V, k);
+                for (auto n = 0; n < NumAtom_; n++) {
+                    v[n] = c1 * (v[n] + halfdt * f[n]) + c2 * thermostat_.gaussian();
+                    vv += v[n] * v[n];
+                }
+            }
+        }
+        else {
+            auto const f = atoms_.data(Atoms::F, 0);
+            auto const v = atoms_.data(Atoms::V, 0);
+            auto const size = 3 * atoms_.stride();
+
+            // 運動エネルギーが要らないときは、リダクションのない単純なループにする
+            if (!kinetic) {
+                for (auto m = 0U; m < size; m++) {
+                    v[m] += halfdt * f[m];
+                }
+
+                return;
+            }
+
+            for (auto m = 0U; m < size; m++) {
+                v[m] += halfdt * f[m];
+                vv += v[m] * v[m];
+            }
+        }
+
+        // 運動エネルギーの計算
+        Uk_ = 0.5 * vv;
+    }
+
+    bool Ar_moleculardynamics::saveCheckpoint(std::string const & filename) const
+    {
+        using namespace boost::interprocess;
+
+        auto const thermostat = thermostat_.saveState();
+        auto const barostat = barostat_.saveState();
+
+        CheckpointHeader header = {};
+        std::memcpy(header.magic, CheckpointHeader::MAGIC, sizeof(header.magic));
+        header.endian = CheckpointHeader::ENDIAN;
+        header.version = CheckpointHeader::VERSION;
+        header.Nc = Nc_;
+        header.NumAtom = NumAtom_;
+        header.MD_iter = MD_iter_;
+        header.ensemble = static_cast<std::int32_t>(ensemble_);
+        header.nrebuild = nrebuild_;
+        header.nstep = nstep_;
+        header.stride = atoms_.stride();
+        header.thermostatsize = thermostat.size();
+        header.barostatsize = barostat.size();
+        header.t = t_;
+        header.lat = lat_;
+        header.scale = scale_;
+        header.periodiclen = periodiclen_;
+        header.listlen = needrebuild_ ? 0.0 : listlen_;
+        header.Tg = Tg_;
+        header.Pg = Pg_;
+        header.Uk = Uk_;
+        header.Up = Up_;
+        header.Utot = Utot_;
+        header.Tc = Tc_;
+        header.virial = virial_;
+        header.vscale = vscale_;
+        header.payloadsize = checkpoint_payload_size(header);
+
+        auto const atomsbytes = header.stride * 3 * Atoms::NUMQUANTITY * sizeof(double);
+        auto const idsbytes = static_cast<std::size_t>(NumAtom_) * sizeof(std::int32_t);
+        auto const r0bytes = header.stride * 3 * sizeof(double);
+        auto const size = sizeof(header) + header.payloadsize;
+
+        try {
+            // ファイルを必要な大きさで作ってからメモリにマップし、一つのバッファとして書き込む
+            {
+                std::filebuf fbuf;
+                if (!fbuf.open(filename, std::ios_base::in | std::ios_base::out | std::ios_base::trunc | std::ios_base::binary)) {
+                    return false;
+                }
+
+                fbuf.pubseekoff(static_cast<std::streamoff>(size - 1), std::ios_base::beg);
+                fbuf.sputc(0);
+            }
+
+            file_mapping const file(filename.c_str(), read_write);
+            mapped_region region(file, read_write);
+
+            auto const base = static_cast<char *>(region.get_address());
+            auto const payload = base + sizeof(header);
+            std::memcpy(payload, atoms_.data(Atoms::F, 0), atomsbytes);
+            std::memcpy(payload + atomsbytes, ids_.data(), idsbytes);
+
+            // ペアリストが無いときは、作ったときの座標の代わりに0を書いておく
+            if (header.listlen > 0.0) {
+                BOOST_ASSERT(r0_.size() == 3 * atoms_.stride());
+                std::memcpy(payload + atomsbytes + idsbytes, r0_.data(), r0bytes);
+            }
+            else {
+                std::memset(payload + atomsbytes + idsbytes, 0, r0bytes);
+            }
+
+            std::memcpy(payload + atomsbytes + idsbytes + r0bytes, thermostat.data(), thermostat.size());
+            std::memcpy(payload + atomsbytes + idsbytes + r0bytes + thermostat.size(), barostat.data(), barostat.size());
+
+            header.checksum = checkpoint_checksum(payload, header.payloadsize);
+            std::memcpy(base, &header, sizeof(header));
+
+            return region.flush();
+        }
+        catch (interprocess_exception const &) {
+            return false;
+        }
+    }
+
+    void Ar_moleculardynamics::setBarostat(BarostatType type)
+    {
+        barostat_.setType(type);
+    }
+
+    void Ar_moleculardynamics::setEnsemble(EnsembleType ensemble)
+    {
+        // 原子の配置はそのままにして、熱浴とピストンだけを初期状態に戻す
+        ensemble_ = ensemble;
+        thermostat_.reset();
+        barostat_.reset();
+    }
+
+    void Ar_moleculardynamics::setForceKernel(ForceKernelType type)
+    {
+        forcekernel_ = isSupported(type) ? type : ForceKernelType::SCALAR;
+    }
+
+    void Ar_moleculardynamics::setNc(std::int32_t Nc)
+    {
+        Nc_ = Nc;
+        atoms_.resize(Nc_ * Nc_ * Nc_ * 4);
+
+        ModLattice();
+    }
+
+    void Ar_moleculardynamics::setPgiven(double Pgiven)
+    {
+        Pg_ = Pgiven / Ar_moleculardynamics::ATM * std::pow(Ar_moleculardynamics::SIGMA, 3) / Ar_moleculardynamics::YPSILON;
+    }
+
+    void Ar_moleculardynamics::setPrecision(PrecisionType precision)
+    {
+        precision_ = precision;
+    }
+
+    void Ar_moleculardynamics::setReorderInterval(std::int32_t interval)
+    {
+        BOOST_ASSERT(interval >= 0);
+
+        reorderinterval_ = interval;
+    }
+
+    void Ar_moleculardynamics::setSampleInterval(std::int32_t interval)
+    {
+        BOOST_ASSERT(interval > 0);
+
+        sampleinterval_ = interval;
+    }
+
+    void Ar_moleculardynamics::setScale(double scale)
+    {
+        scale_ = scale;
+        ModLattice();
+    }
+
+    void Ar_moleculardynamics::setSkin(double skin)
+    {
+        BOOST_ASSERT(skin >= 0.0);
+
+        skin_ = skin;
+        needrebuild_ = true;
+    }
+
+    void Ar_moleculardynamics::setTableSize(std::int32_t size)
+    {
+        BOOST_ASSERT(size > 0);
+
+        ljtable_.build(size, rc2_, Vrc_);
+    }
+
+    void Ar_moleculardynamics::setTgiven(double Tgiven)
+    {
+        Tg_ = Tgiven * Ar_moleculardynamics::KB / Ar_moleculardynamics::YPSILON;
+    }
+
+    void Ar_moleculardynamics::setThermostat(ThermostatType type)
+    {
+        thermostat_.setType(type);
+    }
+
+    // #endregion publicメンバ関数
+
+    // #region privateメンバ関数
+
+    double Ar_moleculardynamics::adjust_periodic(double dv) const
+    {
+        return minimum_image(dv, periodiclen_, invperiodiclen_);
+    }
+
+    void Ar_moleculardynamics::build_cluster_pair()
+    {
+        auto const numcluster = (NumAtom_ + CLUSTERSIZE - 1) / CLUSTERSIZE;
+
+        cluster_pairs_.clear();
+        cluster_pairs_.offsets.reserve(numcluster + 1);
+
+        // j > iなので、相手のクラスタの番号は自分のクラスタの番号以上になる
+        // marked[cj] == ciなら、cj番目のクラスタはci番目のクラスタのリストに入っている
+        std::vector<std::int32_t> marked(numcluster, -1);
+        for (auto ci = 0; ci < numcluster; ci++) {
+            auto const begin = cluster_pairs_.neighbors.size();
+            cluster_pairs_.offsets.push_back(static_cast<std::int32_t>(begin));
+
+            auto const iend = std::min((ci + 1) * CLUSTERSIZE, NumAtom_);
+            for (auto i = ci * CLUSTERSIZE; i < iend; i++) {
+                auto const kend = atom_pairs_.offsets[i + 1];
+                for (auto k = atom_pairs_.offsets[i]; k < kend; k++) {
+                    auto const cj = atom_pairs_.neighbors[k] / CLUSTERSIZE;
+                    if (marked[cj] != ci) {
+                        marked[cj] = ci;
+                        cluster_pairs_.neighbors.push_back(cj);
+                    }
+                }
+            }
+
+            // 相手のクラスタを配列の順に読むように並べる
+            std::sort(cluster_pairs_.neighbors.begin() + begin, cluster_pairs_.neighbors.end());
+        }
+        cluster_pairs_.offsets.push_back(static_cast<std::int32_t>(cluster_pairs_.neighbors.size()));
+    }
+
+    void Ar_moleculardynamics::build_pair()
+    {
+        atom_pairs_.clear();
+        atom_pairs_.offsets.reserve(NumAtom_ + 1);
+
+        // クラスタのペアリストは、使うカーネルで力を計算するときに作り直す
+        cluster_pairs_.clear();
+
+        // ペアリストの打ち切り距離はカットオフ半径+スキン
+        auto const rl = rc_ + skin_;
+        auto const rl2 = rl * rl;
+
+        auto const rx = atoms_.data(Atoms::R, 0);
+        auto const ry = atoms_.data(Atoms::R, 1);
+        auto const rz = atoms_.data(Atoms::R, 2);
+
+        r0_.assign(rx, rx + 3 * atoms_.stride());
+
+        // 一辺あたり3個以上のセルに分割できるときはlinked-cell法でO(N)でペアを作る
+        if (celllist_.setup(NumAtom_, periodiclen_, rl)) {
+            celllist_.clear();
+            for (auto n = 0; n < NumAtom_; n++) {
+                celllist_.insert(n, celllist_.cellindex(rx[n], ry[n], rz[n]));
+            }
+
+            for (auto i = 0; i < NumAtom_; i++) {
+                atom_pairs_.offsets.push_back(static_cast<std::int32_t>(atom_pairs_.neighbors.size()));
+                for (auto const c : celllist_.neighbors(celllist_.cell(i))) {
+                    for (auto j = celllist_.head(c); j != -1; j = celllist_.next(j)) {
+                        // 同じペアを二重に数えないようにする
+                        if (j <= i) {
+                            continue;
+                        }
+
+                        auto const dx = adjust_periodic(rx[j] - rx[i]);
+                        auto const dy = adjust_periodic(ry[j] - ry[i]);
+                        auto const dz = adjust_periodic(rz[j] - rz[i]);
+                        if (dx * dx + dy * dy + dz * dz <= rl2) {
+                            atom_pairs_.neighbors.push_back(j);
+                        }
+                    }
+                }
+            }
+            atom_pairs_.offsets.push_back(static_cast<std::int32_t>(atom_pairs_.neighbors.size()));
+
+            return;
+        }
+
+        // 箱が小さいときは全てのペアについて調べる
+        for (auto i = 0; i < NumAtom_; i++) {
+            atom_pairs_.offsets.push_back(static_cast<std::int32_t>(atom_pairs_.neighbors.size()));
+            for (auto j = i + 1; j < NumAtom_; j++) {
+                auto const dx = adjust_periodic(rx[j] - rx[i]);
+                auto const dy = adjust_periodic(ry[j] - ry[i]);
+                auto const dz = adjust_periodic(rz[j] - rz[i]);
+                auto const r2 = dx * dx + dy * dy + dz * dz;
+
+                if (r2 > rl2) {
+                    continue;
+                }
+                atom_pairs_.neighbors.push_back(j);
+            }
+        }
+        atom_pairs_.offsets.push_back(static_cast<std::int32_t>(atom_pairs_.neighbors.size()));
+    }
+
+    void Ar_moleculardynamics::calculate_force_range(bool energy, bool mixed, std::int32_t first, std::int32_t last, double * fx, double * fy, double * fz, double & Up, double & virial) const
+    {
+        auto const rx = atoms_.data(Atoms::R, 0);
+        auto const ry = atoms_.data(Atoms::R, 1);
+        auto const rz = atoms_.data(Atoms::R, 2);
+
+        if (forcekernel_ != ForceKernelType::REFERENCE) {
+            ForceKernelArgs const args = {
+                atom_pairs_.offsets.data(),
+                atom_pairs_.neighbors.data(),
+                cluster_pairs_.offsets.data(),
+                cluster_pairs_.neighbors.data(),
+                NumAtom_,
+                rx,
+                ry,
+                rz,
+                fx,
+                fy,
+                fz,
+                periodiclen_,
+                invperiodiclen_,
+                rc2_,
+                Vrc_,
+                &ljtable_,
+                &mixed_
+            };
+
+            if (mixed) {
+                switch (forcekernel_) {
+                case ForceKernelType::AVX2:
+                    if (energy) {
+                        force_avx2_mixed<true>(args, first, last, Up, virial);
+                    }
+                    else {
+                        force_avx2_mixed<false>(args, first, last, Up, virial);
+                    }
+                    return;
+
+                case ForceKernelType::AVX512:
+                    if (energy) {
+                        force_avx512_mixed<true>(args, first, last, Up, virial);
+                    }
+                    else {
+                        force_avx512_mixed<false>(args, first, last, Up, virial);
+                    }
+                    return;
+
+                default:
+                    BOOST_ASSERT(!"何かがおかしい！");
+                    break;
+                }
+            }
+
+            switch (forcekernel_) {
+            case ForceKernelType::SCALAR:
+                if (energy) {
+                    force_scalar<true>(args, first, last, Up, virial);
+                }
+                else {
+                    force_scalar<false>(args, first, last, Up, virial);
+                }
+                return;
+
+            case ForceKernelType::AVX2:
+                if (energy) {
+                    force_avx2<true>(args, first, last, Up, virial);
+                }
+                else {
+                    force_avx2<false>(args, first, last, Up, virial);
+                }
+                return;
+
+            case ForceKernelType::AVX512:
+                if (energy) {
+                    force_avx512<true>(args, first, last, Up, virial);
+                }
+                else {
+                    force_avx512<false>(args, first, last, Up, virial);
+                }
+                return;
+
+            case ForceKernelType::TABLE:
+                if (energy) {
+                    force_table<true>(args, first, last, Up, virial);
+                }
+                else {
+                    force_table<false>(args, first, last, Up, virial);
+                }
+                return;
+
+            default:
+                BOOST_ASSERT(!"何かがおかしい！");
+                break;
+            }
+        }
+
+        // 参照実装（sqrtを使う元の計算式）
+
+        for (auto i = first; i < last; i++) {
+            // i番目の原子の座標と力はペアのループの間レジスタに置いておく
+            auto const xi = rx[i];
+            auto const yi = ry[i];
+            auto const zi = rz[i];
+            auto fxi = 0.0;
+            auto fyi = 0.0;
+            auto fzi = 0.0;
+
+            auto const kend = atom_pairs_.offsets[i + 1];
+            for (auto k = atom_pairs_.offsets[i]; k < kend; k++) {
+                auto const j = atom_pairs_.neighbors[k];
+                auto const dx = adjust_periodic(rx[j] - xi);
+                auto const dy = adjust_periodic(ry[j] - yi);
+                auto const dz = adjust_periodic(rz[j] - zi);
+                auto const r2 = dx * dx + dy * dy + dz * dz;
+
+                if (r2 > rc2_) {
+                    continue;
+                }
+
+                auto const r = std::sqrt(r2);
+                auto const r6 = r2 * r2 * r2;
+                auto const rm6 = 1.0 / r6;
+                auto const rm7 = rm6 / r;
+                auto const rm12 = rm6 * rm6;
+                auto const rm13 = rm12 / r;
+
+                auto const Fr = 48.0 * rm13 - 24.0 * rm7;
+                if (energy) {
+                    Up += 4.0 * (rm12 - rm6) - Vrc_;
+                    virial += r * Fr;
+                }
+
+                auto const fr = Fr / r;
+                fxi -= dx * fr;
+                fyi -= dy * fr;
+                fzi -= dz * fr;
+                fx[j] += dx * fr;
+                fy[j] += dy * fr;
+                fz[j] += dz * fr;
+            }
+
+            fx[i] += fxi;
+            fy[i] += fyi;
+            fz[i] += fzi;
+        }
+    }
+
+    std::int32_t Ar_moleculardynamics::degrees_of_freedom() const
+    {
+        // Langevin熱浴では重心の運動量が保存されない
+        return ensemble_ != EnsembleType::NVE && thermostat_.getType() == ThermostatType::LANGEVIN ? 3 * NumAtom_ : 3 * NumAtom_ - 3;
+    }
+
+    double Ar_moleculardynamics::DimensionlessToHartree(double e) const
+    {
+        return e * Ar_moleculardynamics::YPSILON / Ar_moleculardynamics::HARTREE;
+    }
+
+    void Ar_moleculardynamics::MD_initPos()
+    {
+        auto const rx = atoms_.data(Atoms::R, 0);
+        auto const ry = atoms_.data(Atoms::R, 1);
+        auto const rz = atoms_.data(Atoms::R, 2);
+
+        double sx, sy, sz;
+        auto n = 0;
+
+        auto const setpos = [rx, ry, rz, &n](double x, double y, double z) {
+            rx[n] = x;
+            ry[n] = y;
+            rz[n] = z;
+            n++;
+        };
+
+        for (auto i = 0; i < Nc_; i++) {
+            for (auto j = 0; j < Nc_; j++) {
+                for (auto k = 0; k < Nc_; k++) {
+                    // 基本セルをコピーする
+                    sx = static_cast<double>(i) * lat_;
+                    sy = static_cast<double>(j) * lat_;
+                    sz = static_cast<double>(k) * lat_;
+
+                    // 基本セル内には4つの原子がある
+                    setpos(sx, sy, sz);
+                    setpos(0.5 * lat_ + sx, 0.5 * lat_ + sy, sz);
+                    setpos(sx, 0.5 * lat_ + sy, 0.5 * lat_ + sz);
+                    setpos(0.5 * lat_ + sx, sy, 0.5 * lat_ + sz);
+                }
+            }
+        }
+
+        NumAtom_ = n;
+
+        // move the center of mass to the origin
+        // 系の重心を座標系の原点とする
+        sx = 0.0;
+        sy = 0.0;
+        sz = 0.0;
+
+        for (auto n = 0; n < NumAtom_; n++) {
+            sx += rx[n];
+            sy += ry[n];
+            sz += rz[n];
+        }
+
+        sx /= static_cast<double>(NumAtom_);
+        sy /= static_cast<double>(NumAtom_);
+        sz /= static_cast<double>(NumAtom_);
+
+        for (auto n = 0; n < NumAtom_; n++) {
+            rx[n] -= sx;
+            ry[n] -= sy;
+            rz[n] -= sz;
+        }
+    }
+
+    void Ar_moleculardynamics::MD_initVel()
+    {
+        auto const v = std::sqrt(3.0 * Tg_);
+
+        myrandom::MyRand mr(-1.0, 1.0);
+
+        for (auto n = 0; n < NumAtom_; n++) {
+            auto const a = atoms_[n];
+
+            std::array<double, 3> rnd = { mr.myrand(), mr.myrand(), mr.myrand() };
+            auto const tmp = 1.0 / std::sqrt(rnd[0] * rnd[0] + rnd[1] * rnd[1] + rnd[2] * rnd[2]);
+
+            // 方向はランダムに与える
+            for (auto k = 0; k < 3; k++) {
+                a.v[k] = v * rnd[k] * tmp;
+            }
+        }
+
+        // 重心の並進運動を避けるために、速度の和がゼロになるように補正
+        for (auto k = 0; k < 3; k++) {
+            auto const vk = atoms_.data(Atoms::V, k);
+
+            auto s = 0.0;
+            for (auto n = 0; n < NumAtom_; n++) {
+                s += vk[n];
+            }
+
+            s /= static_cast<double>(NumAtom_);
+
+            for (auto n = 0; n < NumAtom_; n++) {
+                vk[n] -= s;
+            }
+        }
+
+        // 温度制御は前のステップの運動エネルギーを使うので、初期速度での値を求めておく
+        auto vv = 0.0;
+        for (auto k = 0; k < 3; k++) {
+            auto const vk = atoms_.data(Atoms::V, k);
+            for (auto n = 0; n < NumAtom_; n++) {
+                vv += vk[n] * vk[n];
+            }
+        }
+
+        Uk_ = 0.5 * vv;
+        Tc_ = 2.0 * Uk_ / static_cast<double>(degrees_of_freedom());
+    }
+
+    void Ar_moleculardynamics::ModLattice()
+    {
+        lat_ = std::pow(2.0, 2.0 / 3.0) * scale_;
+        recalc();
+        periodiclen_ = lat_ * static_cast<double>(Nc_);
+        invperiodiclen_ = 1.0 / periodiclen_;
+    }
+
+    void Ar_moleculardynamics::reorder()
+    {
+        auto const rx = atoms_.data(Atoms::R, 0);
+        auto const ry = atoms_.data(Atoms::R, 1);
+        auto const rz = atoms_.data(Atoms::R, 2);
+
+        // 座標を箱の中に戻してから、各成分をMORTONBITSビットの整数にする
+        auto const nmax = (1 << Ar_moleculardynamics::MORTONBITS) - 1;
+        auto const scale = static_cast<double>(nmax + 1) * invperiodiclen_;
+        auto const quantize = [this, nmax, scale](double r) {
+            auto const q = static_cast<std::int32_t>(wrap_periodic(r, periodiclen_, invperiodiclen_) * scale);
+            return static_cast<std::uint64_t>(std::min(std::max(q, 0), nmax));
+        };
+
+        // 10ビットの整数の各ビットの間に2ビットずつ隙間を空ける
+        auto const spread = [](std::uint64_t x) {
+            x = (x | (x << 16)) & 0x030000FF;
+            x = (x | (x << 8)) & 0x0300F00F;
+            x = (x | (x << 4)) & 0x030C30C3;
+            x = (x | (x << 2)) & 0x09249249;
+            return x;
+        };
+
+        // 上位ビットにMorton順のキー、下位32ビットに元の番号を入れて並べ替える
+        // 元の番号がキーに含まれるので、並べ替えの結果は一意に決まる
+        std::vector<std::uint64_t> keys(NumAtom_);
+        for (auto n = 0; n < NumAtom_; n++) {
+            auto const morton = spread(quantize(rx[n])) | (spread(quantize(ry[n])) << 1) | (spread(quantize(rz[n])) << 2);
+            keys[n] = (morton << 32) | static_cast<std::uint64_t>(n);
+        }
+
+        tbb::parallel_sort(keys.begin(), keys.end());
+
+        std::vector<std::int32_t> order(NumAtom_);
+        for (auto n = 0; n < NumAtom_; n++) {
+            order[n] = static_cast<std::int32_t>(keys[n] & 0xFFFFFFFF);
+        }
+
+        atoms_.permute(order);
+
+        // 通し番号との対応も同じように並べ替える
+        std::vector<std::int32_t> ids(NumAtom_);
+        for (auto n = 0; n < NumAtom_; n++) {
+            ids[n] = ids_[order[n]];
+            indices_[ids[n]] = n;
+        }
+
+        ids_.swap(ids);
+    }
+
+    void Ar_moleculardynamics::rescale_box(double s)
+    {
+        // 格子定数も同じ比率で変わる
+        lat_ *= s;
+        periodiclen_ *= s;
+        invperiodiclen_ = 1.0 / periodiclen_;
+    }
+
+    double Ar_moleculardynamics::volume() const
+    {
+        return periodiclen_ * periodiclen_ * periodiclen_;
+    }
+
+    // #endregion privateメンバ関数
+}
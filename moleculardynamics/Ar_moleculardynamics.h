@@ -1,501 +1,982 @@
-﻿/*! \file Ar_moleculardynamics.h
-    \brief アルゴンに対して、分子動力学シミュレーションを行うクラスの宣言
-
-    Copyright ©  2015 @dc1394 All Rights Reserved.
-    This software is released under the BSD 2-Clause License.
-*/
-
-#ifndef _AR_MOLECULARDYNAMICS_H_
-#define _AR_MOLECULARDYNAMICS_H_
-
-#pragma once
-
-#include "../utility/property.h"
-#include <cstdint>                              // for std::int32_t
-#include <utility>                              // for std::pair
-#include <vector>                               // for std::vector
-#include <boost/align/aligned_allocator.hpp>    // for boost::alignment::aligned_allocator
-#include <Eigen/Core>                           // for Eigen::Vector4d
-
-namespace moleculardynamics {
-    using namespace utility;
-
-    enum class EnsembleType : std::int32_t {
-        NVE = 0,
-        NVT = 1
-    };
-
-    #pragma pack(16)
-    struct Atom {
-        Eigen::Vector4d f;
-        Eigen::Vector4d r;
-        Eigen::Vector4d r1;
-        Eigen::Vector4d v;
-        Eigen::Vector4d p;
-    };
-
-    //! A class.
-    /*!
-        アルゴンに対して、分子動力学シミュレーションを行うクラス
-    */
-    class Ar_moleculardynamics final {
-        // #region コンストラクタ・デストラクタ
-
-    public:
-        //! A constructor.
-        /*!
-            コンストラクタ
-        */
-        Ar_moleculardynamics();
-
-        //! A destructor.
-        /*!
-            デフォルトデストラクタ
-        */
-        ~Ar_moleculardynamics() = default;
-
-        // #endregion コンストラクタ・デストラクタ
-
-        // #region publicメンバ関数
-
-        //! A public member function.
-        /*!
-            原子に働く力を計算する
-        */
-        void calculate();
-
-        //! A public member function.
-        /*!
-            原子に働く力を計算する
-        */
-        void calculate_force_pair();
-        
-        //! A public member function (constant).
-        /*!
-            シミュレーションを開始してからの経過時間を求める
-        */
-        double getDeltat() const;
-
-        //! A public member function (constant).
-        /*!
-            n番目の原子に働く力を求める
-        */
-        float getForce(std::int32_t n) const;
-
-        //! A public member function (constant).
-        /*!
-            格子定数を求める
-        */
-        double getLatticeconst() const;
-        
-        //! A public member function (constant).
-        /*!
-            周期境界条件の長さを求める
-        */
-        double getPeriodiclen() const;
-
-        //! A public member function (constant).
-        /*!
-            計算された圧力を求める
-        */
-        double getPressure() const;
-        
-        //! A public member function (constant).
-        /*!
-            計算された温度の絶対温度を求める
-        */
-        double getTcalc() const;
-
-        //! A public member function (constant).
-        /*!
-            与えた温度の絶対温度を求める
-        */
-        double getTgiven() const;
-
-        //! A public member function.
-        /*!
-            原子のペアを作る
-        */
-        void make_pair();
-
-        //! A public member function.
-        /*!
-            原子を移動させる
-        */
-        void Move_Atoms();
-        
-        //! A oublic member function.
-        /*!
-            再計算する
-        */
-        void recalc();
-
-        void update_position();
-
-        //! A public member function.
-        /*!
-            アンサンブルを設定する
-            \param ensemble 設定するアンサンブル
-        */
-        void setEnsemble(EnsembleType ensemble);
-
-        //! A public member function.
-        /*!
-            スーパーセルの大きさを設定する
-            \param Nc スーパーセルの大きさ
-        */
-        void setNc(std::int32_t Nc);
-
-        //! A public member function.
-        /*!
-            格子定数のスケールを設定する
-            \param scale 設定する格子定数のスケール
-        */
-        void setScale(double scale);
-
-        //! A public member function.
-        /*!
-            温度を設定する
-            \param Tgiven 設定する温度（絶対温度）
-        */
-        void setTgiven(double Tgiven);
-
-        // #endregion publicメンバ関数
-
-        // #region privateメンバ関数
-
-    private:
-        //! A private member function.
-        /*!
-            エネルギーの単位を無次元単位からHartreeに変換する
-            \param e 無次元単位で表されたエネルギー
-            \return Hartree単位で表されたエネルギー
-        */
-        Eigen::Vector4d adjust_periodic(Eigen::Vector4d const & dv);
-
-        //! A private member function.
-        /*!
-            エネルギーの単位を無次元単位からHartreeに変換する
-            \param e 無次元単位で表されたエネルギー
-            \return Hartree単位で表されたエネルギー
-        */
-        double DimensionlessToHartree(double e) const;
-        
-        //! A private member function.
-        /*!
-            原子の初期位置を決める
-        */
-        void MD_initPos();
-
-        //! A private member function.
-        /*!
-            原子の初期速度を決める
-        */
-        void MD_initVel();
-
-        //! A private member function.
-        /*!
-            格子定数が変更されたときに呼ばれる
-        */
-        void ModLattice();
-
-        void periodic();
-
-        // #endregion privateメンバ関数
-
-        // #region プロパティ
-
-    public:
-        //! A property.
-        /*!
-            原子へのプロパティ
-        */
-        Property<std::vector<Atom, boost::alignment::aligned_allocator<Atom> > const &> const atoms;
-
-        //! A property.
-        /*!
-            MDのステップ数へのプロパティ
-        */
-        Property<std::int32_t> const MD_iter;
-        
-        //! A property.
-        /*!
-            スーパーセルの個数へのプロパティ
-        */
-        Property<std::int32_t> const Nc;
-
-        //! A property.
-        /*!
-            原子数へのプロパティ
-        */
-        Property<std::int32_t> const NumAtom;
-
-        //! A property.
-        /*!
-            格子定数へのプロパティ
-        */
-        Property<double> const periodiclen;
-        
-        //! A property.
-        /*!
-            運動エネルギーへのプロパティ
-        */
-        Property<double> const Uk;
-
-        //! A property.
-        /*!
-            ポテンシャルエネルギーへのプロパティ
-        */
-        Property<double> const Up;
-
-        //! A property.
-        /*!
-            全エネルギーへのプロパティ
-        */
-        Property<double> const Utot;
-
-        // #endregion プロパティ
-
-        // #region メンバ変数
-
-    public:
-        //! A private member variable (constant).
-        /*!
-            初期のスーパーセルの個数
-        */
-        static auto const FIRSTNC = 4;
-
-        //! A private member variable (constant).
-        /*!
-            初期の格子定数のスケール
-        */
-        static double const FIRSTSCALE;
-
-        //! A private member variable (constant).
-        /*!
-            初期温度（絶対温度）
-        */
-        static double const FIRSTTEMP;
-        
-        //! A private member variable (constant).
-        /*!
-            アルゴン原子に対するσ
-        */
-        static double const SIGMA;
-
-        //! A private member variable (constant).
-        /*!
-            アルゴン原子のVan der Waals半径
-        */
-        static double const VDW_RADIUS;
-
-    private:
-        //! A private member variable (constant).
-        /*!
-            Woodcockの温度スケーリングの係数
-        */
-        static double const ALPHA;
-
-        //! A private member variable (constant).
-        /*!
-            標準気圧
-        */
-        static double const ATM;
-
-        //! A private member variable (constant).
-        /*!
-            アボガドロ定数
-        */
-        static double const AVOGADRO_CONSTANT;
-
-        //! A private member variable (constant).
-        /*!
-            時間刻みΔt
-        */
-        static double const DT;
-        
-        //! A private member variable (constant).
-        /*!
-            1Hartree
-        */
-        static double const HARTREE;
-        
-        //! A private member variable (constant).
-        /*!
-            ボルツマン定数
-        */
-        static double const KB;
-
-        //! A private member variable (constant).
-        /*!
-            アルゴン原子に対するτ
-        */
-        static double const TAU;
-
-        //! A private member variable (constant).
-        /*!
-            アルゴン原子に対するε
-        */
-        static double const YPSILON;
-
-        //! A private member variable (constant).
-        /*!
-            スーパーセルの個数
-        */
-        std::int32_t Nc_ = Ar_moleculardynamics::FIRSTNC;
-        
-        //! A private member variable.
-        /*!
-            原子の可変長配列
-        */
-        std::vector<Atom, boost::alignment::aligned_allocator<Atom> > atoms_;
-
-        //! A private member variable.
-        /*!
-            原子の可変長配列
-        */
-        std::vector< std::pair<std::int32_t, std::int32_t> > atom_pairs_;
-
-        //! A private member variable (constant).
-        /*!
-            時間刻みの二乗
-        */
-        double const dt2;
-
-        //! A private member variable.
-        /*!
-            アンサンブル
-        */
-        EnsembleType ensemble_ = EnsembleType::NVT;
-
-        //! A private member variable.
-        /*!
-            格子定数
-        */
-        double lat_;
-
-        //! A private member variable.
-        /*!
-            MDのステップ数
-        */
-        std::int32_t MD_iter_;
-
-        //! A private member variable (constant).
-        /*!
-            相互作用を計算するセルの個数
-        */
-        std::int32_t const ncp_ = 3;
-        
-        //! A private member variable.
-        /*!
-            原子数
-        */
-        std::int32_t NumAtom_;
-        
-        //! A private member variable.
-        /*!
-            周期境界条件の長さ
-        */
-        double periodiclen_;
-
-        //! A private member variable (constant).
-        /*!
-            カットオフ半径
-        */
-        double const rc_ = 2.5;
-
-        //! A private member variable (constant).
-        /*!
-            カットオフ半径の2乗
-        */
-        double const rc2_;
-
-        //! A private member variable (constant).
-        /*!
-            カットオフ半径の逆数の6乗
-        */
-        double const rcm6_;
-
-        //! A private member variable (constant).
-        /*!
-            カットオフ半径の逆数の12乗
-        */
-        double const rcm12_;
-
-        //! A private member variable.
-        /*!
-            格子定数のスケーリングの定数
-        */
-        double scale_ = Ar_moleculardynamics::FIRSTSCALE;
-        
-        //! A private member variable.
-        /*!
-            時間    
-        */
-        double t_;
-
-        //! A private member variable.
-        /*!
-            計算された温度Tcalc
-        */
-        double Tc_;
-
-        //! A private member variable.
-        /*!
-            与える温度Tgiven
-        */
-        double Tg_;
-        
-        //! A private member variable (constant).
-        /*!
-            運動エネルギー
-        */
-        double Uk_;
-
-        //! A private member variable (constant).
-        /*!
-            ポテンシャルエネルギー
-        */
-        double Up_;
-
-        //! A private member variable (constant).
-        /*!
-            全エネルギー
-        */
-        double Utot_;
-
-        //! A private member variable (constant).
-        /*!
-            ビリアル
-        */
-        double virial_;
-
-        //! A private member variable (constant).
-        /*!
-            ポテンシャルエネルギーの打ち切り
-        */
-        double const Vrc_;
-
-        // #endregion メンバ変数
-
-        // #region 禁止されたコンストラクタ・メンバ関数
-
-        //! A private copy constructor (deleted).
-        /*!
-            コピーコンストラクタ（禁止）
-        */
-        Ar_moleculardynamics(Ar_moleculardynamics const &) = delete;
-
-        //! A private member function (deleted).
-        /*!
-            operator=()の宣言（禁止）
-            \param コピー元のオブジェクト（未使用）
-            \return コピー元のオブジェクト
-        */
-        Ar_moleculardynamics & operator=(Ar_moleculardynamics const &) = delete;
-
-        // #endregion 禁止されたコンストラクタ・メンバ関数
-    };
-}
-
-#endif      // _AR_MOLECULARDYNAMICS_H_
+﻿/*! \file Ar_moleculardynamics.h
+    \brief アルゴンに対して、分子動力学シミュレーションを行うクラスの宣言
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _AR_MOLECULARDYNAMICS_H_
+#define _AR_MOLECULARDYNAMICS_H_
+
+#pragma once
+
+#include "atoms.h"
+#include "barostat.h"
+#include "celllist.h"
+#include "forcekernel.h"
+#include "ljtable.h"
+#include "mixedpositions.h"
+#include "pairlist.h"
+#include "thermostat.h"
+#include "timings.h"
+#include "../utility/property.h"
+#include <cstddef>                              // for std::size_t
+#include <cstdint>                              // for std::int32_t
+#include <string>                               // for std::string
+#include <vector>                               // for std::vector
+#include <boost/align/aligned_allocator.hpp>    // for boost::alignment::aligned_allocator
+#include <tbb/enumerable_thread_specific.h>     // for tbb::enumerable_thread_specific
+
+namespace moleculardynamics {
+    using namespace utility;
+
+    struct TrajectoryFrame;
+
+    enum class EnsembleType : std::int32_t {
+        NVE = 0,
+        NVT = 1,
+        NPT = 2
+    };
+
+    //! A class.
+    /*!
+        アルゴンに対して、分子動力学シミュレーションを行うクラス
+    */
+    class Ar_moleculardynamics final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            コンストラクタ
+        */
+        Ar_moleculardynamics();
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~Ar_moleculardynamics() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region publicメンバ関数
+
+        //! A public member function.
+        /*!
+            原子に働く力を計算する
+            運動エネルギー、ポテンシャルエネルギー、全エネルギーと温度は、
+            サンプリングするステップ（setSampleInterval()）でのみ更新される
+        */
+        void calculate();
+
+        //! A public member function.
+        /*!
+            原子に働く力を計算する
+            スレッドが2つ以上使えるときは、スレッドごとの力のバッファを使って並列に計算する
+            \param energy ポテンシャルエネルギーとビリアルも計算するならtrue（falseなら前の値を残す）
+        */
+        void calculate_force_pair(bool energy);
+
+        //! A public member function (constant).
+        /*!
+            描画用に、全ての原子の(x, y, z, 色)をfloat 4個ずつのレコードとして書き出す
+            座標は箱の中心を原点とし、色は力の大きさにcolorratioを掛けて1で飽和させた値
+            （原子の並びは配列の中の順で、getAtomId()で通し番号に変換できる）
+            原子を分割して並列に、AVX2が使えるCPUでは4原子ずつSIMDで変換する
+            frameには書き込むだけで読み出さないので、Mapした頂点バッファを直接渡してもよい
+            \param frame レコードを書き込む配列（原子数 * 4個のfloat）
+            \param colorratio 力の大きさを色に変換する比率
+        */
+        void exportRenderFrame(float * frame, float colorratio) const;
+
+        //! A public member function (constant).
+        /*!
+            トラジェクトリの1フレームとして、全ての原子の座標（と速度・力）を通し番号の順に書き出す
+            長さはÅ、時間はps、力はHartree/Åに変換する
+            速度には次のステップまで遅らせている温度・圧力制御のスケーリングも掛ける
+            \param frame 書き込むフレーム（配列の大きさは必要に応じて変える）
+            \param velocity 速度も書き出すならtrue（falseなら速度の配列を空にする）
+            \param force 力も書き出すならtrue（falseなら力の配列を空にする）
+        */
+        void exportTrajectoryFrame(TrajectoryFrame & frame, bool velocity, bool force) const;
+
+        //! A public member function (constant).
+        /*!
+            現在n番目にある原子の通し番号（初期配置での番号）を求める
+            原子の配列は並べ替えられるので、描画やトラジェクトリの出力で原子を区別するときはこの番号を使う
+        */
+        std::int32_t getAtomId(std::int32_t n) const;
+
+        //! A public member function (constant).
+        /*!
+            通し番号がidの原子が、現在何番目にあるかを求める
+        */
+        std::int32_t getAtomIndex(std::int32_t id) const;
+        
+        //! A public member function (constant).
+        /*!
+            圧力制御の方法を求める
+        */
+        BarostatType getBarostat() const;
+
+        //! A public member function (constant).
+        /*!
+            MTKのピストンのエネルギー（PV項を含む）を求める
+            全エネルギーとの和が保存量になる（Berendsenや、NPTアンサンブル以外では0）
+        */
+        double getBarostatEnergy() const;
+
+        //! A public member function (constant).
+        /*!
+            カットオフ半径を求める（nm）
+        */
+        double getCutoff() const;
+
+        //! A public member function (constant).
+        /*!
+            シミュレーションを開始してからの経過時間を求める
+        */
+        double getDeltat() const;
+
+        //! A public member function (constant).
+        /*!
+            アンサンブルを求める
+        */
+        EnsembleType getEnsemble() const;
+
+        //! A public member function (constant).
+        /*!
+            n番目の原子に働く力を求める
+        */
+        float getForce(std::int32_t n) const;
+
+        //! A public member function (constant).
+        /*!
+            原子間力の計算に使われているカーネルの種類を求める
+        */
+        ForceKernelType getForceKernel() const;
+
+        //! A public member function (constant).
+        /*!
+            格子定数を求める
+        */
+        double getLatticeconst() const;
+
+        //! A public member function (constant).
+        /*!
+            ペアリストを作り直すまでの平均のステップ数を求める
+        */
+        double getListLifetime() const;
+
+        //! A public member function (constant).
+        /*!
+            ペアリストに含まれる原子のペアの数を求める
+        */
+        std::size_t getNumPairs() const;
+        
+        //! A public member function (constant).
+        /*!
+            周期境界条件の長さを求める
+        */
+        double getPeriodiclen() const;
+
+        //! A public member function (constant).
+        /*!
+            与えた圧力を求める（atm）
+        */
+        double getPgiven() const;
+
+        //! A public member function (constant).
+        /*!
+            原子間力の計算の精度を求める
+        */
+        PrecisionType getPrecision() const;
+
+        //! A public member function (constant).
+        /*!
+            計算された圧力を求める（atm）
+        */
+        double getPressure() const;
+
+        //! A public member function (constant).
+        /*!
+            原子の配列を並べ替える間隔（ペアリストを作り直す回数）を求める
+        */
+        std::int32_t getReorderInterval() const;
+        
+        //! A public member function (constant).
+        /*!
+            物理量をサンプリングする間隔（ステップ数）を求める
+        */
+        std::int32_t getSampleInterval() const;
+
+        //! A public member function (constant).
+        /*!
+            ペアリストのスキンの厚さを求める（nm）
+        */
+        double getSkin() const;
+
+        //! A public member function (constant).
+        /*!
+            表による補間の、解析的な式に対する誤差を求める
+            \return F(r) / rの最大の相対誤差と、ポテンシャルエネルギーの最大の絶対誤差
+        */
+        TableAccuracy getTableAccuracy() const;
+
+        //! A public member function (constant).
+        /*!
+            表による補間の区間の数を求める
+        */
+        std::int32_t getTableSize() const;
+
+        //! A public member function (constant).
+        /*!
+            計算された温度の絶対温度を求める
+        */
+        double getTcalc() const;
+
+        //! A public member function (constant).
+        /*!
+            与えた温度の絶対温度を求める
+        */
+        double getTgiven() const;
+
+        //! A public member function (constant).
+        /*!
+            MDの各段階にかかった時間を求める
+            LJMD_ENABLE_TIMERSが定義されていないときは、全て0になる
+        */
+        Timings const & getTimings() const;
+
+        //! A public member function (constant).
+        /*!
+            温度制御の方法を求める
+        */
+        ThermostatType getThermostat() const;
+
+        //! A public member function (constant).
+        /*!
+            Nosé-Hooverチェインの熱浴のエネルギーを求める
+            全エネルギーとの和が保存量になる（他の温度制御やNVEアンサンブルでは0）
+        */
+        double getThermostatEnergy() const;
+
+        //! A public member function.
+        /*!
+            saveCheckpoint()で保存した状態を読み込み、その続きから計算できるようにする
+            ファイルはメモリにマップし、原子の配列はまとめて一度にコピーする
+            原子数、箱、アンサンブル、熱浴とピストンの状態、与えた温度と圧力はファイルの値になる
+            （原子間力のカーネル、精度、サンプリングと並べ替えの間隔などの設定はそのまま）
+            \param filename チェックポイントファイルの名前
+            \return 読み込めたらtrue（ファイルが無い、形式や版やバイトオーダーが違う、チェックサムが合わないときはfalseで、状態は変えない）
+        */
+        bool loadCheckpoint(std::string const & filename);
+
+        //! A public member function.
+        /*!
+            原子のペアを作る
+            前回ペアを作ってからの最大変位の2倍がスキンを超えたときだけ作り直す
+        */
+        void make_pair();
+
+        //! A oublic member function.
+        /*!
+            再計算する
+        */
+        void recalc();
+
+        //! A public member function.
+        /*!
+            速度Verlet法の前半：速度を半ステップ分、座標を1ステップ分更新する
+            座標の更新と同じループで、周期境界条件に従って座標をセル内に戻す
+            温度制御と圧力制御による速度と座標のスケーリングも同じループで行う
+            \param vscale 速度を更新する前に掛ける係数
+            \param rscale 座標に掛ける係数（箱の大きさの変化の比率）
+            \param drift 座標の更新で速度に掛ける係数
+        */
+        void update_position(double vscale, double rscale, double drift);
+
+        //! A public member function.
+        /*!
+            速度Verlet法の後半：速度を半ステップ分更新する
+            同じループで運動エネルギーを計算する
+            Langevin熱浴では、同じループで摩擦と揺動力を加える
+            \param kinetic 運動エネルギーを計算するならtrue（falseなら前の値を残す）
+        */
+        void update_velocity(bool kinetic);
+
+        //! A public member function (constant).
+        /*!
+            計算を続けるのに必要な状態（原子の座標・速度・力と通し番号、MDのステップ数と時間、
+            箱、アンサンブル、熱浴とピストンの状態）をチェックポイントファイルに保存する
+            \param filename チェックポイントファイルの名前
+            \return 保存できたらtrue
+        */
+        bool saveCheckpoint(std::string const & filename) const;
+
+        //! A public member function.
+        /*!
+            圧力制御の方法を設定する
+            \param type 圧力制御の方法
+        */
+        void setBarostat(BarostatType type);
+
+        //! A public member function.
+        /*!
+            アンサンブルを設定する
+            \param ensemble 設定するアンサンブル
+        */
+        void setEnsemble(EnsembleType ensemble);
+
+        //! A public member function.
+        /*!
+            原子間力の計算に使うカーネルを設定する
+            実行中のCPUで使えないカーネルが指定されたときはスカラー版を使う
+            \param type カーネルの種類
+        */
+        void setForceKernel(ForceKernelType type);
+
+        //! A public member function.
+        /*!
+            スーパーセルの大きさを設定する
+            \param Nc スーパーセルの大きさ
+        */
+        void setNc(std::int32_t Nc);
+
+        //! A public member function.
+        /*!
+            圧力を設定する
+            \param Pgiven 設定する圧力（atm）
+        */
+        void setPgiven(double Pgiven);
+
+        //! A public member function.
+        /*!
+            原子間力の計算の精度を設定する
+            混合精度は、AVX2版・AVX-512版のカーネルで、箱の一辺がカットオフ半径の2倍より大きいときに使われる
+            （それ以外のカーネルと小さな箱では倍精度で計算する）
+            NVEアンサンブルでの全エネルギーの相対的なずれは、864原子・50000ステップ（50 K〜150 K）で
+            倍精度・混合精度とも1E-5未満（混合精度による力の誤差は相対値で2E-6程度）
+            \param precision 原子間力の計算の精度
+        */
+        void setPrecision(PrecisionType precision);
+
+        //! A public member function.
+        /*!
+            原子の配列を並べ替える間隔を設定する
+            ペアリストをinterval回作り直すごとに、原子を座標のMorton順（Z曲線）に並べ替え、
+            空間的に近い原子が配列の中でも近くに来るようにする
+            \param interval 並べ替える間隔（ペアリストを作り直す回数、0なら並べ替えない）
+        */
+        void setReorderInterval(std::int32_t interval);
+
+        //! A public member function.
+        /*!
+            物理量をサンプリングする間隔を設定する
+            MD_iterがintervalの倍数のステップでのみ、エネルギーとビリアルを計算する
+            （NPTアンサンブルではビリアルが、NVT・NPTアンサンブルでは運動エネルギーが毎ステップ必要なので、それらは常に計算する）
+            \param interval サンプリングする間隔（ステップ数）
+        */
+        void setSampleInterval(std::int32_t interval);
+
+        //! A public member function.
+        /*!
+            格子定数のスケールを設定する
+            \param scale 設定する格子定数のスケール
+        */
+        void setScale(double scale);
+
+        //! A public member function.
+        /*!
+            ペアリストのスキンの厚さを設定する
+            \param skin 設定するスキンの厚さ（0ならば毎ステップペアリストを作り直す）
+        */
+        void setSkin(double skin);
+
+        //! A public member function.
+        /*!
+            表による補間の区間の数を設定し、表を作り直す
+            \param size 区間の数
+        */
+        void setTableSize(std::int32_t size);
+
+        //! A public member function.
+        /*!
+            温度を設定する
+            \param Tgiven 設定する温度（絶対温度）
+        */
+        void setTgiven(double Tgiven);
+
+        //! A public member function.
+        /*!
+            温度制御の方法を設定する
+            \param type 温度制御の方法
+        */
+        void setThermostat(ThermostatType type);
+
+        // #endregion publicメンバ関数
+
+        // #region privateメンバ関数
+
+    private:
+        //! A private member function (constant).
+        /*!
+            周期境界条件を考慮して、座標の差を最も近いイメージとの差に補正する
+            \param dv 座標の差の一つの成分
+            \return 補正された座標の差
+        */
+        double adjust_periodic(double dv) const;
+
+        //! A private member function.
+        /*!
+            原子のペアリストから、ペアを一つでも含むクラスタ（CLUSTERSIZE個の連続する原子）のペアのリストを作る
+            （倍精度のSIMD版のカーネルだけが使うので、calculate_force_pair()で必要になったときに作る）
+        */
+        void build_cluster_pair();
+
+        //! A private member function.
+        /*!
+            現在の座標と周期境界条件の長さでペアリストを作り、作ったときの座標をr0_に保存する
+            （作り直すかどうかの判定と、原子の並べ替えはmake_pair()で行う）
+        */
+        void build_pair();
+
+        //! A private member function (constant).
+        /*!
+            [first, last)番目の原子のペアについて、原子に働く力を計算する
+            \param energy ポテンシャルエネルギーとビリアルも計算するならtrue
+            \param mixed 混合精度で計算するならtrue（mixed_を更新しておくこと）
+            \param first 最初の原子の番号
+            \param last 最後の原子の番号の次
+            \param fx 力のx成分を足し込む配列
+            \param fy 力のy成分を足し込む配列
+            \param fz 力のz成分を足し込む配列
+            \param Up ポテンシャルエネルギーを足し込む変数
+            \param virial ビリアルを足し込む変数
+        */
+        void calculate_force_range(bool energy, bool mixed, std::int32_t first, std::int32_t last, double * fx, double * fy, double * fz, double & Up, double & virial) const;
+
+        //! A private member function.
+        /*!
+            エネルギーの単位を無次元単位からHartreeに変換する
+            \param e 無次元単位で表されたエネルギー
+            \return Hartree単位で表されたエネルギー
+        */
+        double DimensionlessToHartree(double e) const;
+
+        //! A private member function (constant).
+        /*!
+            系の自由度を求める
+            重心の運動量が保存されるときは、その分の3を引く
+            \return 系の自由度
+        */
+        std::int32_t degrees_of_freedom() const;
+
+        //! A private member function.
+        /*!
+            原子の初期位置を決める
+        */
+        void MD_initPos();
+
+        //! A private member function.
+        /*!
+            原子の初期速度を決める
+        */
+        void MD_initVel();
+
+        //! A private member function.
+        /*!
+            格子定数が変更されたときに呼ばれる
+        */
+        void ModLattice();
+
+        //! A private member function.
+        /*!
+            原子を座標のMorton順に並べ替え、通し番号との対応を更新する
+        */
+        void reorder();
+
+        //! A private member function.
+        /*!
+            圧力制御により、箱の大きさと格子定数をs倍にする
+            座標のスケーリングはupdate_position()で行う
+            \param s 箱の大きさに掛ける係数
+        */
+        void rescale_box(double s);
+
+        //! A private member function (constant).
+        /*!
+            箱の体積を求める
+            \return 箱の体積（無次元単位）
+        */
+        double volume() const;
+
+        // #endregion privateメンバ関数
+
+        // #region プロパティ
+
+    public:
+        //! A property.
+        /*!
+            原子へのプロパティ
+        */
+        Property<Atoms const &> const atoms;
+
+        //! A property.
+        /*!
+            MDのステップ数へのプロパティ
+        */
+        Property<std::int32_t> const MD_iter;
+        
+        //! A property.
+        /*!
+            スーパーセルの個数へのプロパティ
+        */
+        Property<std::int32_t> const Nc;
+
+        //! A property.
+        /*!
+            原子数へのプロパティ
+        */
+        Property<std::int32_t> const NumAtom;
+
+        //! A property.
+        /*!
+            ペアリストを作り直した回数へのプロパティ
+        */
+        Property<std::int32_t> const NumRebuild;
+
+        //! A property.
+        /*!
+            格子定数へのプロパティ
+        */
+        Property<double> const periodiclen;
+        
+        //! A property.
+        /*!
+            運動エネルギーへのプロパティ
+        */
+        Property<double> const Uk;
+
+        //! A property.
+        /*!
+            ポテンシャルエネルギーへのプロパティ
+        */
+        Property<double> const Up;
+
+        //! A property.
+        /*!
+            全エネルギーへのプロパティ
+        */
+        Property<double> const Utot;
+
+        // #endregion プロパティ
+
+        // #region メンバ変数
+
+    public:
+        //! A private member variable (constant).
+        /*!
+            初期のスーパーセルの個数
+        */
+        static auto const FIRSTNC = 4;
+
+        //! A private member variable (constant).
+        /*!
+            初期の圧力（atm）
+        */
+        static double const FIRSTPRESSURE;
+
+        //! A public member variable (constant).
+        /*!
+            初期の原子の配列を並べ替える間隔（ペアリストを作り直す回数）
+        */
+        static std::int32_t const FIRSTREORDERINTERVAL = 10;
+
+        //! A private member variable (constant).
+        /*!
+            初期の格子定数のスケール
+        */
+        static double const FIRSTSCALE;
+
+        //! A private member variable (constant).
+        /*!
+            初期温度（絶対温度）
+        */
+        static double const FIRSTTEMP;
+
+        //! A private member variable (constant).
+        /*!
+            初期のペアリストのスキンの厚さ
+        */
+        static double const FIRSTSKIN;
+        
+        //! A private member variable (constant).
+        /*!
+            アルゴン原子に対するσ
+        */
+        static double const SIGMA;
+
+        //! A private member variable (constant).
+        /*!
+            アルゴン原子のVan der Waals半径
+        */
+        static double const VDW_RADIUS;
+
+    private:
+        //! A private member variable (constant).
+        /*!
+            標準気圧
+        */
+        static double const ATM;
+
+        //! A private member variable (constant).
+        /*!
+            アボガドロ定数
+        */
+        static double const AVOGADRO_CONSTANT;
+
+        //! A private member variable (constant).
+        /*!
+            時間刻みΔt
+        */
+        static double const DT;
+        
+        //! A private member variable (constant).
+        /*!
+            1Hartree
+        */
+        static double const HARTREE;
+        
+        //! A private member variable (constant).
+        /*!
+            ボルツマン定数
+        */
+        static double const KB;
+
+        //! A private member variable (constant).
+        /*!
+            Morton順を求めるときの、座標の一つの成分あたりのビット数
+        */
+        static std::int32_t const MORTONBITS = 10;
+
+        //! A private member variable (constant).
+        /*!
+            表による補間の誤差を求めるときの、一つの区間あたりの標本点の数
+        */
+        static std::int32_t const TABLESAMPLES = 16;
+
+        //! A private member variable (constant).
+        /*!
+            アルゴン原子に対するτ
+        */
+        static double const TAU;
+
+        //! A private member variable (constant).
+        /*!
+            アルゴン原子に対するε
+        */
+        static double const YPSILON;
+
+        //! A private member variable (constant).
+        /*!
+            スーパーセルの個数
+        */
+        std::int32_t Nc_ = Ar_moleculardynamics::FIRSTNC;
+        
+        //! A private member variable.
+        /*!
+            原子の可変長配列
+        */
+        Atoms atoms_;
+
+        //! A private member variable.
+        /*!
+            原子のペアリスト
+        */
+        PairList atom_pairs_;
+
+        //! A private member variable.
+        /*!
+            圧力制御を行うオブジェクト
+        */
+        Barostat barostat_;
+
+        //! A private member variable.
+        /*!
+            原子をセルに振り分けるオブジェクト
+        */
+        CellList celllist_;
+
+        //! A private member variable.
+        /*!
+            クラスタのペアリスト（空なら作り直す必要がある）
+        */
+        PairList cluster_pairs_;
+
+        //! A private member variable.
+        /*!
+            原子間力の計算に使うカーネル（CPUIDにより最も速いものを選ぶ）
+        */
+        ForceKernelType forcekernel_ = selectForceKernel();
+
+        //! A private member variable.
+        /*!
+            現在n番目にある原子の通し番号
+        */
+        std::vector<std::int32_t> ids_;
+
+        //! A private member variable.
+        /*!
+            通し番号がidの原子の、現在の番号
+        */
+        std::vector<std::int32_t> indices_;
+
+        //! A private member variable.
+        /*!
+            スレッドごとの力のバッファ
+        */
+        tbb::enumerable_thread_specific< std::vector<double, boost::alignment::aligned_allocator<double, 64> > > forcebuffers_;
+
+        //! A private member variable.
+        /*!
+            アンサンブル
+        */
+        EnsembleType ensemble_ = EnsembleType::NVT;
+
+        //! A private member variable.
+        /*!
+            格子定数
+        */
+        double lat_;
+
+        //! A private member variable.
+        /*!
+            ペアリストを作ったときの周期境界条件の長さ
+        */
+        double listlen_ = 1.0;
+
+        //! A private member variable.
+        /*!
+            表による補間で使う力とポテンシャルエネルギーの表
+        */
+        LJTable ljtable_;
+
+        //! A private member variable.
+        /*!
+            MDのステップ数
+        */
+        std::int32_t MD_iter_;
+
+        //! A private member variable.
+        /*!
+            混合精度の原子間力の計算で使う、単精度のセルの番号と相対座標
+        */
+        MixedPositions mixed_;
+
+        //! A private member variable (constant).
+        /*!
+            相互作用を計算するセルの個数
+        */
+        std::int32_t const ncp_ = 3;
+        
+        //! A private member variable.
+        /*!
+            ペアリストを作り直す必要があるかどうか
+        */
+        bool needrebuild_ = true;
+
+        //! A private member variable.
+        /*!
+            速度Verlet法を始める前に、初期配置での力を求める必要があるかどうか
+        */
+        bool needforce_ = true;
+
+        //! A private member variable.
+        /*!
+            ペアリストを作り直した回数
+        */
+        std::int32_t nrebuild_ = 0;
+
+        //! A private member variable.
+        /*!
+            ペアリストの統計を取り始めてからのステップ数
+        */
+        std::int32_t nstep_ = 0;
+
+        //! A private member variable.
+        /*!
+            原子数
+        */
+        std::int32_t NumAtom_;
+        
+        //! A private member variable.
+        /*!
+            周期境界条件の長さ
+        */
+        double periodiclen_;
+
+        //! A private member variable.
+        /*!
+            周期境界条件の長さの逆数（periodiclen_を変更したときに更新する）
+        */
+        double invperiodiclen_;
+
+        //! A private member variable.
+        /*!
+            与える圧力Pgiven（無次元単位）
+        */
+        double Pg_;
+
+        //! A private member variable.
+        /*!
+            原子間力の計算の精度
+        */
+        PrecisionType precision_ = PrecisionType::DOUBLE;
+
+        //! A private member variable (constant).
+        /*!
+            カットオフ半径
+        */
+        double const rc_ = 2.5;
+
+        //! A private member variable (constant).
+        /*!
+            カットオフ半径の2乗
+        */
+        double const rc2_;
+
+        //! A private member variable (constant).
+        /*!
+            カットオフ半径の逆数の6乗
+        */
+        double const rcm6_;
+
+        //! A private member variable (constant).
+        /*!
+            カットオフ半径の逆数の12乗
+        */
+        double const rcm12_;
+
+        //! A private member variable.
+        /*!
+            ペアリストを作ったときの原子の座標
+        */
+        std::vector<double, boost::alignment::aligned_allocator<double, 64> > r0_;
+
+        //! A private member variable.
+        /*!
+            原子の配列を並べ替える間隔（ペアリストを作り直す回数、0なら並べ替えない）
+        */
+        std::int32_t reorderinterval_ = Ar_moleculardynamics::FIRSTREORDERINTERVAL;
+
+        //! A private member variable.
+        /*!
+            物理量をサンプリングする間隔（ステップ数）
+        */
+        std::int32_t sampleinterval_ = 1;
+
+        //! A private member variable.
+        /*!
+            格子定数のスケーリングの定数
+        */
+        double scale_ = Ar_moleculardynamics::FIRSTSCALE;
+
+        //! A private member variable.
+        /*!
+            ペアリストのスキンの厚さ
+        */
+        double skin_ = Ar_moleculardynamics::FIRSTSKIN;
+        
+        //! A private member variable.
+        /*!
+            時間    
+        */
+        double t_;
+
+        //! A private member variable.
+        /*!
+            計算された温度Tcalc
+        */
+        double Tc_;
+
+        //! A private member variable.
+        /*!
+            与える温度Tgiven
+        */
+        double Tg_;
+
+        //! A private member variable.
+        /*!
+            温度制御を行うオブジェクト
+        */
+        Thermostat thermostat_;
+
+        //! A private member variable.
+        /*!
+            MDの各段階にかかった時間
+        */
+        Timings timings_;
+        
+        //! A private member variable (constant).
+        /*!
+            運動エネルギー
+        */
+        double Uk_;
+
+        //! A private member variable (constant).
+        /*!
+            ポテンシャルエネルギー
+        */
+        double Up_;
+
+        //! A private member variable (constant).
+        /*!
+            全エネルギー
+        */
+        double Utot_;
+
+        //! A private member variable (constant).
+        /*!
+            ビリアル
+        */
+        double virial_;
+
+        //! A private member variable (constant).
+        /*!
+            ポテンシャルエネルギーの打ち切り
+        */
+        double const Vrc_;
+
+        //! A private member variable.
+        /*!
+            次のステップの最初に速度に掛ける係数
+            Nosé-Hooverチェインの後半の半ステップのスケーリングは、余分なループを避けるために
+            次のステップのupdate_position()まで遅らせるので、atoms_の速度は実際の速度のこの値分の1になっている
+        */
+        double vscale_ = 1.0;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        Ar_moleculardynamics(Ar_moleculardynamics const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        Ar_moleculardynamics & operator=(Ar_moleculardynamics const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif      // _AR_MOLECULARDYNAMICS_H_
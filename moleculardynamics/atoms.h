@@ -0,0 +1,356 @@
+﻿/*! \file atoms.h
+    \brief 原子の座標・速度・力をStructure of Arrays形式で保持するクラスの宣言と実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _ATOMS_H_
+#define _ATOMS_H_
+
+#pragma once
+
+#include <cmath>                                // for std::sqrt
+#include <cstddef>                              // for std::size_t
+#include <cstdint>                              // for std::int32_t
+#include <vector>                               // for std::vector
+#include <boost/align/aligned_allocator.hpp>    // for boost::alignment::aligned_allocator
+#include <boost/assert.hpp>                     // for BOOST_ASSERT
+
+namespace moleculardynamics {
+    template <typename T>
+    //! A template class.
+    /*!
+        SoA形式の配列の中の一つの3次元ベクトル(x, y, z)を参照する軽量なクラス
+        \tparam T 要素の型（doubleまたはdouble const）
+    */
+    class Vector3View final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+            \param p x成分へのポインタ
+            \param stride x成分とy成分（y成分とz成分）の間隔
+        */
+        Vector3View(T * p, std::size_t stride) : p_(p), stride_(stride)
+        {
+        }
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~Vector3View() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region メンバ関数
+
+        //! A public member function (constant).
+        /*!
+            ベクトルの大きさを求める
+            \return ベクトルの大きさ
+        */
+        double norm() const
+        {
+            return std::sqrt(squaredNorm());
+        }
+
+        //! A public member function (constant).
+        /*!
+            operator[]()の実装
+            \param k 成分（0, 1, 2がそれぞれx, y, zに対応する）
+            \return 成分への参照
+        */
+        T & operator[](std::int32_t k) const
+        {
+            return p_[static_cast<std::size_t>(k) * stride_];
+        }
+
+        //! A public member function (constant).
+        /*!
+            ベクトルの大きさの2乗を求める
+            \return ベクトルの大きさの2乗
+        */
+        double squaredNorm() const
+        {
+            return (*this)[0] * (*this)[0] + (*this)[1] * (*this)[1] + (*this)[2] * (*this)[2];
+        }
+
+        // #endregion メンバ関数
+
+    private:
+        // #region メンバ変数
+
+        //! A private member variable.
+        /*!
+            x成分へのポインタ
+        */
+        T * p_;
+
+        //! A private member variable.
+        /*!
+            成分の間隔
+        */
+        std::size_t stride_;
+
+        // #endregion メンバ変数
+    };
+
+    template <typename T>
+    //! A template struct.
+    /*!
+        一つの原子の力・座標・速度を参照する軽量なクラス
+        \tparam T 要素の型（doubleまたはdouble const）
+    */
+    struct AtomView {
+        //! A public member variable.
+        /*!
+            力
+        */
+        Vector3View<T> f;
+
+        //! A public member variable.
+        /*!
+            座標
+        */
+        Vector3View<T> r;
+
+        //! A public member variable.
+        /*!
+            速度
+        */
+        Vector3View<T> v;
+    };
+
+    //! A class.
+    /*!
+        原子の力・座標・速度をStructure of Arrays形式で保持するクラス
+        全ての配列は一つの連続したバッファに、キャッシュラインの境界に揃えて配置される
+    */
+    class Atoms final {
+        // #region 列挙型
+
+    public:
+        //! A enumerated type
+        /*!
+            原子の物理量の種類
+        */
+        enum Quantity : std::int32_t {
+            F = 0,
+            R = 1,
+            V = 2,
+            NUMQUANTITY = 3
+        };
+
+        // #endregion 列挙型
+
+        // #region コンストラクタ・デストラクタ
+
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+            \param n 原子数
+        */
+        explicit Atoms(std::int32_t n)
+        {
+            resize(n);
+        }
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~Atoms() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region メンバ関数
+
+        //! A public member function.
+        /*!
+            物理量qのk成分の配列の先頭へのポインタを返す
+            \param q 物理量の種類
+            \param k 成分（0, 1, 2がそれぞれx, y, zに対応する）
+            \return 配列の先頭へのポインタ
+        */
+        double * data(Quantity q, std::int32_t k)
+        {
+            return data_.data() + static_cast<std::size_t>(q * 3 + k) * stride_;
+        }
+
+        //! A public member function (constant).
+        /*!
+            物理量qのk成分の配列の先頭へのポインタを返す
+            \param q 物理量の種類
+            \param k 成分（0, 1, 2がそれぞれx, y, zに対応する）
+            \return 配列の先頭へのポインタ
+        */
+        double const * data(Quantity q, std::int32_t k) const
+        {
+            return data_.data() + static_cast<std::size_t>(q * 3 + k) * stride_;
+        }
+
+        //! A public member function.
+        /*!
+            operator[]()の実装
+            \param n 原子の番号
+            \return n番目の原子を参照するオブジェクト
+        */
+        AtomView<double> operator[](std::int32_t n)
+        {
+            return { view(F, n), view(R, n), view(V, n) };
+        }
+
+        //! A public member function (constant).
+        /*!
+            operator[]()の実装
+            \param n 原子の番号
+            \return n番目の原子を参照するオブジェクト
+        */
+        AtomView<double const> operator[](std::int32_t n) const
+        {
+            return { view(F, n), view(R, n), view(V, n) };
+        }
+
+        //! A public member function.
+        /*!
+            原子を並べ替える（全ての物理量について、新しいn番目の原子を元のorder[n]番目の原子にする）
+            \param order 並べ替えた後の各位置に置く、元の原子の番号
+        */
+        void permute(std::vector<std::int32_t> const & order)
+        {
+            BOOST_ASSERT(order.size() == size());
+
+            std::vector<double, boost::alignment::aligned_allocator<double, 64> > permuted(data_.size(), 0.0);
+            for (auto c = std::size_t(0); c < 3 * Atoms::NUMQUANTITY; c++) {
+                auto const src = data_.data() + c * stride_;
+                auto const dst = permuted.data() + c * stride_;
+                for (auto n = 0; n < size_; n++) {
+                    dst[n] = src[order[n]];
+                }
+            }
+
+            data_.swap(permuted);
+        }
+
+        //! A public member function.
+        /*!
+            原子数を変更する（保持していた値は失われる）
+            \param n 原子数
+        */
+        void resize(std::int32_t n)
+        {
+            size_ = n;
+
+            // 各配列の先頭が64バイト境界に揃うように、配列の長さを8の倍数にする
+            stride_ = (static_cast<std::size_t>(n) + Atoms::ALIGNMENT - 1) / Atoms::ALIGNMENT * Atoms::ALIGNMENT;
+            data_.assign(stride_ * 3 * Atoms::NUMQUANTITY, 0.0);
+        }
+
+        //! A public member function (constant).
+        /*!
+            原子数を返す
+            \return 原子数
+        */
+        std::size_t size() const
+        {
+            return static_cast<std::size_t>(size_);
+        }
+
+        //! A public member function (constant).
+        /*!
+            配列の長さ（原子数を切り上げたもの）を返す
+            \return 配列の長さ
+        */
+        std::size_t stride() const
+        {
+            return stride_;
+        }
+
+    private:
+        //! A private member function.
+        /*!
+            n番目の原子の物理量qを参照するオブジェクトを返す
+            \param q 物理量の種類
+            \param n 原子の番号
+            \return 物理量を参照するオブジェクト
+        */
+        Vector3View<double> view(Quantity q, std::int32_t n)
+        {
+            return Vector3View<double>(data(q, 0) + n, stride_);
+        }
+
+        //! A private member function (constant).
+        /*!
+            n番目の原子の物理量qを参照するオブジェクトを返す
+            \param q 物理量の種類
+            \param n 原子の番号
+            \return 物理量を参照するオブジェクト
+        */
+        Vector3View<double const> view(Quantity q, std::int32_t n) const
+        {
+            return Vector3View<double const>(data(q, 0) + n, stride_);
+        }
+
+        // #endregion メンバ関数
+
+        // #region メンバ変数
+
+    public:
+        //! A public member variable (constant).
+        /*!
+            配列の長さの単位（64バイト = double 8個）
+        */
+        static std::size_t const ALIGNMENT = 8;
+
+    private:
+        //! A private member variable.
+        /*!
+            全ての物理量を格納するバッファ
+        */
+        std::vector<double, boost::alignment::aligned_allocator<double, 64> > data_;
+
+        //! A private member variable.
+        /*!
+            原子数
+        */
+        std::int32_t size_ = 0;
+
+        //! A private member variable.
+        /*!
+            配列の長さ
+        */
+        std::size_t stride_ = 0;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        Atoms() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        Atoms(Atoms const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        Atoms & operator=(Atoms const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif      // _ATOMS_H_
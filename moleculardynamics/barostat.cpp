@@ -0,0 +1,166 @@
+﻿/*! \file barostat.cpp
+    \brief NPTアンサンブルの圧力制御を行うクラスの実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "barostat.h"
+#include <cmath>                // for std::cbrt, std::exp, std::sinh
+#include <limits>               // for std::numeric_limits
+#include <sstream>              // for std::istringstream, std::ostringstream
+#include <boost/assert.hpp>     // for BOOST_ASSERT
+
+namespace moleculardynamics {
+    // #region static public 定数
+
+    double const Barostat::COMPRESSIBILITY = 0.05;
+
+    double const Barostat::FIRSTTAU = 1.0;
+
+    // #endregion static public 定数
+
+    // #region コンストラクタ
+
+    Barostat::Barostat()
+    {
+        reset();
+    }
+
+    // #endregion コンストラクタ
+
+    // #region publicメンバ関数
+
+    BarostatScale Barostat::begin_step(double Uk, double virial, double V, double Pg, double Tg, std::int32_t nf, double dt)
+    {
+        switch (type_) {
+        case BarostatType::BERENDSEN:
+        {
+            // V' = V[1 - κΔt / τ (Pg - P)]
+            auto const P = (2.0 * Uk + virial) / (3.0 * V);
+            BarostatScale const bs = { 1.0, std::cbrt(1.0 - Barostat::COMPRESSIBILITY * dt / tau_ * (Pg - P)), 1.0 };
+            return bs;
+        }
+
+        case BarostatType::MTK:
+        {
+            mtk_halfstep(Uk, virial, V, Pg, Tg, nf, dt);
+
+            // 速度はexp(-(1 + 3 / nf)vΔt / 2)倍、座標と箱はexp(vΔt)倍になる
+            // 座標の更新の速度の項は、exp(vΔt / 2)sinh(vΔt / 2) / (vΔt / 2)倍
+            auto const alpha = 1.0 + 3.0 / static_cast<double>(nf);
+            auto const x = 0.5 * veps_ * dt;
+            BarostatScale const bs = {
+                std::exp(-alpha * x),
+                std::exp(2.0 * x),
+                std::exp(x) * (x != 0.0 ? std::sinh(x) / x : 1.0)
+            };
+            return bs;
+        }
+
+        default:
+        {
+            BOOST_ASSERT(!"何かがおかしい！");
+            BarostatScale const bs = { 1.0, 1.0, 1.0 };
+            return bs;
+        }
+        }
+    }
+
+    double Barostat::end_step(double Uk, double virial, double V, double Pg, double Tg, std::int32_t nf, double dt)
+    {
+        if (type_ != BarostatType::MTK) {
+            return 1.0;
+        }
+
+        // 速度をスケーリングしてからピストンの速度を更新する（begin_step()と逆の順序）
+        auto const alpha = 1.0 + 3.0 / static_cast<double>(nf);
+        auto const s = std::exp(-alpha * 0.5 * veps_ * dt);
+        mtk_halfstep(Uk * s * s, virial, V, Pg, Tg, nf, dt);
+
+        return s;
+    }
+
+    double Barostat::energy(double V, double Pg, double Tg, std::int32_t nf) const
+    {
+        return type_ == BarostatType::MTK ? Pg * V + 0.5 * mass(Tg, nf) * veps_ * veps_ : 0.0;
+    }
+
+    double Barostat::getTau() const
+    {
+        return tau_;
+    }
+
+    BarostatType Barostat::getType() const
+    {
+        return type_;
+    }
+
+    bool Barostat::loadState(std::string const & state)
+    {
+        std::istringstream is(state);
+
+        std::int32_t type;
+        double tau, veps;
+        is >> type >> tau >> veps;
+
+        if (!is || type < static_cast<std::int32_t>(BarostatType::BERENDSEN) || type > static_cast<std::int32_t>(BarostatType::MTK) || !(tau > 0.0)) {
+            return false;
+        }
+
+        type_ = static_cast<BarostatType>(type);
+        tau_ = tau;
+        veps_ = veps;
+
+        return true;
+    }
+
+    void Barostat::reset()
+    {
+        veps_ = 0.0;
+    }
+
+    std::string Barostat::saveState() const
+    {
+        // 読み込んだときに同じ値に戻るだけの桁数で書き出す
+        std::ostringstream os;
+        os.precision(std::numeric_limits<double>::max_digits10);
+        os << static_cast<std::int32_t>(type_) << ' ' << tau_ << ' ' << veps_;
+
+        return os.str();
+    }
+
+    void Barostat::setTau(double tau)
+    {
+        BOOST_ASSERT(tau > 0.0);
+
+        tau_ = tau;
+    }
+
+    void Barostat::setType(BarostatType type)
+    {
+        type_ = type;
+        reset();
+    }
+
+    // #endregion publicメンバ関数
+
+    // #region privateメンバ関数
+
+    void Barostat::mtk_halfstep(double Uk, double virial, double V, double Pg, double Tg, std::int32_t nf, double dt)
+    {
+        BOOST_ASSERT(Tg > 0.0);
+
+        // ピストンに働く「力」は(1 + 3 / nf)2Uk + W - 3VPg
+        auto const alpha = 1.0 + 3.0 / static_cast<double>(nf);
+        auto const g = alpha * 2.0 * Uk + virial - 3.0 * V * Pg;
+        veps_ += 0.5 * dt * g / mass(Tg, nf);
+    }
+
+    double Barostat::mass(double Tg, std::int32_t nf) const
+    {
+        return static_cast<double>(nf + 3) * Tg * tau_ * tau_;
+    }
+
+    // #endregion privateメンバ関数
+}
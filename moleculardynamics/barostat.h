@@ -0,0 +1,252 @@
+﻿/*! \file barostat.h
+    \brief NPTアンサンブルの圧力制御を行うクラスの宣言
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _BAROSTAT_H_
+#define _BAROSTAT_H_
+
+#pragma once
+
+#include <cstdint>  // for std::int32_t
+#include <string>   // for std::string
+
+namespace moleculardynamics {
+    //! A enumerated type
+    /*!
+        圧力制御の方法
+    */
+    enum class BarostatType : std::int32_t {
+        // Berendsenの座標スケーリング
+        BERENDSEN = 0,
+        // Martyna-Tobias-Klein（MTK）
+        MTK = 1
+    };
+
+    //! A struct.
+    /*!
+        速度Verlet法の最初のループで、速度と座標に掛ける係数
+        座標はr' = rscale * r + drift * Δt * vで更新する
+    */
+    struct BarostatScale {
+        //! A public member variable.
+        /*!
+            速度に掛ける係数
+        */
+        double vscale;
+
+        //! A public member variable.
+        /*!
+            座標と箱の大きさに掛ける係数
+        */
+        double rscale;
+
+        //! A public member variable.
+        /*!
+            座標の更新で速度に掛ける係数
+        */
+        double drift;
+    };
+
+    //! A class.
+    /*!
+        速度Verlet法に組み込む等方的な圧力制御のクラス
+        Thermostatと同様に、このクラスは係数を求めるだけで、原子のループを持たない
+        圧力は運動エネルギーUkとビリアルWから、P = (2Uk + W) / (3V)で求める
+    */
+    class Barostat final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+        */
+        Barostat();
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~Barostat() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region メンバ関数
+
+        //! A public member function.
+        /*!
+            速度Verlet法の最初のループの前に、速度と座標に掛ける係数を求める
+            \param Uk 現在の運動エネルギー（無次元単位）
+            \param virial 現在のビリアル（無次元単位）
+            \param V 現在の体積（無次元単位）
+            \param Pg 与える圧力（無次元単位）
+            \param Tg 与える温度（無次元単位）
+            \param nf 自由度
+            \param dt 時間刻み
+            \return 速度と座標に掛ける係数
+        */
+        BarostatScale begin_step(double Uk, double virial, double V, double Pg, double Tg, std::int32_t nf, double dt);
+
+        //! A public member function.
+        /*!
+            速度Verlet法の最後の速度の更新の後に、全ての原子の速度に掛ける係数を求める
+            MTKの後半の半ステップに対応し、Berendsenでは1を返す
+            \param Uk 現在の運動エネルギー（無次元単位）
+            \param virial 現在のビリアル（無次元単位）
+            \param V 現在の体積（無次元単位）
+            \param Pg 与える圧力（無次元単位）
+            \param Tg 与える温度（無次元単位）
+            \param nf 自由度
+            \param dt 時間刻み
+            \return 速度に掛ける係数
+        */
+        double end_step(double Uk, double virial, double V, double Pg, double Tg, std::int32_t nf, double dt);
+
+        //! A public member function (constant).
+        /*!
+            MTKのピストンのエネルギーを求める
+            系の全エネルギーとの和が保存量になる（Berendsenでは0を返す）
+            \param V 現在の体積（無次元単位）
+            \param Pg 与える圧力（無次元単位）
+            \param Tg 与える温度（無次元単位）
+            \param nf 自由度
+            \return ピストンのエネルギーPV + Wv^2 / 2（無次元単位）
+        */
+        double energy(double V, double Pg, double Tg, std::int32_t nf) const;
+
+        //! A public member function (constant).
+        /*!
+            圧力制御の緩和時間を求める
+            \return 緩和時間（無次元単位）
+        */
+        double getTau() const;
+
+        //! A public member function (constant).
+        /*!
+            圧力制御の方法を求める
+            \return 圧力制御の方法
+        */
+        BarostatType getType() const;
+
+        //! A public member function.
+        /*!
+            saveState()で書き出した状態を読み込む
+            読み込めなかったときは状態を変えない
+            \param state 状態を表す文字列
+            \return 読み込めたらtrue
+        */
+        bool loadState(std::string const & state);
+
+        //! A public member function.
+        /*!
+            ピストンの状態を初期化する
+        */
+        void reset();
+
+        //! A public member function (constant).
+        /*!
+            チェックポイントに保存するために、制御の方法、緩和時間とピストンの状態を文字列に書き出す
+            \return 状態を表す文字列
+        */
+        std::string saveState() const;
+
+        //! A public member function.
+        /*!
+            圧力制御の緩和時間を設定する
+            Berendsenの緩和時間、MTKのピストンの周期に使う
+            \param tau 緩和時間（無次元単位）
+        */
+        void setTau(double tau);
+
+        //! A public member function.
+        /*!
+            圧力制御の方法を設定する
+            \param type 圧力制御の方法
+        */
+        void setType(BarostatType type);
+
+    private:
+        //! A private member function.
+        /*!
+            MTKのピストンの速度を半ステップ分時間発展させる
+            \param Uk 現在の運動エネルギー（無次元単位）
+            \param virial 現在のビリアル（無次元単位）
+            \param V 現在の体積（無次元単位）
+            \param Pg 与える圧力（無次元単位）
+            \param Tg 与える温度（無次元単位）
+            \param nf 自由度
+            \param dt 時間刻み
+        */
+        void mtk_halfstep(double Uk, double virial, double V, double Pg, double Tg, std::int32_t nf, double dt);
+
+        //! A private member function (constant).
+        /*!
+            MTKのピストンの質量を求める
+            \param Tg 与える温度（無次元単位）
+            \param nf 自由度
+            \return ピストンの質量
+        */
+        double mass(double Tg, std::int32_t nf) const;
+
+        // #endregion メンバ関数
+
+        // #region メンバ変数
+
+    public:
+        //! A public member variable (constant).
+        /*!
+            Berendsenの方法で使う等温圧縮率（無次元単位）
+        */
+        static double const COMPRESSIBILITY;
+
+        //! A public member variable (constant).
+        /*!
+            初期の緩和時間（無次元単位）
+        */
+        static double const FIRSTTAU;
+
+    private:
+        //! A private member variable.
+        /*!
+            緩和時間
+        */
+        double tau_ = Barostat::FIRSTTAU;
+
+        //! A private member variable.
+        /*!
+            圧力制御の方法
+        */
+        BarostatType type_ = BarostatType::BERENDSEN;
+
+        //! A private member variable.
+        /*!
+            MTKのピストンの速度（体積の対数の1/3の時間微分）
+        */
+        double veps_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        Barostat(Barostat const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        Barostat & operator=(Barostat const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif      // _BAROSTAT_H_
@@ -0,0 +1,83 @@
+﻿/*! \file celllist.cpp
+    \brief 原子をセルに振り分ける（linked-cell法）クラスの実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "celllist.h"
+#include <algorithm>    // for std::fill
+#include <cmath>        // for std::floor
+
+namespace moleculardynamics {
+    // #region publicメンバ関数
+
+    std::int32_t CellList::cellindex(double x, double y, double z) const
+    {
+        auto const index = [this](double r) {
+            auto i = static_cast<std::int32_t>(std::floor(r * invcelllen_)) % ncell_;
+
+            // 箱の外側にある座標は周期境界条件で箱の中に戻す
+            if (i < 0) {
+                i += ncell_;
+            }
+
+            return i;
+        };
+
+        return (index(x) * ncell_ + index(y)) * ncell_ + index(z);
+    }
+
+    void CellList::clear()
+    {
+        std::fill(head_.begin(), head_.end(), -1);
+    }
+
+    bool CellList::setup(std::int32_t numatom, double periodiclen, double rcut)
+    {
+        cell_.resize(numatom);
+        next_.resize(numatom);
+
+        auto const ncell = static_cast<std::int32_t>(std::floor(periodiclen / rcut));
+        if (ncell < CellList::MINCELL) {
+            ncell_ = 0;
+            return false;
+        }
+
+        invcelllen_ = static_cast<double>(ncell) / periodiclen;
+
+        if (ncell == ncell_) {
+            return true;
+        }
+
+        ncell_ = ncell;
+        head_.resize(ncell_ * ncell_ * ncell_);
+        neighbors_.resize(ncell_ * ncell_ * ncell_);
+
+        // 各セルに対して、自分自身と周囲の26個のセルの番号を求めておく
+        // 一辺あたりのセルの個数が3以上なので、これらのセルは全て異なる
+        for (auto i = 0; i < ncell_; i++) {
+            for (auto j = 0; j < ncell_; j++) {
+                for (auto k = 0; k < ncell_; k++) {
+                    auto const c = (i * ncell_ + j) * ncell_ + k;
+                    auto m = 0;
+
+                    for (auto di = -1; di <= 1; di++) {
+                        for (auto dj = -1; dj <= 1; dj++) {
+                            for (auto dk = -1; dk <= 1; dk++) {
+                                auto const ii = (i + di + ncell_) % ncell_;
+                                auto const jj = (j + dj + ncell_) % ncell_;
+                                auto const kk = (k + dk + ncell_) % ncell_;
+                                neighbors_[c][m++] = (ii * ncell_ + jj) * ncell_ + kk;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // #endregion publicメンバ関数
+}
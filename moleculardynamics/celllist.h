@@ -0,0 +1,196 @@
+﻿/*! \file celllist.h
+    \brief 原子をセルに振り分ける（linked-cell法）クラスの宣言
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _CELLLIST_H_
+#define _CELLLIST_H_
+
+#pragma once
+
+#include <array>    // for std::array
+#include <cstdint>  // for std::int32_t
+#include <vector>   // for std::vector
+
+namespace moleculardynamics {
+    //! A class.
+    /*!
+        周期境界条件の箱をカットオフ半径以上の大きさのセルに分割し、
+        各原子をセルに振り分けるクラス（linked-cell法）
+    */
+    class CellList final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            デフォルトコンストラクタ
+        */
+        CellList() = default;
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~CellList() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region publicメンバ関数
+
+        //! A public member function (constant).
+        /*!
+            座標からその座標が属するセルの番号を求める
+            \param x x座標
+            \param y y座標
+            \param z z座標
+            \return セルの番号
+        */
+        std::int32_t cellindex(double x, double y, double z) const;
+
+        //! A public member function.
+        /*!
+            全てのセルを空にする
+        */
+        void clear();
+
+        //! A public member function (constant).
+        /*!
+            セルの先頭の原子の番号を求める
+            \param c セルの番号
+            \return セルの先頭の原子の番号（セルが空なら-1）
+        */
+        std::int32_t head(std::int32_t c) const
+        {
+            return head_[c];
+        }
+
+        //! A public member function.
+        /*!
+            n番目の原子をセルcに登録する
+            \param n 原子の番号
+            \param c セルの番号
+        */
+        void insert(std::int32_t n, std::int32_t c)
+        {
+            cell_[n] = c;
+            next_[n] = head_[c];
+            head_[c] = n;
+        }
+
+        //! A public member function (constant).
+        /*!
+            n番目の原子が属するセルの番号を求める
+            \param n 原子の番号
+            \return セルの番号
+        */
+        std::int32_t cell(std::int32_t n) const
+        {
+            return cell_[n];
+        }
+
+        //! A public member function (constant).
+        /*!
+            セルcとその周囲の26個のセルの番号を求める
+            \param c セルの番号
+            \return セルcとその周囲のセルの番号
+        */
+        std::array<std::int32_t, 27> const & neighbors(std::int32_t c) const
+        {
+            return neighbors_[c];
+        }
+
+        //! A public member function (constant).
+        /*!
+            同じセルに属する次の原子の番号を求める
+            \param n 原子の番号
+            \return 次の原子の番号（存在しなければ-1）
+        */
+        std::int32_t next(std::int32_t n) const
+        {
+            return next_[n];
+        }
+
+        //! A public member function.
+        /*!
+            セルの分割を設定する
+            \param numatom 原子数
+            \param periodiclen 周期境界条件の長さ
+            \param rcut セルの一辺の最小値（カットオフ半径）
+            \return 一辺あたりのセルの個数が3以上でlinked-cell法が使えるならtrue
+        */
+        bool setup(std::int32_t numatom, double periodiclen, double rcut);
+
+        // #endregion publicメンバ関数
+
+        // #region メンバ変数
+
+    public:
+        //! A public member variable (constant).
+        /*!
+            linked-cell法を使うのに必要な一辺あたりのセルの最小個数
+        */
+        static std::int32_t const MINCELL = 3;
+
+    private:
+        //! A private member variable.
+        /*!
+            各原子が属するセルの番号
+        */
+        std::vector<std::int32_t> cell_;
+
+        //! A private member variable.
+        /*!
+            各セルの先頭の原子の番号
+        */
+        std::vector<std::int32_t> head_;
+
+        //! A private member variable.
+        /*!
+            セルの一辺の長さの逆数
+        */
+        double invcelllen_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            一辺あたりのセルの個数
+        */
+        std::int32_t ncell_ = 0;
+
+        //! A private member variable.
+        /*!
+            各セルとその周囲のセルの番号
+        */
+        std::vector< std::array<std::int32_t, 27> > neighbors_;
+
+        //! A private member variable.
+        /*!
+            同じセルに属する次の原子の番号
+        */
+        std::vector<std::int32_t> next_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        CellList(CellList const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        CellList & operator=(CellList const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif      // _CELLLIST_H_
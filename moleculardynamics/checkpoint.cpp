@@ -0,0 +1,135 @@
+﻿/*! \file checkpoint.cpp
+    \brief シミュレーションの状態を保存するチェックポイントファイルの形式の実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "checkpoint.h"
+#include "atoms.h"
+#include <array>    // for std::array
+#include <cstring>  // for std::memcmp, std::memcpy
+
+namespace moleculardynamics {
+    // #region static public 定数
+
+    char const CheckpointHeader::MAGIC[8] = { 'L', 'J', 'M', 'D', 'C', 'K', 'P', 'T' };
+
+    // #endregion static public 定数
+
+    namespace {
+        //! A global variable (constant).
+        /*!
+            チェックサムで値を混ぜるための奇数の定数
+        */
+        std::uint64_t const PRIME1 = 0x9E3779B185EBCA87ULL;
+
+        //! A global variable (constant).
+        /*!
+            チェックサムで値を混ぜるための奇数の定数
+        */
+        std::uint64_t const PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+
+        //! A function.
+        /*!
+            64ビットの値を左に回転する
+            \param x 値
+            \param r 回転するビット数（0 < r < 64）
+            \return 回転した値
+        */
+        inline std::uint64_t rotl(std::uint64_t x, std::int32_t r)
+        {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        //! A function.
+        /*!
+            チェックサムの系列に64ビットの値を一つ混ぜる
+            \param acc 系列の現在の値
+            \param word 混ぜる値
+            \return 系列の新しい値
+        */
+        inline std::uint64_t mix(std::uint64_t acc, std::uint64_t word)
+        {
+            return rotl(acc + word * PRIME2, 31) * PRIME1;
+        }
+    }
+
+    std::uint64_t checkpoint_checksum(void const * data, std::size_t size)
+    {
+        auto p = static_cast<unsigned char const *>(data);
+        auto const end = p + size;
+
+        // 4本の系列は互いに依存しないので、乗算の待ち時間が重なる
+        std::array<std::uint64_t, 4> acc = { PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1 };
+        for (; end - p >= 32; p += 32) {
+            for (auto i = 0; i < 4; i++) {
+                std::uint64_t word;
+                std::memcpy(&word, p + 8 * i, sizeof(word));
+                acc[i] = mix(acc[i], word);
+            }
+        }
+
+        auto h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18) + static_cast<std::uint64_t>(size);
+
+        // 32バイトに満たない残りは1本の系列に混ぜる
+        for (; end - p >= 8; p += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            h = mix(h, word);
+        }
+
+        for (; p != end; ++p) {
+            h = (h ^ *p) * PRIME1;
+        }
+
+        // 上位のビットの違いが下位のビットにも広がるようにする
+        h ^= h >> 33;
+        h *= PRIME2;
+        h ^= h >> 29;
+        h *= PRIME1;
+        h ^= h >> 32;
+
+        return h;
+    }
+
+    bool checkpoint_header_valid(CheckpointHeader const & header, std::size_t filesize)
+    {
+        if (filesize < sizeof(CheckpointHeader) ||
+            std::memcmp(header.magic, CheckpointHeader::MAGIC, sizeof(header.magic)) != 0 ||
+            header.endian != CheckpointHeader::ENDIAN ||
+            header.version != CheckpointHeader::VERSION) {
+            return false;
+        }
+
+        // 原子数は常に4Nc^3で、一つの成分の長さは原子数以上
+        if (header.Nc <= 0 ||
+            header.Nc > 1024 ||
+            static_cast<std::int64_t>(header.NumAtom) != 4 * static_cast<std::int64_t>(header.Nc) * header.Nc * header.Nc ||
+            header.stride < static_cast<std::uint64_t>(header.NumAtom)) {
+            return false;
+        }
+
+        // ペアリストを作った回数などは負にならず、ペアリストを作ったときの箱の長さは0（リスト無し）か正
+        if (header.nrebuild < 0 || header.nstep < 0 || !(header.listlen >= 0.0)) {
+            return false;
+        }
+
+        // 大きさの和が桁あふれしないように、それぞれがファイルより小さいことを先に確かめる
+        if (header.stride > filesize || header.thermostatsize > filesize || header.barostatsize > filesize) {
+            return false;
+        }
+
+        return header.payloadsize == checkpoint_payload_size(header) &&
+            header.payloadsize == static_cast<std::uint64_t>(filesize - sizeof(CheckpointHeader));
+    }
+
+    std::uint64_t checkpoint_payload_size(CheckpointHeader const & header)
+    {
+        return header.stride * 3 * Atoms::NUMQUANTITY * sizeof(double) +
+            static_cast<std::uint64_t>(header.NumAtom) * sizeof(std::int32_t) +
+            header.stride * 3 * sizeof(double) +
+            header.thermostatsize +
+            header.barostatsize;
+    }
+}
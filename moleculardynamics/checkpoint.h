@@ -0,0 +1,242 @@
+﻿/*! \file checkpoint.h
+    \brief シミュレーションの状態を保存するチェックポイントファイルの形式の宣言
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#pragma once
+
+#include <cstddef>      // for std::size_t
+#include <cstdint>      // for std::int32_t, std::uint32_t, std::uint64_t
+#include <type_traits>  // for std::is_trivially_copyable
+
+namespace moleculardynamics {
+    //! A struct.
+    /*!
+        チェックポイントファイルの先頭に置くヘッダ
+        ヘッダの後ろには、原子の配列（Atomsのバッファ全体）、通し番号（int32をNumAtom個）、
+        ペアリストを作ったときの座標（stride個ずつ3成分）、熱浴の状態、ピストンの状態（どちらもテキスト）が
+        この順に隙間なく続く
+        ファイルにはこの構造体をそのまま書き込むので、メンバはファイルの中の並びの順に置く
+        物理量は全て無次元単位
+    */
+    struct CheckpointHeader {
+        //! A public member variable.
+        /*!
+            ファイルの種類を示す文字列（MAGIC）
+        */
+        char magic[8];
+
+        //! A public member variable.
+        /*!
+            バイトオーダーを示す値（ENDIANを書いたマシンのバイトオーダーで書き込む）
+        */
+        std::uint32_t endian;
+
+        //! A public member variable.
+        /*!
+            ファイルの形式の版（VERSION）
+        */
+        std::uint32_t version;
+
+        //! A public member variable.
+        /*!
+            ヘッダの後ろのデータのチェックサム
+        */
+        std::uint64_t checksum;
+
+        //! A public member variable.
+        /*!
+            ヘッダの後ろのデータのバイト数
+        */
+        std::uint64_t payloadsize;
+
+        //! A public member variable.
+        /*!
+            スーパーセルの個数
+        */
+        std::int32_t Nc;
+
+        //! A public member variable.
+        /*!
+            原子数
+        */
+        std::int32_t NumAtom;
+
+        //! A public member variable.
+        /*!
+            MDのステップ数
+        */
+        std::int32_t MD_iter;
+
+        //! A public member variable.
+        /*!
+            アンサンブル（EnsembleTypeの値）
+        */
+        std::int32_t ensemble;
+
+        //! A public member variable.
+        /*!
+            これまでにペアリストを作った回数（原子を並べ替える周期の位相になる）
+        */
+        std::int32_t nrebuild;
+
+        //! A public member variable.
+        /*!
+            これまでにmake_pair()を呼んだ回数
+        */
+        std::int32_t nstep;
+
+        //! A public member variable.
+        /*!
+            原子の配列の一つの成分の長さ（Atoms::stride()）
+        */
+        std::uint64_t stride;
+
+        //! A public member variable.
+        /*!
+            熱浴の状態のバイト数
+        */
+        std::uint64_t thermostatsize;
+
+        //! A public member variable.
+        /*!
+            ピストンの状態のバイト数
+        */
+        std::uint64_t barostatsize;
+
+        //! A public member variable.
+        /*!
+            経過時間
+        */
+        double t;
+
+        //! A public member variable.
+        /*!
+            格子定数
+        */
+        double lat;
+
+        //! A public member variable.
+        /*!
+            格子定数のスケール
+        */
+        double scale;
+
+        //! A public member variable.
+        /*!
+            周期境界条件の長さ
+        */
+        double periodiclen;
+
+        //! A public member variable.
+        /*!
+            ペアリストを作ったときの周期境界条件の長さ（ペアリストが無ければ0）
+        */
+        double listlen;
+
+        //! A public member variable.
+        /*!
+            与えた温度
+        */
+        double Tg;
+
+        //! A public member variable.
+        /*!
+            与えた圧力
+        */
+        double Pg;
+
+        //! A public member variable.
+        /*!
+            運動エネルギー
+        */
+        double Uk;
+
+        //! A public member variable.
+        /*!
+            ポテンシャルエネルギー
+        */
+        double Up;
+
+        //! A public member variable.
+        /*!
+            全エネルギー
+        */
+        double Utot;
+
+        //! A public member variable.
+        /*!
+            計算された温度
+        */
+        double Tc;
+
+        //! A public member variable.
+        /*!
+            ビリアル
+        */
+        double virial;
+
+        //! A public member variable.
+        /*!
+            次のステップまで遅らせている速度のスケーリングの係数
+            （原子の配列の速度にはまだ掛かっていない）
+        */
+        double vscale;
+
+        //! A public member variable (constant).
+        /*!
+            バイトオーダーを示す値
+        */
+        static std::uint32_t const ENDIAN = 0x01020304;
+
+        //! A public member variable (constant).
+        /*!
+            ファイルの種類を示す文字列
+        */
+        static char const MAGIC[8];
+
+        //! A public member variable (constant).
+        /*!
+            ファイルの形式の版
+        */
+        static std::uint32_t const VERSION = 2;
+    };
+
+    static_assert(std::is_trivially_copyable<CheckpointHeader>::value, "CheckpointHeader must be written to the file as it is");
+    static_assert(sizeof(CheckpointHeader) == 184, "CheckpointHeader must not contain padding");
+
+    //! A function.
+    /*!
+        チェックポイントファイルのデータのチェックサムを求める
+        64ビットずつ4本の系列に分けて混ぜるので、大きなデータでもメモリの帯域に近い速さで求まる
+        \param data データの先頭
+        \param size データのバイト数
+        \return チェックサム
+    */
+    std::uint64_t checkpoint_checksum(void const * data, std::size_t size);
+
+    //! A function.
+    /*!
+        チェックポイントファイルのヘッダが、このプログラムで読める正しいものかどうか調べる
+        （チェックサムは調べない）
+        \param header ヘッダ
+        \param filesize ファイルのバイト数
+        \return 読めるならtrue
+    */
+    bool checkpoint_header_valid(CheckpointHeader const & header, std::size_t filesize);
+
+    //! A function.
+    /*!
+        ヘッダに書かれた大きさから、ヘッダの後ろのデータのバイト数を求める
+        \param header ヘッダ
+        \return ヘッダの後ろのデータのバイト数
+    */
+    std::uint64_t checkpoint_payload_size(CheckpointHeader const & header);
+}
+
+#endif      // _CHECKPOINT_H_
@@ -0,0 +1,320 @@
+﻿/*! \file compressedtrajectory.cpp
+    \brief 座標を固定精度に量子化し、前のフレームとの差をビット詰めして圧縮するトラジェクトリ形式の実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "compressedtrajectory.h"
+#include "../utility/binaryio.h"
+#include <algorithm>            // for std::min
+#include <array>                // for std::array
+#include <cmath>                // for std::floor
+#include <cstddef>              // for std::size_t
+#include <cstring>              // for std::memcmp
+#include <boost/assert.hpp>     // for BOOST_ASSERT
+
+namespace moleculardynamics {
+    namespace {
+        //! A global variable (constant).
+        /*!
+            ブロックの原子数
+        */
+        std::int32_t const BLOCK = 64;
+
+        //! A global variable (constant).
+        /*!
+            ブロックのビット数を表すのに使うビット数
+        */
+        std::int32_t const WIDTHBITS = 6;
+
+        //! A global variable (constant).
+        /*!
+            ファイルの先頭の文字列
+        */
+        char const MAGIC[8] = { 'L', 'J', 'M', 'D', 'C', 'T', 'R', 'J' };
+
+        //! A global variable (constant).
+        /*!
+            ファイルの形式の版
+        */
+        std::uint32_t const VERSION = 1;
+
+        //! A function.
+        /*!
+            値を表すのに必要なビット数を求める
+            \param v 値
+            \return ビット数（v = 0なら0）
+        */
+        std::int32_t bit_width(std::uint32_t v)
+        {
+            auto w = 0;
+            for (; v != 0; v >>= 1) {
+                w++;
+            }
+
+            return w;
+        }
+
+        //! A function.
+        /*!
+            量子化した座標の差を、周期境界条件に合わせて[-2^(bits - 1), 2^(bits - 1))に直してからzigzag符号化する
+            \param q 量子化した座標
+            \param p 前のフレームの量子化した座標
+            \param bits 量子化のビット数
+            \return 符号化した差（2^bits未満）
+        */
+        std::uint32_t encode_delta(std::uint32_t q, std::uint32_t p, std::int32_t bits)
+        {
+            auto const mask = (1U << bits) - 1U;
+            auto d = static_cast<std::int32_t>((q - p) & mask);
+            if (d >= static_cast<std::int32_t>(1U << (bits - 1))) {
+                d -= static_cast<std::int32_t>(1U << bits);
+            }
+
+            // 0, -1, 1, -2, 2, ...を0, 1, 2, 3, 4, ...に写す
+            return (static_cast<std::uint32_t>(d) << 1) ^ static_cast<std::uint32_t>(d >> 31);
+        }
+
+        //! A function.
+        /*!
+            encode_delta()の逆の変換で、量子化した座標を求める
+            \param z 符号化した差
+            \param p 前のフレームの量子化した座標
+            \param bits 量子化のビット数
+            \return 量子化した座標
+        */
+        std::uint32_t decode_delta(std::uint32_t z, std::uint32_t p, std::int32_t bits)
+        {
+            auto const mask = (1U << bits) - 1U;
+            auto const d = (z >> 1) ^ (0U - (z & 1U));
+            return (p + d) & mask;
+        }
+    }
+
+    // #region コンストラクタ
+
+    CompressedTrajectoryEncoder::CompressedTrajectoryEncoder(std::int32_t bits)
+        : bits_(bits)
+    {
+        BOOST_ASSERT(bits >= CompressedTrajectoryEncoder::MINBITS && bits <= CompressedTrajectoryEncoder::MAXBITS);
+    }
+
+    CompressedTrajectoryReader::CompressedTrajectoryReader(std::string const & filename)
+        : ifs_(filename, std::ios_base::in | std::ios_base::binary)
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::int32_t reserved;
+        if (!ifs_.read(magic, sizeof(magic)) ||
+            !utility::get_le(ifs_, version) ||
+            !utility::get_le(ifs_, bits_) ||
+            !utility::get_le(ifs_, numatom_) ||
+            !utility::get_le(ifs_, reserved) ||
+            !utility::get_le(ifs_, timestep_)) {
+            return;
+        }
+
+        if (std::memcmp(magic, MAGIC, sizeof(magic)) != 0 ||
+            version != VERSION ||
+            bits_ < CompressedTrajectoryEncoder::MINBITS ||
+            bits_ > CompressedTrajectoryEncoder::MAXBITS ||
+            numatom_ <= 0) {
+            return;
+        }
+
+        previous_.assign(3 * static_cast<std::size_t>(numatom_), 0);
+        good_ = true;
+    }
+
+    // #endregion コンストラクタ
+
+    // #region publicメンバ関数
+
+    void CompressedTrajectoryEncoder::put(std::ostream & os, TrajectoryFrame const & frame)
+    {
+        auto const n = frame.NumAtom;
+
+        if (nframe_ == 0) {
+            os.write(MAGIC, sizeof(MAGIC));
+            utility::put_le(os, VERSION);
+            utility::put_le(os, bits_);
+            utility::put_le(os, n);
+            utility::put_le<std::int32_t>(os, 0);
+            utility::put_le(os, frame.timestep);
+
+            previous_.assign(3 * static_cast<std::size_t>(n), 0);
+        }
+
+        BOOST_ASSERT(previous_.size() == 3 * static_cast<std::size_t>(n));
+
+        // キーフレームでは前のフレームの代わりに0との差を取る
+        auto const key = nframe_ % CompressedTrajectoryEncoder::KEYINTERVAL == 0;
+        auto const mask = (1U << bits_) - 1U;
+        auto const scale = static_cast<double>(1U << bits_) / frame.box;
+
+        words_.clear();
+        std::uint64_t acc = 0;
+        auto nbits = 0;
+        auto const put_bits = [this, &acc, &nbits](std::uint32_t v, std::int32_t w) {
+            if (w == 0) {
+                return;
+            }
+
+            acc |= static_cast<std::uint64_t>(v) << nbits;
+            nbits += w;
+            if (nbits >= 64) {
+                words_.push_back(acc);
+                nbits -= 64;
+                acc = nbits > 0 ? static_cast<std::uint64_t>(v) >> (w - nbits) : 0;
+            }
+        };
+
+        std::array<std::uint32_t, BLOCK> z;
+        for (auto k = 0; k < 3; k++) {
+            auto const prev = previous_.data() + static_cast<std::size_t>(k) * n;
+
+            for (auto first = 0; first < n; first += BLOCK) {
+                auto const last = std::min(first + BLOCK, n);
+
+                // ブロックの中の最大の値に合わせてビット数を決める
+                std::uint32_t bitsor = 0;
+                for (auto i = first; i < last; i++) {
+                    auto const x = frame.position[3 * static_cast<std::size_t>(i) + k];
+                    auto const q = static_cast<std::uint32_t>(static_cast<std::int64_t>(std::floor(x * scale + 0.5))) & mask;
+                    z[i - first] = encode_delta(q, key ? 0U : prev[i], bits_);
+                    bitsor |= z[i - first];
+                    prev[i] = q;
+                }
+
+                auto const w = bit_width(bitsor);
+                put_bits(static_cast<std::uint32_t>(w), WIDTHBITS);
+                for (auto i = 0; i < last - first; i++) {
+                    put_bits(z[i], w);
+                }
+            }
+        }
+
+        if (nbits > 0) {
+            words_.push_back(acc);
+        }
+
+        utility::put_le(os, frame.MD_iter);
+        utility::put_le<std::int32_t>(os, key ? 1 : 0);
+        utility::put_le(os, frame.time);
+        utility::put_le(os, frame.box);
+        utility::put_le<std::uint64_t>(os, words_.size());
+        utility::put_le(os, words_.data(), words_.size());
+
+        nframe_++;
+    }
+
+    std::int32_t CompressedTrajectoryReader::getBits() const
+    {
+        return bits_;
+    }
+
+    std::int32_t CompressedTrajectoryReader::getNumAtom() const
+    {
+        return numatom_;
+    }
+
+    bool CompressedTrajectoryReader::good() const
+    {
+        return good_;
+    }
+
+    bool CompressedTrajectoryReader::next(TrajectoryFrame & frame)
+    {
+        if (!good_) {
+            return false;
+        }
+
+        std::int32_t iter;
+        if (!utility::get_le(ifs_, iter)) {
+            // ちょうどフレームの境目で終わっていれば、正しいファイルの終わり
+            good_ = ifs_.gcount() == 0;
+            return false;
+        }
+
+        std::int32_t key;
+        double time, box;
+        std::uint64_t nwords;
+        if (!utility::get_le(ifs_, key) || !utility::get_le(ifs_, time) || !utility::get_le(ifs_, box) || !utility::get_le(ifs_, nwords)) {
+            good_ = false;
+            return false;
+        }
+
+        // どの差もビット数以下で、ブロックごとにWIDTHBITSビット使うので、語数には上限がある
+        auto const n = static_cast<std::size_t>(numatom_);
+        auto const maxbits = 3 * n * static_cast<std::size_t>(bits_) + 3 * ((n + BLOCK - 1) / BLOCK) * WIDTHBITS;
+        if (nwords > (maxbits + 63) / 64 || !(box > 0.0)) {
+            good_ = false;
+            return false;
+        }
+
+        // 最後の語をまたいで読んでもよいように、0の語を一つ足しておく
+        words_.assign(static_cast<std::size_t>(nwords) + 1, 0);
+        if (!utility::get_le(ifs_, words_.data(), static_cast<std::size_t>(nwords))) {
+            good_ = false;
+            return false;
+        }
+
+        std::size_t pos = 0;
+        auto const get_bits = [this, &pos](std::int32_t w) {
+            if (w == 0) {
+                return std::uint32_t(0);
+            }
+
+            auto const word = pos >> 6;
+            auto const off = static_cast<std::int32_t>(pos & 63);
+            auto v = words_[word] >> off;
+            if (off + w > 64) {
+                v |= words_[word + 1] << (64 - off);
+            }
+
+            pos += static_cast<std::size_t>(w);
+            return static_cast<std::uint32_t>(v & ((std::uint64_t(1) << w) - 1));
+        };
+
+        frame.box = box;
+        frame.MD_iter = iter;
+        frame.NumAtom = numatom_;
+        frame.time = time;
+        frame.timestep = timestep_;
+        frame.position.resize(3 * n);
+        frame.velocity.clear();
+        frame.force.clear();
+
+        auto const unit = box / static_cast<double>(1U << bits_);
+        for (auto k = 0; k < 3; k++) {
+            auto const prev = previous_.data() + static_cast<std::size_t>(k) * n;
+
+            for (auto first = std::size_t(0); first < n; first += BLOCK) {
+                auto const last = std::min(first + BLOCK, n);
+
+                auto const total = 64 * static_cast<std::size_t>(nwords);
+                if (pos + WIDTHBITS > total) {
+                    good_ = false;
+                    return false;
+                }
+
+                auto const w = static_cast<std::int32_t>(get_bits(WIDTHBITS));
+                if (w > bits_ || pos + (last - first) * static_cast<std::size_t>(w) > total) {
+                    good_ = false;
+                    return false;
+                }
+
+                for (auto i = first; i < last; i++) {
+                    auto const q = decode_delta(get_bits(w), key ? 0U : prev[i], bits_);
+                    prev[i] = q;
+                    frame.position[3 * i + k] = unit * static_cast<double>(q);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // #endregion publicメンバ関数
+}
@@ -0,0 +1,275 @@
+﻿/*! \file compressedtrajectory.h
+    \brief 座標を固定精度に量子化し、前のフレームとの差をビット詰めして圧縮するトラジェクトリ形式の宣言
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _COMPRESSEDTRAJECTORY_H_
+#define _COMPRESSEDTRAJECTORY_H_
+
+#pragma once
+
+#include "trajectory.h"
+#include <cstdint>  // for std::int32_t, std::uint32_t, std::uint64_t
+#include <fstream>  // for std::ifstream
+#include <ostream>  // for std::ostream
+#include <string>   // for std::string
+#include <vector>   // for std::vector
+
+namespace moleculardynamics {
+    //! A class.
+    /*!
+        XTCと同様の考え方で、トラジェクトリの座標を圧縮して書き出すクラス
+        座標は箱の一辺の長さを2^bits等分した整数に量子化し（誤差は箱の一辺の長さ / 2^(bits + 1)以下）、
+        前のフレームとの差を周期境界条件に合わせて符号付きに直してから、64原子ずつ必要なビット数で詰める
+        KEYINTERVALフレームごとに、前のフレームに依存しないキーフレームを置く
+
+        ファイルの形式（全てリトルエンディアン）
+        ヘッダ："LJMDCTRJ"、版（uint32）、ビット数（int32）、原子数（int32）、0（int32）、時間刻み（double、ps）
+        フレーム：ステップ数（int32）、キーフレームなら1（int32）、時間（double、ps）、箱の一辺の長さ（double、Å）、
+                  語数（uint64）、詰めたビット列（uint64の配列）
+        ビット列はx, y, z成分の順に、64原子ごとのブロックのビット数（6ビット）と、その数のビットずつの差を並べたもの
+    */
+    class CompressedTrajectoryEncoder final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+            \param bits 量子化のビット数（MINBITS以上MAXBITS以下）
+        */
+        explicit CompressedTrajectoryEncoder(std::int32_t bits);
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~CompressedTrajectoryEncoder() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region メンバ関数
+
+        //! A public member function.
+        /*!
+            フレームを圧縮して書き出す（最初のフレームの前にはヘッダを書き出す）
+            全てのフレームの原子数は同じでなければならず、速度と力は書き出さない
+            \param os 書き出すストリーム
+            \param frame フレーム
+        */
+        void put(std::ostream & os, TrajectoryFrame const & frame);
+
+        // #endregion メンバ関数
+
+        // #region メンバ変数
+
+    public:
+        //! A public member variable (constant).
+        /*!
+            量子化のビット数の既定値
+        */
+        static std::int32_t const FIRSTBITS = 16;
+
+        //! A public member variable (constant).
+        /*!
+            キーフレームを置く間隔（フレーム数）
+        */
+        static std::int32_t const KEYINTERVAL = 100;
+
+        //! A public member variable (constant).
+        /*!
+            量子化のビット数の最大値
+        */
+        static std::int32_t const MAXBITS = 30;
+
+        //! A public member variable (constant).
+        /*!
+            量子化のビット数の最小値
+        */
+        static std::int32_t const MINBITS = 8;
+
+    private:
+        //! A private member variable (constant).
+        /*!
+            量子化のビット数
+        */
+        std::int32_t const bits_;
+
+        //! A private member variable.
+        /*!
+            これまでに書き出したフレームの数
+        */
+        std::int32_t nframe_ = 0;
+
+        //! A private member variable.
+        /*!
+            前のフレームの量子化した座標（成分ごとに原子数個ずつ）
+        */
+        std::vector<std::uint32_t> previous_;
+
+        //! A private member variable.
+        /*!
+            詰めたビット列（フレームごとに使い回す）
+        */
+        std::vector<std::uint64_t> words_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        CompressedTrajectoryEncoder() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        CompressedTrajectoryEncoder(CompressedTrajectoryEncoder const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        CompressedTrajectoryEncoder & operator=(CompressedTrajectoryEncoder const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+
+    //! A class.
+    /*!
+        CompressedTrajectoryEncoderで書き出したファイルを、先頭から1フレームずつ読み込むクラス
+        ファイル全体をメモリに読み込まないので、大きなトラジェクトリでも前のフレームの分のメモリしか使わない
+    */
+    class CompressedTrajectoryReader final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            ファイルを開いてヘッダを読み込む
+            開けないか、ヘッダが正しくないときはgood()がfalseになる
+            \param filename ファイルの名前
+        */
+        explicit CompressedTrajectoryReader(std::string const & filename);
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~CompressedTrajectoryReader() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region メンバ関数
+
+        //! A public member function (constant).
+        /*!
+            量子化のビット数を求める
+        */
+        std::int32_t getBits() const;
+
+        //! A public member function (constant).
+        /*!
+            原子数を求める
+        */
+        std::int32_t getNumAtom() const;
+
+        //! A public member function (constant).
+        /*!
+            ヘッダが正しく、これまでのフレームが全て読み込めたかどうか
+            \return 読み込めていればtrue
+        */
+        bool good() const;
+
+        //! A public member function.
+        /*!
+            次のフレームを読み込む
+            座標は箱の中の[0, 箱の一辺の長さ)に戻した値になり、速度と力の配列は空にする
+            \param frame 読み込んだフレーム
+            \return 読み込めたらtrue（ファイルの終わりではfalseで、good()はtrueのまま）
+        */
+        bool next(TrajectoryFrame & frame);
+
+        // #endregion メンバ関数
+
+        // #region メンバ変数
+
+    private:
+        //! A private member variable.
+        /*!
+            量子化のビット数
+        */
+        std::int32_t bits_ = 0;
+
+        //! A private member variable.
+        /*!
+            ヘッダが正しく、これまでのフレームが全て読み込めていればtrue
+        */
+        bool good_ = false;
+
+        //! A private member variable.
+        /*!
+            ファイルのストリーム
+        */
+        std::ifstream ifs_;
+
+        //! A private member variable.
+        /*!
+            原子数
+        */
+        std::int32_t numatom_ = 0;
+
+        //! A private member variable.
+        /*!
+            前のフレームの量子化した座標（成分ごとに原子数個ずつ）
+        */
+        std::vector<std::uint32_t> previous_;
+
+        //! A private member variable.
+        /*!
+            1ステップの時間刻み（ps）
+        */
+        double timestep_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            詰めたビット列（フレームごとに使い回す）
+        */
+        std::vector<std::uint64_t> words_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        CompressedTrajectoryReader() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        CompressedTrajectoryReader(CompressedTrajectoryReader const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        CompressedTrajectoryReader & operator=(CompressedTrajectoryReader const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif      // _COMPRESSEDTRAJECTORY_H_
@@ -0,0 +1,109 @@
+﻿/*! \file forcekernel.cpp
+    \brief 原子間力を計算するカーネルの選択（CPUIDによる判定）の実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "forcekernel.h"
+
+#if defined(LJMD_X86) && defined(_MSC_VER)
+    #include <intrin.h>     // for __cpuid, __cpuidex, _xgetbv
+#endif
+
+namespace moleculardynamics {
+    namespace {
+        //! A function.
+        /*!
+            CPUとOSがAVX2とFMAに対応しているかどうかを調べる
+            \return 対応していればtrue
+        */
+        bool hasAVX2()
+        {
+#if defined(LJMD_X86) && (defined(__GNUC__) || defined(__clang__))
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(LJMD_X86) && defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) {
+                return false;
+            }
+
+            // OSXSAVE, FMA
+            __cpuid(info, 1);
+            if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 12)) == 0) {
+                return false;
+            }
+
+            // OSがYMMレジスタを保存するか
+            if ((_xgetbv(0) & 0x6) != 0x6) {
+                return false;
+            }
+
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return false;
+#endif
+        }
+
+        //! A function.
+        /*!
+            CPUとOSがAVX-512Fに対応しているかどうかを調べる
+            \return 対応していればtrue
+        */
+        bool hasAVX512()
+        {
+#if defined(LJMD_X86) && (defined(__GNUC__) || defined(__clang__))
+            return __builtin_cpu_supports("avx512f");
+#elif defined(LJMD_X86) && defined(_MSC_VER)
+            if (!hasAVX2()) {
+                return false;
+            }
+
+            // OSがZMMレジスタとマスクレジスタを保存するか
+            if ((_xgetbv(0) & 0xE6) != 0xE6) {
+                return false;
+            }
+
+            int info[4];
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 16)) != 0;
+#else
+            return false;
+#endif
+        }
+    }
+
+    bool isSupported(ForceKernelType type)
+    {
+        switch (type) {
+        case ForceKernelType::REFERENCE:
+        case ForceKernelType::SCALAR:
+        case ForceKernelType::TABLE:
+            return true;
+
+        case ForceKernelType::AVX2:
+            return hasAVX2();
+
+        case ForceKernelType::AVX512:
+            return hasAVX512();
+
+        default:
+            return false;
+        }
+    }
+
+    ForceKernelType selectForceKernel()
+    {
+        if (hasAVX512()) {
+            return ForceKernelType::AVX512;
+        }
+
+        if (hasAVX2()) {
+            return ForceKernelType::AVX2;
+        }
+
+        return ForceKernelType::SCALAR;
+    }
+}
@@ -0,0 +1,272 @@
+﻿/*! \file forcekernel.h
+    \brief 原子間力を計算するSIMDカーネルの宣言
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _FORCEKERNEL_H_
+#define _FORCEKERNEL_H_
+
+#pragma once
+
+#include <cstdint>  // for std::int32_t
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define LJMD_X86
+#endif
+
+#if defined(LJMD_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define LJMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+    #define LJMD_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+    #define LJMD_TARGET_AVX2
+    #define LJMD_TARGET_AVX512
+#endif
+
+namespace moleculardynamics {
+    class LJTable;
+    class MixedPositions;
+
+    //! A enumerated type
+    /*!
+        原子間力を計算するカーネルの種類
+    */
+    enum class ForceKernelType : std::int32_t {
+        // 参照実装（sqrtを使う元の計算式）
+        REFERENCE = 0,
+        // スカラー版（r^2のみで計算）
+        SCALAR = 1,
+        // AVX2版（4原子のクラスタのペアごとに計算）
+        AVX2 = 2,
+        // AVX-512版（4原子のクラスタのペアごとに、8ペアずつ計算）
+        AVX512 = 3,
+        // 表による補間版（3次スプライン）
+        TABLE = 4
+    };
+
+    //! A global variable (constant).
+    /*!
+        クラスタ（配列の中で連続する原子の組）の原子数
+        並べ替え（Morton順）の後は、連続する原子は空間的にも近い
+    */
+    std::int32_t const CLUSTERSIZE = 4;
+
+    //! A enumerated type
+    /*!
+        原子間力の計算の精度
+    */
+    enum class PrecisionType : std::int32_t {
+        // 全て倍精度
+        DOUBLE = 0,
+        // 座標の差とペアの力は単精度、力・エネルギー・ビリアルの和は倍精度
+        MIXED = 1
+    };
+
+    //! A struct.
+    /*!
+        原子間力を計算するカーネルに渡す引数
+    */
+    struct ForceKernelArgs {
+        //! A public member variable.
+        /*!
+            ペアリストの各原子の先頭のインデックス
+        */
+        std::int32_t const * offsets;
+
+        //! A public member variable.
+        /*!
+            ペアリストの相手の原子の番号
+        */
+        std::int32_t const * neighbors;
+
+        //! A public member variable.
+        /*!
+            クラスタのペアリストの各クラスタの先頭のインデックス（倍精度のSIMD版のみで使う）
+        */
+        std::int32_t const * clusteroffsets;
+
+        //! A public member variable.
+        /*!
+            クラスタのペアリストの相手のクラスタの番号（倍精度のSIMD版のみで使う）
+        */
+        std::int32_t const * clusterneighbors;
+
+        //! A public member variable.
+        /*!
+            原子数（最後のクラスタの端数の原子を除外するのに使う）
+        */
+        std::int32_t numatom;
+
+        //! A public member variable.
+        /*!
+            座標のx成分の配列
+        */
+        double const * rx;
+
+        //! A public member variable.
+        /*!
+            座標のy成分の配列
+        */
+        double const * ry;
+
+        //! A public member variable.
+        /*!
+            座標のz成分の配列
+        */
+        double const * rz;
+
+        //! A public member variable.
+        /*!
+            力のx成分を足し込む配列
+        */
+        double * fx;
+
+        //! A public member variable.
+        /*!
+            力のy成分を足し込む配列
+        */
+        double * fy;
+
+        //! A public member variable.
+        /*!
+            力のz成分を足し込む配列
+        */
+        double * fz;
+
+        //! A public member variable.
+        /*!
+            周期境界条件の長さ
+        */
+        double periodiclen;
+
+        //! A public member variable.
+        /*!
+            周期境界条件の長さの逆数
+        */
+        double invperiodiclen;
+
+        //! A public member variable.
+        /*!
+            カットオフ半径の2乗
+        */
+        double rc2;
+
+        //! A public member variable.
+        /*!
+            ポテンシャルエネルギーの打ち切り
+        */
+        double Vrc;
+
+        //! A public member variable.
+        /*!
+            力とポテンシャルエネルギーの表（表による補間版のみで使う）
+        */
+        LJTable const * table;
+
+        //! A public member variable.
+        /*!
+            単精度のセルの番号と相対座標（混合精度版のみで使う）
+        */
+        MixedPositions const * mixed;
+    };
+
+    template <bool Energy>
+    //! A template function.
+    /*!
+        sqrtを使わずに、[first, last)番目の原子のペアについて原子に働く力を計算する
+        \tparam Energy ポテンシャルエネルギーとビリアルも計算するならtrue（falseならUpとvirialは変更しない）
+        \param args カーネルに渡す引数
+        \param first 最初の原子の番号
+        \param last 最後の原子の番号の次
+        \param Up ポテンシャルエネルギーを足し込む変数
+        \param virial ビリアルを足し込む変数
+    */
+    void force_scalar(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+
+    template <bool Energy>
+    //! A template function.
+    /*!
+        AVX2を使って、先頭の原子が[first, last)番目にあるクラスタのペアについて原子に働く力を計算する
+        クラスタの4原子ずつの座標と力は連続しているので、gatherもscatterも使わない
+        \tparam Energy ポテンシャルエネルギーとビリアルも計算するならtrue（falseならUpとvirialは変更しない）
+        \param args カーネルに渡す引数（args.clusteroffsetsとargs.clusterneighborsが必要）
+        \param first 最初の原子の番号
+        \param last 最後の原子の番号の次
+        \param Up ポテンシャルエネルギーを足し込む変数
+        \param virial ビリアルを足し込む変数
+    */
+    LJMD_TARGET_AVX2 void force_avx2(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+
+    template <bool Energy>
+    //! A template function.
+    /*!
+        AVX-512を使って、先頭の原子が[first, last)番目にあるクラスタのペアについて原子に働く力を計算する
+        クラスタの4原子ずつの座標と力は連続しているので、gatherもscatterも使わない
+        \tparam Energy ポテンシャルエネルギーとビリアルも計算するならtrue（falseならUpとvirialは変更しない）
+        \param args カーネルに渡す引数（args.clusteroffsetsとargs.clusterneighborsが必要）
+        \param first 最初の原子の番号
+        \param last 最後の原子の番号の次
+        \param Up ポテンシャルエネルギーを足し込む変数
+        \param virial ビリアルを足し込む変数
+    */
+    LJMD_TARGET_AVX512 void force_avx512(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+
+    template <bool Energy>
+    //! A template function.
+    /*!
+        AVX2を使って混合精度で（8ペアずつ）、[first, last)番目の原子のペアについて原子に働く力を計算する
+        座標の差とペアの力は単精度で、力・エネルギー・ビリアルは倍精度で足し込む
+        \tparam Energy ポテンシャルエネルギーとビリアルも計算するならtrue（falseならUpとvirialは変更しない）
+        \param args カーネルに渡す引数（args.mixedが必要）
+        \param first 最初の原子の番号
+        \param last 最後の原子の番号の次
+        \param Up ポテンシャルエネルギーを足し込む変数
+        \param virial ビリアルを足し込む変数
+    */
+    LJMD_TARGET_AVX2 void force_avx2_mixed(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+
+    template <bool Energy>
+    //! A template function.
+    /*!
+        AVX-512を使って混合精度で（16ペアずつ）、[first, last)番目の原子のペアについて原子に働く力を計算する
+        座標の差とペアの力は単精度で、力・エネルギー・ビリアルは倍精度で足し込む
+        \tparam Energy ポテンシャルエネルギーとビリアルも計算するならtrue（falseならUpとvirialは変更しない）
+        \param args カーネルに渡す引数（args.mixedが必要）
+        \param first 最初の原子の番号
+        \param last 最後の原子の番号の次
+        \param Up ポテンシャルエネルギーを足し込む変数
+        \param virial ビリアルを足し込む変数
+    */
+    LJMD_TARGET_AVX512 void force_avx512_mixed(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+
+    template <bool Energy>
+    //! A template function.
+    /*!
+        表による補間で、[first, last)番目の原子のペアについて原子に働く力を計算する
+        \tparam Energy ポテンシャルエネルギーとビリアルも計算するならtrue（falseならUpとvirialは変更しない）
+        \param args カーネルに渡す引数（args.tableが必要）
+        \param first 最初の原子の番号
+        \param last 最後の原子の番号の次
+        \param Up ポテンシャルエネルギーを足し込む変数
+        \param virial ビリアルを足し込む変数
+    */
+    void force_table(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+
+    //! A function.
+    /*!
+        実行中のCPUでカーネルが使えるかどうかを調べる
+        \param type カーネルの種類
+        \return カーネルが使えるならtrue
+    */
+    bool isSupported(ForceKernelType type);
+
+    //! A function.
+    /*!
+        実行中のCPUで使える最も速いカーネルを求める（CPUIDによる判定）
+        \return カーネルの種類
+    */
+    ForceKernelType selectForceKernel();
+}
+
+#endif      // _FORCEKERNEL_H_
@@ -0,0 +1,328 @@
+﻿/*! \file forcekernel_avx2.cpp
+    \brief AVX2を使って原子間力を計算するカーネルの実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "forcekernel.h"
+#include "mixedpositions.h"
+#include <boost/assert.hpp>     // for BOOST_ASSERT
+
+#ifdef LJMD_X86
+    #include <immintrin.h>      // for AVX2 intrinsics
+#endif
+
+namespace moleculardynamics {
+#ifdef LJMD_X86
+    namespace {
+        //! A function.
+        /*!
+            4つの要素の和を求める
+            \param v 4つの要素を持つベクトル
+            \return 要素の和
+        */
+        LJMD_TARGET_AVX2 inline double hsum(__m256d v)
+        {
+            auto const lo = _mm256_castpd256_pd128(v);
+            auto const hi = _mm256_extractf128_pd(v, 1);
+            auto const s = _mm_add_pd(lo, hi);
+            return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+        }
+
+        //! A function.
+        /*!
+            4つのベクトルのそれぞれの要素の和を求める
+            \param v 4つの要素を持つベクトルの配列（要素数4）
+            \return v[a]の要素の和をa番目の要素に持つベクトル
+        */
+        LJMD_TARGET_AVX2 inline __m256d hsum4(__m256d const * v)
+        {
+            // [v0の前半の和, v1の前半の和, v0の後半の和, v1の後半の和]
+            auto const s01 = _mm256_hadd_pd(v[0], v[1]);
+            auto const s23 = _mm256_hadd_pd(v[2], v[3]);
+            return _mm256_add_pd(_mm256_permute2f128_pd(s01, s23, 0x20), _mm256_permute2f128_pd(s01, s23, 0x31));
+        }
+
+        //! A function.
+        /*!
+            単精度の8つの要素を倍精度に変換し、前半と後半の4つずつの和を求める
+            \param v 8つの単精度の要素を持つベクトル
+            \return 前半と後半の和（倍精度の4つの要素）
+        */
+        LJMD_TARGET_AVX2 inline __m256d widen_add(__m256 v)
+        {
+            return _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+        }
+    }
+
+    template <bool Energy>
+    LJMD_TARGET_AVX2 void force_avx2(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial)
+    {
+        auto const L = _mm256_set1_pd(args.periodiclen);
+        auto const invL = _mm256_set1_pd(args.invperiodiclen);
+        auto const rc2 = _mm256_set1_pd(args.rc2);
+        auto const one = _mm256_set1_pd(1.0);
+        auto const c4 = _mm256_set1_pd(4.0);
+        auto const c24 = _mm256_set1_pd(24.0);
+        auto const c48 = _mm256_set1_pd(48.0);
+        auto const Vrc = _mm256_set1_pd(args.Vrc);
+        auto const lane = _mm256_setr_epi64x(0, 1, 2, 3);
+        auto const all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+        // 同じクラスタどうしでは、a番目の原子とそれより後ろの原子（レーン > a）のペアだけを数える
+        __m256d above[CLUSTERSIZE];
+        for (auto a = 0; a < CLUSTERSIZE; a++) {
+            above[a] = _mm256_castsi256_pd(_mm256_cmpgt_epi64(lane, _mm256_set1_epi64x(a)));
+        }
+
+        auto upacc = _mm256_setzero_pd();
+        auto viracc = _mm256_setzero_pd();
+
+        // 力を書き込むたびにargsから読み直さないように、ポインタはローカル変数に置く
+        auto const clusteroffsets = args.clusteroffsets;
+        auto const clusterneighbors = args.clusterneighbors;
+        auto const rx = args.rx;
+        auto const ry = args.ry;
+        auto const rz = args.rz;
+        auto const fx = args.fx;
+        auto const fy = args.fy;
+        auto const fz = args.fz;
+
+        auto const lastcluster = (args.numatom - 1) / CLUSTERSIZE;
+        auto const cfirst = (first + CLUSTERSIZE - 1) / CLUSTERSIZE;
+        auto const clast = (last + CLUSTERSIZE - 1) / CLUSTERSIZE;
+
+        for (auto ci = cfirst; ci < clast; ci++) {
+            // ci番目のクラスタの4原子の座標は各レーンに広げ、力は原子ごとのベクトルに溜める
+            auto const i0 = ci * CLUSTERSIZE;
+            __m256d xi[CLUSTERSIZE], yi[CLUSTERSIZE], zi[CLUSTERSIZE];
+            __m256d fxi[CLUSTERSIZE], fyi[CLUSTERSIZE], fzi[CLUSTERSIZE];
+            for (auto a = 0; a < CLUSTERSIZE; a++) {
+                xi[a] = _mm256_set1_pd(rx[i0 + a]);
+                yi[a] = _mm256_set1_pd(ry[i0 + a]);
+                zi[a] = _mm256_set1_pd(rz[i0 + a]);
+                fxi[a] = _mm256_setzero_pd();
+                fyi[a] = _mm256_setzero_pd();
+                fzi[a] = _mm256_setzero_pd();
+            }
+
+            auto const kend = clusteroffsets[ci + 1];
+            for (auto k = clusteroffsets[ci]; k < kend; k++) {
+                auto const cj = clusterneighbors[k];
+                auto const j0 = cj * CLUSTERSIZE;
+
+                // クラスタの座標と力は連続していて、配列は64バイト境界に揃っている
+                auto const xj = _mm256_load_pd(rx + j0);
+                auto const yj = _mm256_load_pd(ry + j0);
+                auto const zj = _mm256_load_pd(rz + j0);
+                auto fxj = _mm256_setzero_pd();
+                auto fyj = _mm256_setzero_pd();
+                auto fzj = _mm256_setzero_pd();
+
+                // 最後のクラスタの端数のレーン（原子数以上の番号）は除外する
+                auto const valid = cj == lastcluster ?
+                    _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_set1_epi64x(args.numatom - j0), lane)) :
+                    all;
+
+                for (auto a = 0; a < CLUSTERSIZE; a++) {
+                    auto const rowvalid = cj == ci ? _mm256_and_pd(valid, above[a]) : valid;
+
+                    auto dx = _mm256_sub_pd(xj, xi[a]);
+                    auto dy = _mm256_sub_pd(yj, yi[a]);
+                    auto dz = _mm256_sub_pd(zj, zi[a]);
+
+                    // 最小イメージ規約（分岐なし）
+                    dx = _mm256_fnmadd_pd(L, _mm256_round_pd(_mm256_mul_pd(dx, invL), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), dx);
+                    dy = _mm256_fnmadd_pd(L, _mm256_round_pd(_mm256_mul_pd(dy, invL), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), dy);
+                    dz = _mm256_fnmadd_pd(L, _mm256_round_pd(_mm256_mul_pd(dz, invL), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), dz);
+
+                    auto r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+
+                    // カットオフ半径の外側と除外したレーンは、r2 = 1として計算した後で捨てる
+                    auto const mask = _mm256_and_pd(_mm256_cmp_pd(r2, rc2, _CMP_LE_OQ), rowvalid);
+                    r2 = _mm256_blendv_pd(one, r2, mask);
+
+                    // 力もビリアルもr^-2の多項式で書けるので、sqrtは要らない
+                    auto const rm2 = _mm256_div_pd(one, r2);
+                    auto const rm6 = _mm256_mul_pd(_mm256_mul_pd(rm2, rm2), rm2);
+                    auto const rm12 = _mm256_mul_pd(rm6, rm6);
+
+                    // rFr = r * F(r)
+                    auto const rFr = _mm256_fmsub_pd(c48, rm12, _mm256_mul_pd(c24, rm6));
+                    if (Energy) {
+                        auto const u = _mm256_fmsub_pd(c4, _mm256_sub_pd(rm12, rm6), Vrc);
+                        upacc = _mm256_add_pd(upacc, _mm256_and_pd(mask, u));
+                        viracc = _mm256_add_pd(viracc, _mm256_and_pd(mask, rFr));
+                    }
+
+                    // fr = F(r) / r
+                    auto const fr = _mm256_and_pd(mask, _mm256_mul_pd(rFr, rm2));
+                    auto const fxij = _mm256_mul_pd(dx, fr);
+                    auto const fyij = _mm256_mul_pd(dy, fr);
+                    auto const fzij = _mm256_mul_pd(dz, fr);
+                    fxi[a] = _mm256_sub_pd(fxi[a], fxij);
+                    fyi[a] = _mm256_sub_pd(fyi[a], fyij);
+                    fzi[a] = _mm256_sub_pd(fzi[a], fzij);
+                    fxj = _mm256_add_pd(fxj, fxij);
+                    fyj = _mm256_add_pd(fyj, fyij);
+                    fzj = _mm256_add_pd(fzj, fzij);
+                }
+
+                // 相手のクラスタへの反作用は4原子分をまとめて書き込む
+                _mm256_store_pd(fx + j0, _mm256_add_pd(_mm256_load_pd(fx + j0), fxj));
+                _mm256_store_pd(fy + j0, _mm256_add_pd(_mm256_load_pd(fy + j0), fyj));
+                _mm256_store_pd(fz + j0, _mm256_add_pd(_mm256_load_pd(fz + j0), fzj));
+            }
+
+            _mm256_store_pd(fx + i0, _mm256_add_pd(_mm256_load_pd(fx + i0), hsum4(fxi)));
+            _mm256_store_pd(fy + i0, _mm256_add_pd(_mm256_load_pd(fy + i0), hsum4(fyi)));
+            _mm256_store_pd(fz + i0, _mm256_add_pd(_mm256_load_pd(fz + i0), hsum4(fzi)));
+        }
+
+        if (Energy) {
+            Up += hsum(upacc);
+            virial += hsum(viracc);
+        }
+    }
+
+    template <bool Energy>
+    LJMD_TARGET_AVX2 void force_avx2_mixed(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial)
+    {
+        auto const & mixed = *args.mixed;
+        auto const cell = mixed.cell();
+        auto const lx = mixed.local(0);
+        auto const ly = mixed.local(1);
+        auto const lz = mixed.local(2);
+
+        auto const cmask = _mm256_set1_epi32(MixedPositions::CELLMASK);
+        auto const len = _mm256_set1_ps(mixed.celllen());
+        auto const n = _mm256_set1_ps(mixed.ncell());
+        auto const invn = _mm256_set1_ps(mixed.invncell());
+        auto const rc2 = _mm256_set1_ps(static_cast<float>(args.rc2));
+        auto const one = _mm256_set1_ps(1.0f);
+        auto const c4 = _mm256_set1_ps(4.0f);
+        auto const c24 = _mm256_set1_ps(24.0f);
+        auto const c48 = _mm256_set1_ps(48.0f);
+        auto const Vrc = _mm256_set1_ps(static_cast<float>(args.Vrc));
+        auto const lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+        auto upacc = _mm256_setzero_pd();
+        auto viracc = _mm256_setzero_pd();
+
+        alignas(32) std::int32_t tail[8];
+        alignas(32) float tx[8];
+        alignas(32) float ty[8];
+        alignas(32) float tz[8];
+
+        for (auto i = first; i < last; i++) {
+            // i番目の原子のセルの番号と相対座標、力（倍精度）はペアのループの間レジスタに置いておく
+            auto const cxi = _mm256_set1_epi32(cell[i] & MixedPositions::CELLMASK);
+            auto const cyi = _mm256_set1_epi32((cell[i] >> MixedPositions::CELLBITS) & MixedPositions::CELLMASK);
+            auto const czi = _mm256_set1_epi32(cell[i] >> (2 * MixedPositions::CELLBITS));
+            auto const lxi = _mm256_set1_ps(lx[i]);
+            auto const lyi = _mm256_set1_ps(ly[i]);
+            auto const lzi = _mm256_set1_ps(lz[i]);
+            auto fxi = _mm256_setzero_pd();
+            auto fyi = _mm256_setzero_pd();
+            auto fzi = _mm256_setzero_pd();
+
+            auto const kend = args.offsets[i + 1];
+            for (auto k = args.offsets[i]; k < kend; k += 8) {
+                auto const * const idxp = args.neighbors + k;
+
+                __m256i idx;
+                if (kend - k >= 8) {
+                    idx = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(idxp));
+                }
+                else {
+                    // 端数のレーンは番号0の原子を指し、マスクで除外する
+                    for (auto l = 0; l < 8; l++) {
+                        tail[l] = l < kend - k ? idxp[l] : 0;
+                    }
+                    idx = _mm256_load_si256(reinterpret_cast<__m256i const *>(tail));
+                }
+                auto const valid = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(kend - k), lane));
+
+                // セルの番号の差に最小イメージ規約を適用してから、相対座標の差を足す
+                auto const cj = _mm256_i32gather_epi32(cell, idx, 4);
+                auto dcx = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_and_si256(cj, cmask), cxi));
+                auto dcy = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(cj, MixedPositions::CELLBITS), cmask), cyi));
+                auto dcz = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(cj, 2 * MixedPositions::CELLBITS), czi));
+                dcx = _mm256_fnmadd_ps(n, _mm256_round_ps(_mm256_mul_ps(dcx, invn), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), dcx);
+                dcy = _mm256_fnmadd_ps(n, _mm256_round_ps(_mm256_mul_ps(dcy, invn), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), dcy);
+                dcz = _mm256_fnmadd_ps(n, _mm256_round_ps(_mm256_mul_ps(dcz, invn), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), dcz);
+                auto const dx = _mm256_fmadd_ps(dcx, len, _mm256_sub_ps(_mm256_i32gather_ps(lx, idx, 4), lxi));
+                auto const dy = _mm256_fmadd_ps(dcy, len, _mm256_sub_ps(_mm256_i32gather_ps(ly, idx, 4), lyi));
+                auto const dz = _mm256_fmadd_ps(dcz, len, _mm256_sub_ps(_mm256_i32gather_ps(lz, idx, 4), lzi));
+
+                auto r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+
+                // カットオフ半径の外側と端数のレーンは、r2 = 1として計算した後で捨てる
+                auto const mask = _mm256_and_ps(_mm256_cmp_ps(r2, rc2, _CMP_LE_OQ), valid);
+                r2 = _mm256_blendv_ps(one, r2, mask);
+
+                auto const rm2 = _mm256_div_ps(one, r2);
+                auto const rm6 = _mm256_mul_ps(_mm256_mul_ps(rm2, rm2), rm2);
+                auto const rm12 = _mm256_mul_ps(rm6, rm6);
+
+                // rFr = r * F(r)
+                auto const rFr = _mm256_fmsub_ps(c48, rm12, _mm256_mul_ps(c24, rm6));
+                if (Energy) {
+                    auto const u = _mm256_fmsub_ps(c4, _mm256_sub_ps(rm12, rm6), Vrc);
+                    upacc = _mm256_add_pd(upacc, widen_add(_mm256_and_ps(mask, u)));
+                    viracc = _mm256_add_pd(viracc, widen_add(_mm256_and_ps(mask, rFr)));
+                }
+
+                // fr = F(r) / r
+                auto const fr = _mm256_and_ps(mask, _mm256_mul_ps(rFr, rm2));
+                auto const fx = _mm256_mul_ps(dx, fr);
+                auto const fy = _mm256_mul_ps(dy, fr);
+                auto const fz = _mm256_mul_ps(dz, fr);
+                fxi = _mm256_sub_pd(fxi, widen_add(fx));
+                fyi = _mm256_sub_pd(fyi, widen_add(fy));
+                fzi = _mm256_sub_pd(fzi, widen_add(fz));
+
+                // AVX2にはscatterがないので、原子jへの反作用は1つずつ倍精度に変換して書き込む
+                _mm256_store_ps(tx, fx);
+                _mm256_store_ps(ty, fy);
+                _mm256_store_ps(tz, fz);
+
+                auto const m = kend - k < 8 ? kend - k : 8;
+                for (auto l = 0; l < m; l++) {
+                    auto const j = idxp[l];
+                    args.fx[j] += static_cast<double>(tx[l]);
+                    args.fy[j] += static_cast<double>(ty[l]);
+                    args.fz[j] += static_cast<double>(tz[l]);
+                }
+            }
+
+            args.fx[i] += hsum(fxi);
+            args.fy[i] += hsum(fyi);
+            args.fz[i] += hsum(fzi);
+        }
+
+        if (Energy) {
+            Up += hsum(upacc);
+            virial += hsum(viracc);
+        }
+    }
+#else
+    template <bool Energy>
+    void force_avx2(ForceKernelArgs const &, std::int32_t, std::int32_t, double &, double &)
+    {
+        BOOST_ASSERT(!"AVX2版のカーネルはx86以外では使えない");
+    }
+
+    template <bool Energy>
+    void force_avx2_mixed(ForceKernelArgs const &, std::int32_t, std::int32_t, double &, double &)
+    {
+        BOOST_ASSERT(!"AVX2版のカーネルはx86以外では使えない");
+    }
+#endif
+
+    template void force_avx2<true>(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+    template void force_avx2<false>(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+    template void force_avx2_mixed<true>(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+    template void force_avx2_mixed<false>(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+}
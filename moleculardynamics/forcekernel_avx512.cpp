@@ -0,0 +1,354 @@
+﻿/*! \file forcekernel_avx512.cpp
+    \brief AVX-512を使って原子間力を計算するカーネルの実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "forcekernel.h"
+#include "mixedpositions.h"
+#include <boost/assert.hpp>     // for BOOST_ASSERT
+
+#ifdef LJMD_X86
+    #include <immintrin.h>      // for AVX-512 intrinsics
+#endif
+
+namespace moleculardynamics {
+#ifdef LJMD_X86
+    namespace {
+        //! A function.
+        /*!
+            8つの要素の前半と後半を足す
+            \param v 8つの要素を持つベクトル
+            \return 前半と後半の和（4つの要素）
+        */
+        LJMD_TARGET_AVX512 inline __m256d fold(__m512d v)
+        {
+            return _mm256_add_pd(_mm512_castpd512_pd256(v), _mm512_extractf64x4_pd(v, 1));
+        }
+
+        //! A function.
+        /*!
+            2つのベクトルの前半と後半の4つずつの要素の和を求める
+            \param v01 前半と後半に0番目と1番目の値を持つベクトル
+            \param v23 前半と後半に2番目と3番目の値を持つベクトル
+            \return 0番目から3番目の値のそれぞれの和を持つベクトル
+        */
+        LJMD_TARGET_AVX512 inline __m256d hsum4(__m512d v01, __m512d v23)
+        {
+            // [0番目の前半の和, 1番目の前半の和, 0番目の後半の和, 1番目の後半の和]
+            auto const s01 = _mm256_hadd_pd(_mm512_castpd512_pd256(v01), _mm512_extractf64x4_pd(v01, 1));
+            auto const s23 = _mm256_hadd_pd(_mm512_castpd512_pd256(v23), _mm512_extractf64x4_pd(v23, 1));
+            return _mm256_add_pd(_mm256_permute2f128_pd(s01, s23, 0x20), _mm256_permute2f128_pd(s01, s23, 0x31));
+        }
+
+        //! A function.
+        /*!
+            単精度の16個の要素のうち、前半の8個を倍精度に変換する
+            \param v 16個の単精度の要素を持つベクトル
+            \return 前半の8個の要素（倍精度）
+        */
+        LJMD_TARGET_AVX512 inline __m512d widen_lo(__m512 v)
+        {
+            return _mm512_cvtps_pd(_mm512_castps512_ps256(v));
+        }
+
+        //! A function.
+        /*!
+            単精度の16個の要素のうち、後半の8個を倍精度に変換する
+            （_mm512_extractf32x8_psはAVX512DQが必要なので、倍精度として取り出す）
+            \param v 16個の単精度の要素を持つベクトル
+            \return 後半の8個の要素（倍精度）
+        */
+        LJMD_TARGET_AVX512 inline __m512d widen_hi(__m512 v)
+        {
+            return _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1)));
+        }
+    }
+
+    template <bool Energy>
+    LJMD_TARGET_AVX512 void force_avx512(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial)
+    {
+        auto const L = _mm512_set1_pd(args.periodiclen);
+        auto const invL = _mm512_set1_pd(args.invperiodiclen);
+        auto const rc2 = _mm512_set1_pd(args.rc2);
+        auto const one = _mm512_set1_pd(1.0);
+        auto const c4 = _mm512_set1_pd(4.0);
+        auto const c24 = _mm512_set1_pd(24.0);
+        auto const c48 = _mm512_set1_pd(48.0);
+        auto const Vrc = _mm512_set1_pd(args.Vrc);
+
+        // 8つのレーンのうち前半は2p番目、後半は2p + 1番目の原子と、相手のクラスタの4原子とのペア
+        // 同じクラスタどうしでは、自分より後ろの原子とのペアだけを数える
+        auto const NROW = CLUSTERSIZE / 2;
+        __mmask8 above[NROW];
+        for (auto p = 0; p < NROW; p++) {
+            auto bits = 0U;
+            for (auto l = 0; l < 8; l++) {
+                if (l % CLUSTERSIZE > 2 * p + l / CLUSTERSIZE) {
+                    bits |= 1U << l;
+                }
+            }
+            above[p] = static_cast<__mmask8>(bits);
+        }
+
+        auto upacc = _mm512_setzero_pd();
+        auto viracc = _mm512_setzero_pd();
+
+        // 力を書き込むたびにargsから読み直さないように、ポインタはローカル変数に置く
+        auto const clusteroffsets = args.clusteroffsets;
+        auto const clusterneighbors = args.clusterneighbors;
+        auto const rx = args.rx;
+        auto const ry = args.ry;
+        auto const rz = args.rz;
+        auto const fx = args.fx;
+        auto const fy = args.fy;
+        auto const fz = args.fz;
+
+        auto const lastcluster = (args.numatom - 1) / CLUSTERSIZE;
+        auto const cfirst = (first + CLUSTERSIZE - 1) / CLUSTERSIZE;
+        auto const clast = (last + CLUSTERSIZE - 1) / CLUSTERSIZE;
+
+        for (auto ci = cfirst; ci < clast; ci++) {
+            // ci番目のクラスタの4原子の座標は2原子ずつレーンに広げ、力は2原子ずつのベクトルに溜める
+            auto const i0 = ci * CLUSTERSIZE;
+            __m512d xi[NROW], yi[NROW], zi[NROW];
+            __m512d fxi[NROW], fyi[NROW], fzi[NROW];
+            for (auto p = 0; p < NROW; p++) {
+                auto const i = i0 + 2 * p;
+                xi[p] = _mm512_insertf64x4(_mm512_set1_pd(rx[i]), _mm256_set1_pd(rx[i + 1]), 1);
+                yi[p] = _mm512_insertf64x4(_mm512_set1_pd(ry[i]), _mm256_set1_pd(ry[i + 1]), 1);
+                zi[p] = _mm512_insertf64x4(_mm512_set1_pd(rz[i]), _mm256_set1_pd(rz[i + 1]), 1);
+                fxi[p] = _mm512_setzero_pd();
+                fyi[p] = _mm512_setzero_pd();
+                fzi[p] = _mm512_setzero_pd();
+            }
+
+            auto const kend = clusteroffsets[ci + 1];
+            for (auto k = clusteroffsets[ci]; k < kend; k++) {
+                auto const cj = clusterneighbors[k];
+                auto const j0 = cj * CLUSTERSIZE;
+
+                // クラスタの座標と力は連続していて、配列は64バイト境界に揃っている
+                auto const xj = _mm512_broadcast_f64x4(_mm256_load_pd(rx + j0));
+                auto const yj = _mm512_broadcast_f64x4(_mm256_load_pd(ry + j0));
+                auto const zj = _mm512_broadcast_f64x4(_mm256_load_pd(rz + j0));
+                auto fxj = _mm512_setzero_pd();
+                auto fyj = _mm512_setzero_pd();
+                auto fzj = _mm512_setzero_pd();
+
+                // 最後のクラスタの端数のレーン（原子数以上の番号）は除外する
+                auto valid = static_cast<__mmask8>(0xFF);
+                if (cj == lastcluster) {
+                    auto const n = args.numatom - j0;
+                    auto const bits = (1U << n) - 1U;
+                    valid = static_cast<__mmask8>(bits | (bits << CLUSTERSIZE));
+                }
+
+                for (auto p = 0; p < NROW; p++) {
+                    auto const rowvalid = cj == ci ? static_cast<__mmask8>(valid & above[p]) : valid;
+
+                    auto dx = _mm512_sub_pd(xj, xi[p]);
+                    auto dy = _mm512_sub_pd(yj, yi[p]);
+                    auto dz = _mm512_sub_pd(zj, zi[p]);
+
+                    // 最小イメージ規約（分岐なし）
+                    dx = _mm512_fnmadd_pd(L, _mm512_roundscale_pd(_mm512_mul_pd(dx, invL), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), dx);
+                    dy = _mm512_fnmadd_pd(L, _mm512_roundscale_pd(_mm512_mul_pd(dy, invL), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), dy);
+                    dz = _mm512_fnmadd_pd(L, _mm512_roundscale_pd(_mm512_mul_pd(dz, invL), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), dz);
+
+                    auto r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+
+                    // カットオフ半径の外側と除外したレーンは、r2 = 1として計算した後で捨てる
+                    auto const mask = _mm512_mask_cmp_pd_mask(rowvalid, r2, rc2, _CMP_LE_OQ);
+                    r2 = _mm512_mask_blend_pd(mask, one, r2);
+
+                    // 力もビリアルもr^-2の多項式で書けるので、sqrtは要らない
+                    auto const rm2 = _mm512_div_pd(one, r2);
+                    auto const rm6 = _mm512_mul_pd(_mm512_mul_pd(rm2, rm2), rm2);
+                    auto const rm12 = _mm512_mul_pd(rm6, rm6);
+
+                    // rFr = r * F(r)
+                    auto const rFr = _mm512_fmsub_pd(c48, rm12, _mm512_mul_pd(c24, rm6));
+                    if (Energy) {
+                        auto const u = _mm512_fmsub_pd(c4, _mm512_sub_pd(rm12, rm6), Vrc);
+                        upacc = _mm512_mask_add_pd(upacc, mask, upacc, u);
+                        viracc = _mm512_mask_add_pd(viracc, mask, viracc, rFr);
+                    }
+
+                    // fr = F(r) / r
+                    auto const fr = _mm512_maskz_mul_pd(mask, rFr, rm2);
+                    auto const fxij = _mm512_mul_pd(dx, fr);
+                    auto const fyij = _mm512_mul_pd(dy, fr);
+                    auto const fzij = _mm512_mul_pd(dz, fr);
+                    fxi[p] = _mm512_sub_pd(fxi[p], fxij);
+                    fyi[p] = _mm512_sub_pd(fyi[p], fyij);
+                    fzi[p] = _mm512_sub_pd(fzi[p], fzij);
+                    fxj = _mm512_add_pd(fxj, fxij);
+                    fyj = _mm512_add_pd(fyj, fyij);
+                    fzj = _mm512_add_pd(fzj, fzij);
+                }
+
+                // 相手のクラスタへの反作用は、前半と後半を足して4原子分をまとめて書き込む
+                _mm256_store_pd(fx + j0, _mm256_add_pd(_mm256_load_pd(fx + j0), fold(fxj)));
+                _mm256_store_pd(fy + j0, _mm256_add_pd(_mm256_load_pd(fy + j0), fold(fyj)));
+                _mm256_store_pd(fz + j0, _mm256_add_pd(_mm256_load_pd(fz + j0), fold(fzj)));
+            }
+
+            _mm256_store_pd(fx + i0, _mm256_add_pd(_mm256_load_pd(fx + i0), hsum4(fxi[0], fxi[1])));
+            _mm256_store_pd(fy + i0, _mm256_add_pd(_mm256_load_pd(fy + i0), hsum4(fyi[0], fyi[1])));
+            _mm256_store_pd(fz + i0, _mm256_add_pd(_mm256_load_pd(fz + i0), hsum4(fzi[0], fzi[1])));
+        }
+
+        if (Energy) {
+            Up += _mm512_reduce_add_pd(upacc);
+            virial += _mm512_reduce_add_pd(viracc);
+        }
+    }
+
+    template <bool Energy>
+    LJMD_TARGET_AVX512 void force_avx512_mixed(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial)
+    {
+        auto const & mixed = *args.mixed;
+        auto const cell = mixed.cell();
+        auto const lx = mixed.local(0);
+        auto const ly = mixed.local(1);
+        auto const lz = mixed.local(2);
+
+        auto const cmask = _mm512_set1_epi32(MixedPositions::CELLMASK);
+        auto const len = _mm512_set1_ps(mixed.celllen());
+        auto const n = _mm512_set1_ps(mixed.ncell());
+        auto const invn = _mm512_set1_ps(mixed.invncell());
+        auto const rc2 = _mm512_set1_ps(static_cast<float>(args.rc2));
+        auto const one = _mm512_set1_ps(1.0f);
+        auto const c4 = _mm512_set1_ps(4.0f);
+        auto const c24 = _mm512_set1_ps(24.0f);
+        auto const c48 = _mm512_set1_ps(48.0f);
+        auto const Vrc = _mm512_set1_ps(static_cast<float>(args.Vrc));
+
+        auto upacc = _mm512_setzero_pd();
+        auto viracc = _mm512_setzero_pd();
+
+        alignas(64) std::int32_t tail[16];
+
+        for (auto i = first; i < last; i++) {
+            // i番目の原子のセルの番号と相対座標、力（倍精度）はペアのループの間レジスタに置いておく
+            auto const cxi = _mm512_set1_epi32(cell[i] & MixedPositions::CELLMASK);
+            auto const cyi = _mm512_set1_epi32((cell[i] >> MixedPositions::CELLBITS) & MixedPositions::CELLMASK);
+            auto const czi = _mm512_set1_epi32(cell[i] >> (2 * MixedPositions::CELLBITS));
+            auto const lxi = _mm512_set1_ps(lx[i]);
+            auto const lyi = _mm512_set1_ps(ly[i]);
+            auto const lzi = _mm512_set1_ps(lz[i]);
+            auto fxi = _mm512_setzero_pd();
+            auto fyi = _mm512_setzero_pd();
+            auto fzi = _mm512_setzero_pd();
+
+            auto const kend = args.offsets[i + 1];
+            for (auto k = args.offsets[i]; k < kend; k += 16) {
+                __m512i idx;
+                __mmask16 valid;
+
+                if (kend - k >= 16) {
+                    idx = _mm512_loadu_si512(args.neighbors + k);
+                    valid = 0xFFFF;
+                }
+                else {
+                    // 端数のレーンは番号0の原子を指し、マスクで除外する
+                    auto const m = kend - k;
+                    for (auto l = 0; l < 16; l++) {
+                        tail[l] = l < m ? args.neighbors[k + l] : 0;
+                    }
+                    idx = _mm512_load_si512(tail);
+                    valid = static_cast<__mmask16>((1U << m) - 1U);
+                }
+
+                // セルの番号の差に最小イメージ規約を適用してから、相対座標の差を足す
+                auto const cj = _mm512_i32gather_epi32(idx, cell, 4);
+                auto dcx = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_and_si512(cj, cmask), cxi));
+                auto dcy = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_and_si512(_mm512_srli_epi32(cj, MixedPositions::CELLBITS), cmask), cyi));
+                auto dcz = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(cj, 2 * MixedPositions::CELLBITS), czi));
+                dcx = _mm512_fnmadd_ps(n, _mm512_roundscale_ps(_mm512_mul_ps(dcx, invn), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), dcx);
+                dcy = _mm512_fnmadd_ps(n, _mm512_roundscale_ps(_mm512_mul_ps(dcy, invn), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), dcy);
+                dcz = _mm512_fnmadd_ps(n, _mm512_roundscale_ps(_mm512_mul_ps(dcz, invn), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), dcz);
+                auto const dx = _mm512_fmadd_ps(dcx, len, _mm512_sub_ps(_mm512_i32gather_ps(idx, lx, 4), lxi));
+                auto const dy = _mm512_fmadd_ps(dcy, len, _mm512_sub_ps(_mm512_i32gather_ps(idx, ly, 4), lyi));
+                auto const dz = _mm512_fmadd_ps(dcz, len, _mm512_sub_ps(_mm512_i32gather_ps(idx, lz, 4), lzi));
+
+                auto r2 = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dz, dz)));
+
+                // カットオフ半径の外側と端数のレーンは、r2 = 1として計算した後で捨てる
+                auto const mask = _mm512_mask_cmp_ps_mask(valid, r2, rc2, _CMP_LE_OQ);
+                r2 = _mm512_mask_blend_ps(mask, one, r2);
+
+                auto const rm2 = _mm512_div_ps(one, r2);
+                auto const rm6 = _mm512_mul_ps(_mm512_mul_ps(rm2, rm2), rm2);
+                auto const rm12 = _mm512_mul_ps(rm6, rm6);
+
+                // rFr = r * F(r)
+                auto const rFr = _mm512_fmsub_ps(c48, rm12, _mm512_mul_ps(c24, rm6));
+                if (Energy) {
+                    auto const u = _mm512_maskz_fmsub_ps(mask, c4, _mm512_sub_ps(rm12, rm6), Vrc);
+                    auto const w = _mm512_maskz_mov_ps(mask, rFr);
+                    upacc = _mm512_add_pd(upacc, _mm512_add_pd(widen_lo(u), widen_hi(u)));
+                    viracc = _mm512_add_pd(viracc, _mm512_add_pd(widen_lo(w), widen_hi(w)));
+                }
+
+                // fr = F(r) / r
+                auto const fr = _mm512_maskz_mul_ps(mask, rFr, rm2);
+                auto const fx = _mm512_mul_ps(dx, fr);
+                auto const fy = _mm512_mul_ps(dy, fr);
+                auto const fz = _mm512_mul_ps(dz, fr);
+
+                // ペアの力は倍精度に変換してから足し込むので、作用・反作用は厳密に釣り合う
+                auto const fxlo = widen_lo(fx);
+                auto const fylo = widen_lo(fy);
+                auto const fzlo = widen_lo(fz);
+                auto const fxhi = widen_hi(fx);
+                auto const fyhi = widen_hi(fy);
+                auto const fzhi = widen_hi(fz);
+                fxi = _mm512_sub_pd(fxi, _mm512_add_pd(fxlo, fxhi));
+                fyi = _mm512_sub_pd(fyi, _mm512_add_pd(fylo, fyhi));
+                fzi = _mm512_sub_pd(fzi, _mm512_add_pd(fzlo, fzhi));
+
+                // 原子jへの反作用は、前半と後半の8ペアずつ倍精度のgather・scatterで書き込む
+                auto const idxlo = _mm512_castsi512_si256(idx);
+                auto const idxhi = _mm512_extracti64x4_epi64(idx, 1);
+                auto const masklo = static_cast<__mmask8>(mask);
+                auto const maskhi = static_cast<__mmask8>(mask >> 8);
+                _mm512_mask_i32scatter_pd(args.fx, masklo, idxlo, _mm512_add_pd(_mm512_mask_i32gather_pd(_mm512_setzero_pd(), masklo, idxlo, args.fx, 8), fxlo), 8);
+                _mm512_mask_i32scatter_pd(args.fy, masklo, idxlo, _mm512_add_pd(_mm512_mask_i32gather_pd(_mm512_setzero_pd(), masklo, idxlo, args.fy, 8), fylo), 8);
+                _mm512_mask_i32scatter_pd(args.fz, masklo, idxlo, _mm512_add_pd(_mm512_mask_i32gather_pd(_mm512_setzero_pd(), masklo, idxlo, args.fz, 8), fzlo), 8);
+                _mm512_mask_i32scatter_pd(args.fx, maskhi, idxhi, _mm512_add_pd(_mm512_mask_i32gather_pd(_mm512_setzero_pd(), maskhi, idxhi, args.fx, 8), fxhi), 8);
+                _mm512_mask_i32scatter_pd(args.fy, maskhi, idxhi, _mm512_add_pd(_mm512_mask_i32gather_pd(_mm512_setzero_pd(), maskhi, idxhi, args.fy, 8), fyhi), 8);
+                _mm512_mask_i32scatter_pd(args.fz, maskhi, idxhi, _mm512_add_pd(_mm512_mask_i32gather_pd(_mm512_setzero_pd(), maskhi, idxhi, args.fz, 8), fzhi), 8);
+            }
+
+            args.fx[i] += _mm512_reduce_add_pd(fxi);
+            args.fy[i] += _mm512_reduce_add_pd(fyi);
+            args.fz[i] += _mm512_reduce_add_pd(fzi);
+        }
+
+        if (Energy) {
+            Up += _mm512_reduce_add_pd(upacc);
+            virial += _mm512_reduce_add_pd(viracc);
+        }
+    }
+#else
+    template <bool Energy>
+    void force_avx512(ForceKernelArgs const &, std::int32_t, std::int32_t, double &, double &)
+    {
+        BOOST_ASSERT(!"AVX-512版のカーネルはx86以外では使えない");
+    }
+
+    template <bool Energy>
+    void force_avx512_mixed(ForceKernelArgs const &, std::int32_t, std::int32_t, double &, double &)
+    {
+        BOOST_ASSERT(!"AVX-512版のカーネルはx86以外では使えない");
+    }
+#endif
+
+    template void force_avx512<true>(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+    template void force_avx512<false>(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+    template void force_avx512_mixed<true>(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+    template void force_avx512_mixed<false>(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+}
@@ -0,0 +1,68 @@
+﻿/*! \file forcekernel_scalar.cpp
+    \brief sqrtを使わずに原子間力を計算するスカラー版カーネルの実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "forcekernel.h"
+#include "periodic.h"
+
+namespace moleculardynamics {
+    template <bool Energy>
+    void force_scalar(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial)
+    {
+        for (auto i = first; i < last; i++) {
+            // i番目の原子の座標と力はペアのループの間レジスタに置いておく
+            auto const xi = args.rx[i];
+            auto const yi = args.ry[i];
+            auto const zi = args.rz[i];
+            auto fxi = 0.0;
+            auto fyi = 0.0;
+            auto fzi = 0.0;
+
+            auto const kend = args.offsets[i + 1];
+            for (auto k = args.offsets[i]; k < kend; k++) {
+                auto const j = args.neighbors[k];
+                auto const dx = minimum_image(args.rx[j] - xi, args.periodiclen, args.invperiodiclen);
+                auto const dy = minimum_image(args.ry[j] - yi, args.periodiclen, args.invperiodiclen);
+                auto const dz = minimum_image(args.rz[j] - zi, args.periodiclen, args.invperiodiclen);
+                auto const r2 = dx * dx + dy * dy + dz * dz;
+
+                // カットオフ半径の外側のペアは、分岐せずに重み0で足し込む
+                // （Morton順に並べ替えた後は内側か外側かがペアごとにばらばらで、分岐の予測が外れる）
+                auto const w = static_cast<double>(r2 <= args.rc2);
+
+                // 力もビリアルもr^-2の多項式で書けるので、sqrtは要らない
+                auto const rm2 = 1.0 / r2;
+                auto const rm6 = rm2 * rm2 * rm2;
+                auto const rm12 = rm6 * rm6;
+
+                // rFr = r * F(r)
+                auto const rFr = 48.0 * rm12 - 24.0 * rm6;
+
+                // Energyはコンパイル時の定数なので、falseのときはこの分岐ごと消える
+                if (Energy) {
+                    Up += w * (4.0 * (rm12 - rm6) - args.Vrc);
+                    virial += w * rFr;
+                }
+
+                // fr = F(r) / r
+                auto const fr = w * rFr * rm2;
+                fxi -= dx * fr;
+                fyi -= dy * fr;
+                fzi -= dz * fr;
+                args.fx[j] += dx * fr;
+                args.fy[j] += dy * fr;
+                args.fz[j] += dz * fr;
+            }
+
+            args.fx[i] += fxi;
+            args.fy[i] += fyi;
+            args.fz[i] += fzi;
+        }
+    }
+
+    template void force_scalar<true>(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+    template void force_scalar<false>(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+}
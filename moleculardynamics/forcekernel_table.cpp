@@ -0,0 +1,83 @@
+﻿/*! \file forcekernel_table.cpp
+    \brief 表による補間で原子間力を計算するカーネルの実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "forcekernel.h"
+#include "ljtable.h"
+#include "periodic.h"
+
+namespace moleculardynamics {
+    template <bool Energy>
+    void force_table(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial)
+    {
+        auto const & table = *args.table;
+
+        for (auto i = first; i < last; i++) {
+            // i番目の原子の座標と力はペアのループの間レジスタに置いておく
+            auto const xi = args.rx[i];
+            auto const yi = args.ry[i];
+            auto const zi = args.rz[i];
+            auto fxi = 0.0;
+            auto fyi = 0.0;
+            auto fzi = 0.0;
+
+            auto const kend = args.offsets[i + 1];
+            for (auto k = args.offsets[i]; k < kend; k++) {
+                auto const j = args.neighbors[k];
+                auto const dx = minimum_image(args.rx[j] - xi, args.periodiclen, args.invperiodiclen);
+                auto const dy = minimum_image(args.ry[j] - yi, args.periodiclen, args.invperiodiclen);
+                auto const dz = minimum_image(args.rz[j] - zi, args.periodiclen, args.invperiodiclen);
+                auto const r2 = dx * dx + dy * dy + dz * dz;
+
+                if (r2 > args.rc2) {
+                    continue;
+                }
+
+                // fr = F(r) / r
+                double fr;
+                if (r2 >= LJTable::R2MIN) {
+                    if (Energy) {
+                        double u;
+                        fr = table.lookup(r2, u);
+                        Up += u;
+                        virial += fr * r2;
+                    }
+                    else {
+                        fr = table.lookup(r2);
+                    }
+                }
+                else {
+                    // 表の範囲より近いペア（通常は現れない）は解析的な式で計算する
+                    auto const rm2 = 1.0 / r2;
+                    auto const rm6 = rm2 * rm2 * rm2;
+                    auto const rm12 = rm6 * rm6;
+                    auto const rFr = 48.0 * rm12 - 24.0 * rm6;
+
+                    if (Energy) {
+                        Up += 4.0 * (rm12 - rm6) - args.Vrc;
+                        virial += rFr;
+                    }
+
+                    fr = rFr * rm2;
+                }
+
+                fxi -= dx * fr;
+                fyi -= dy * fr;
+                fzi -= dz * fr;
+                args.fx[j] += dx * fr;
+                args.fy[j] += dy * fr;
+                args.fz[j] += dz * fr;
+            }
+
+            args.fx[i] += fxi;
+            args.fy[i] += fyi;
+            args.fz[i] += fzi;
+        }
+    }
+
+    template void force_table<true>(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+    template void force_table<false>(ForceKernelArgs const & args, std::int32_t first, std::int32_t last, double & Up, double & virial);
+}
@@ -0,0 +1,124 @@
+﻿/*! \file ljtable.cpp
+    \brief Lennard-Jonesポテンシャルと力をr^2の3次スプラインで補間する表のクラスの実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "ljtable.h"
+#include <algorithm>            // for std::max
+#include <cmath>                // for std::fabs
+#include <boost/assert.hpp>     // for BOOST_ASSERT
+
+namespace moleculardynamics {
+    namespace {
+        //! A function.
+        /*!
+            s = r^2の関数として、F(r) / rとその微分を求める
+            \param s r^2
+            \param df d(F(r) / r) / dsを格納する変数
+            \return F(r) / r
+        */
+        double force_exact(double s, double & df)
+        {
+            auto const sm1 = 1.0 / s;
+            auto const sm3 = sm1 * sm1 * sm1;
+            auto const sm4 = sm3 * sm1;
+            auto const sm7 = sm4 * sm3;
+
+            // F(r) / r = 48r^-14 - 24r^-8
+            df = (-336.0 * sm7 + 96.0 * sm4) * sm1;
+            return 48.0 * sm7 - 24.0 * sm4;
+        }
+
+        //! A function.
+        /*!
+            3次エルミート補間の係数を求める
+            \param f0 区間の左端の値
+            \param d0 区間の左端の微分（区間の幅を掛けたもの）
+            \param f1 区間の右端の値
+            \param d1 区間の右端の微分（区間の幅を掛けたもの）
+            \param c 4つの係数を格納する配列
+        */
+        void hermite(double f0, double d0, double f1, double d1, double * c)
+        {
+            c[0] = f0;
+            c[1] = d0;
+            c[2] = 3.0 * (f1 - f0) - 2.0 * d0 - d1;
+            c[3] = 2.0 * (f0 - f1) + d0 + d1;
+        }
+    }
+
+    // #region static public 定数
+
+    double const LJTable::R2MIN = 0.36;
+
+    // #endregion static public 定数
+
+    // #region publicメンバ関数
+
+    TableAccuracy LJTable::accuracy(std::int32_t samples) const
+    {
+        BOOST_ASSERT(size_ > 0 && samples > 0);
+
+        TableAccuracy acc = { 0.0, 0.0 };
+
+        auto const n = size_ * samples;
+        auto const ds = (rc2_ - LJTable::R2MIN) / static_cast<double>(n);
+        for (auto k = 0; k <= n; k++) {
+            auto const s = LJTable::R2MIN + ds * static_cast<double>(k);
+
+            double df;
+            auto const fr = force_exact(s, df);
+            auto const sm3 = 1.0 / (s * s * s);
+            auto const u = 4.0 * (sm3 * sm3 - sm3) - Vrc_;
+
+            double ut;
+            auto const frt = lookup(s, ut);
+
+            acc.force = std::max(acc.force, std::fabs(frt - fr) / std::fabs(fr));
+            acc.energy = std::max(acc.energy, std::fabs(ut - u));
+        }
+
+        return acc;
+    }
+
+    void LJTable::build(std::int32_t size, double rc2, double Vrc)
+    {
+        BOOST_ASSERT(size > 0 && rc2 > LJTable::R2MIN);
+
+        size_ = size;
+        rc2_ = rc2;
+        Vrc_ = Vrc;
+
+        auto const h = (rc2 - LJTable::R2MIN) / static_cast<double>(size);
+        invdr2_ = 1.0 / h;
+
+        energy_.resize(4 * size);
+        force_.resize(4 * size);
+
+        // dU/ds = -(F(r) / r) / 2なので、エネルギーの微分には力の値を使う
+        auto s0 = LJTable::R2MIN;
+        double df0;
+        auto f0 = force_exact(s0, df0);
+        auto sm3 = 1.0 / (s0 * s0 * s0);
+        auto u0 = 4.0 * (sm3 * sm3 - sm3) - Vrc;
+
+        for (auto i = 0; i < size; i++) {
+            auto const s1 = LJTable::R2MIN + h * static_cast<double>(i + 1);
+            double df1;
+            auto const f1 = force_exact(s1, df1);
+            sm3 = 1.0 / (s1 * s1 * s1);
+            auto const u1 = 4.0 * (sm3 * sm3 - sm3) - Vrc;
+
+            hermite(f0, h * df0, f1, h * df1, force_.data() + 4 * i);
+            hermite(u0, -0.5 * h * f0, u1, -0.5 * h * f1, energy_.data() + 4 * i);
+
+            f0 = f1;
+            df0 = df1;
+            u0 = u1;
+        }
+    }
+
+    // #endregion publicメンバ関数
+}
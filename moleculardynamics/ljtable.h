@@ -0,0 +1,214 @@
+﻿/*! \file ljtable.h
+    \brief Lennard-Jonesポテンシャルと力をr^2の3次スプラインで補間する表のクラスの宣言
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _LJTABLE_H_
+#define _LJTABLE_H_
+
+#pragma once
+
+#include <cstdint>                              // for std::int32_t
+#include <vector>                               // for std::vector
+#include <boost/align/aligned_allocator.hpp>    // for boost::alignment::aligned_allocator
+
+namespace moleculardynamics {
+    //! A struct.
+    /*!
+        表による補間の誤差
+    */
+    struct TableAccuracy {
+        //! A public member variable.
+        /*!
+            F(r) / rの最大の相対誤差
+        */
+        double force;
+
+        //! A public member variable.
+        /*!
+            ポテンシャルエネルギーの最大の絶対誤差（無次元単位）
+        */
+        double energy;
+    };
+
+    //! A class.
+    /*!
+        [R2MIN, rc^2]を等間隔の区間に分け、各区間でF(r) / rとU(r) - U(rc)を
+        s = r^2の3次エルミートスプラインで表す表のクラス
+        区間ごとに4つの係数を持ち、区間内の位置x ∈ [0, 1)についてc0 + x(c1 + x(c2 + x c3))で補間する
+    */
+    class LJTable final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            デフォルトコンストラクタ（空の表）
+        */
+        LJTable() = default;
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~LJTable() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region メンバ関数
+
+        //! A public member function (constant).
+        /*!
+            解析的な式と比べた補間の誤差を求める
+            \param samples 一つの区間あたりの標本点の数
+            \return 補間の誤差
+        */
+        TableAccuracy accuracy(std::int32_t samples) const;
+
+        //! A public member function.
+        /*!
+            表を作る
+            \param size 区間の数
+            \param rc2 カットオフ半径の2乗
+            \param Vrc カットオフ半径でのポテンシャルエネルギー
+        */
+        void build(std::int32_t size, double rc2, double Vrc);
+
+        //! A public member function (constant).
+        /*!
+            表からF(r) / rを補間する
+            \param r2 r^2（R2MIN <= r2 <= rc^2）
+            \return F(r) / r
+        */
+        double lookup(double r2) const
+        {
+            std::int32_t i;
+            auto const x = position(r2, i);
+            auto const c = force_.data() + 4 * i;
+            return c[0] + x * (c[1] + x * (c[2] + x * c[3]));
+        }
+
+        //! A public member function (constant).
+        /*!
+            表からF(r) / rとポテンシャルエネルギーを補間する
+            \param r2 r^2（R2MIN <= r2 <= rc^2）
+            \param u ポテンシャルエネルギーU(r) - U(rc)を格納する変数
+            \return F(r) / r
+        */
+        double lookup(double r2, double & u) const
+        {
+            std::int32_t i;
+            auto const x = position(r2, i);
+            auto const c = force_.data() + 4 * i;
+            auto const e = energy_.data() + 4 * i;
+            u = e[0] + x * (e[1] + x * (e[2] + x * e[3]));
+            return c[0] + x * (c[1] + x * (c[2] + x * c[3]));
+        }
+
+        //! A public member function (constant).
+        /*!
+            区間の数を求める
+            \return 区間の数
+        */
+        std::int32_t size() const
+        {
+            return size_;
+        }
+
+    private:
+        //! A private member function (constant).
+        /*!
+            r^2が属する区間と、区間内の位置を求める
+            \param r2 r^2
+            \param i 区間の番号を格納する変数
+            \return 区間内の位置x ∈ [0, 1]
+        */
+        double position(double r2, std::int32_t & i) const
+        {
+            auto const t = (r2 - LJTable::R2MIN) * invdr2_;
+
+            // r2 = rc^2のときは最後の区間の右端として扱う
+            i = static_cast<std::int32_t>(t);
+            i = i < size_ ? i : size_ - 1;
+            return t - static_cast<double>(i);
+        }
+
+        // #endregion メンバ関数
+
+        // #region メンバ変数
+
+    public:
+        //! A public member variable (constant).
+        /*!
+            初期の区間の数
+        */
+        static std::int32_t const FIRSTSIZE = 1024;
+
+        //! A public member variable (constant).
+        /*!
+            表の下端のr^2（これより近いペアは解析的な式で計算する）
+        */
+        static double const R2MIN;
+
+    private:
+        //! A private member variable.
+        /*!
+            ポテンシャルエネルギーの係数
+        */
+        std::vector<double, boost::alignment::aligned_allocator<double, 64> > energy_;
+
+        //! A private member variable.
+        /*!
+            F(r) / rの係数
+        */
+        std::vector<double, boost::alignment::aligned_allocator<double, 64> > force_;
+
+        //! A private member variable.
+        /*!
+            区間の幅の逆数
+        */
+        double invdr2_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            カットオフ半径の2乗
+        */
+        double rc2_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            区間の数
+        */
+        std::int32_t size_ = 0;
+
+        //! A private member variable.
+        /*!
+            カットオフ半径でのポテンシャルエネルギー
+        */
+        double Vrc_ = 0.0;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        LJTable(LJTable const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        LJTable & operator=(LJTable const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif      // _LJTABLE_H_
@@ -0,0 +1,94 @@
+﻿/*! \file mixedpositions.cpp
+    \brief 混合精度の原子間力の計算で使う、セルの原点からの相対座標（単精度）のクラスの実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "mixedpositions.h"
+#include <algorithm>            // for std::fill, std::max, std::min
+#include <cmath>                // for std::ceil, std::floor
+#include <cstddef>              // for std::ptrdiff_t
+#include <tbb/parallel_for.h>   // for tbb::parallel_for
+
+namespace moleculardynamics {
+    // #region static public 定数
+
+    double const MixedPositions::MAXCELLLEN = 1.0;
+
+    // #endregion static public 定数
+
+    // #region publicメンバ関数
+
+    bool MixedPositions::update(Atoms const & atoms, std::int32_t numatom, double periodiclen, double rc)
+    {
+        // 最小イメージ規約が成り立たない小さな箱は倍精度で計算する
+        if (periodiclen <= 2.0 * rc) {
+            return false;
+        }
+
+        // セルの番号の差を[-ncell / 2, ncell / 2]に戻したとき、別のイメージの方が近くなり得るのは
+        // 距離がL / 2 - (セルの一辺)より大きいペアだけなので、これがカットオフ半径以上になるようにセルを分ける
+        // セルの番号はCELLBITSビットに収まるようにする（その分セルは大きくなる）
+        auto const nmin = std::ceil(periodiclen / (0.5 * periodiclen - rc));
+        auto const nmax = static_cast<double>(MixedPositions::CELLMASK + 1);
+        if (nmin > nmax) {
+            return false;
+        }
+
+        auto const n = std::min(std::max(nmin, std::ceil(periodiclen / MixedPositions::MAXCELLLEN)), nmax);
+        auto const len = periodiclen / n;
+        auto const invlen = 1.0 / len;
+
+        ncell_ = static_cast<float>(n);
+        invncell_ = static_cast<float>(1.0 / n);
+        celllen_ = static_cast<float>(len);
+
+        stride_ = (static_cast<std::size_t>(numatom) + 15) & ~static_cast<std::size_t>(15);
+        cell_.resize(stride_);
+        local_.resize(3 * stride_);
+
+        auto const rx = atoms.data(Atoms::R, 0);
+        auto const ry = atoms.data(Atoms::R, 1);
+        auto const rz = atoms.data(Atoms::R, 2);
+        auto const lx = local_.data();
+        auto const ly = lx + stride_;
+        auto const lz = ly + stride_;
+
+        // 原子ごとに独立なので、他の原子ごとの処理と同じく並列に求める（結果はスレッド数によらない）
+        tbb::parallel_for(
+            tbb::blocked_range<std::int32_t>(0, numatom),
+            [this, n, len, invlen, rx, ry, rz, lx, ly, lz](tbb::blocked_range<std::int32_t> const & range) {
+            for (auto i = range.begin(); i != range.end(); ++i) {
+                std::int32_t cell = 0;
+                double const r[3] = { rx[i], ry[i], rz[i] };
+                float * const l[3] = { lx, ly, lz };
+
+                for (auto k = 0; k < 3; k++) {
+                    // 相対座標は倍精度で求めてから丸めるので、誤差はセルの一辺の大きさのulp程度になる
+                    auto const m = std::floor(r[k] * invlen);
+                    l[k][i] = static_cast<float>(r[k] - m * len);
+
+                    // 箱の外にはみ出した座標のセルの番号も[0, ncell)に戻す
+                    auto const c = static_cast<std::int32_t>(m < 0.0 ? m + n : (m >= n ? m - n : m));
+                    cell |= c << (k * MixedPositions::CELLBITS);
+                }
+
+                cell_[i] = cell;
+            }
+        });
+
+        // 端数の原子はカーネルが読み飛ばすが、前の値が残らないように0にしておく
+        std::fill(cell_.begin() + numatom, cell_.end(), 0);
+        for (auto k = 0; k < 3; k++) {
+            std::fill(
+                local_.begin() + static_cast<std::ptrdiff_t>(k * stride_ + numatom),
+                local_.begin() + static_cast<std::ptrdiff_t>((k + 1) * stride_),
+                0.0f);
+        }
+
+        return true;
+    }
+
+    // #endregion publicメンバ関数
+}
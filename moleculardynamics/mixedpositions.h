@@ -0,0 +1,194 @@
+﻿/*! \file mixedpositions.h
+    \brief 混合精度の原子間力の計算で使う、セルの原点からの相対座標（単精度）のクラスの宣言
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _MIXEDPOSITIONS_H_
+#define _MIXEDPOSITIONS_H_
+
+#pragma once
+
+#include "atoms.h"
+#include <cstddef>                              // for std::size_t
+#include <cstdint>                              // for std::int32_t
+#include <vector>                               // for std::vector
+#include <boost/align/aligned_allocator.hpp>    // for boost::alignment::aligned_allocator
+
+namespace moleculardynamics {
+    //! A class.
+    /*!
+        箱を一辺あたりncell個の立方体のセルに分け、各原子の座標を
+        セルの番号（x, y, zを一つの整数に詰めたもの）とセルの原点からの相対座標（float）の組で表すクラス
+        座標の差は、セルの番号の差に最小イメージ規約を適用してから相対座標の差を足して求める
+        相対座標はセルの一辺より小さいので、箱が大きくても単精度で座標の差の精度が落ちない
+        セルの番号を一つの整数に詰めるのは、カーネルでのgatherの回数を減らすため
+    */
+    class MixedPositions final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            デフォルトコンストラクタ
+        */
+        MixedPositions() = default;
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~MixedPositions() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region メンバ関数
+
+        //! A public member function (constant).
+        /*!
+            セルの番号の配列の先頭へのポインタを返す
+            x成分が下位CELLBITSビット、y成分がその次のCELLBITSビット、z成分がその上のビットに入っている
+            \return 配列の先頭へのポインタ
+        */
+        std::int32_t const * cell() const
+        {
+            return cell_.data();
+        }
+
+        //! A public member function (constant).
+        /*!
+            セルの一辺の長さを求める
+            \return セルの一辺の長さ（無次元単位）
+        */
+        float celllen() const
+        {
+            return celllen_;
+        }
+
+        //! A public member function (constant).
+        /*!
+            一辺あたりのセルの個数の逆数を求める
+            \return 一辺あたりのセルの個数の逆数
+        */
+        float invncell() const
+        {
+            return invncell_;
+        }
+
+        //! A public member function (constant).
+        /*!
+            k成分のセルの原点からの相対座標の配列の先頭へのポインタを返す
+            \param k 成分（0, 1, 2がそれぞれx, y, zに対応する）
+            \return 配列の先頭へのポインタ
+        */
+        float const * local(std::int32_t k) const
+        {
+            return local_.data() + static_cast<std::size_t>(k) * stride_;
+        }
+
+        //! A public member function (constant).
+        /*!
+            一辺あたりのセルの個数を求める
+            \return 一辺あたりのセルの個数（整数値のfloat）
+        */
+        float ncell() const
+        {
+            return ncell_;
+        }
+
+        //! A public member function.
+        /*!
+            倍精度の座標から、セルの番号と相対座標を求め直す
+            \param atoms 原子の座標を保持するオブジェクト
+            \param numatom 原子数
+            \param periodiclen 周期境界条件の長さ
+            \param rc カットオフ半径
+            \return 箱がカットオフ半径の2倍より大きく、混合精度で計算できるならtrue
+        */
+        bool update(Atoms const & atoms, std::int32_t numatom, double periodiclen, double rc);
+
+        // #endregion メンバ関数
+
+        // #region メンバ変数
+
+    public:
+        //! A public member variable (constant).
+        /*!
+            セルの番号の一つの成分のビット数
+        */
+        static std::int32_t const CELLBITS = 10;
+
+        //! A public member variable (constant).
+        /*!
+            セルの番号の一つの成分を取り出すマスク
+        */
+        static std::int32_t const CELLMASK = (1 << MixedPositions::CELLBITS) - 1;
+
+        //! A public member variable (constant).
+        /*!
+            セルの一辺の長さの上限（無次元単位）
+            相対座標の絶対値はこれより小さいので、単精度での座標の誤差は1E-7程度になる
+        */
+        static double const MAXCELLLEN;
+
+    private:
+        //! A private member variable.
+        /*!
+            各原子のセルの番号
+        */
+        std::vector<std::int32_t, boost::alignment::aligned_allocator<std::int32_t, 64> > cell_;
+
+        //! A private member variable.
+        /*!
+            セルの一辺の長さ
+        */
+        float celllen_ = 0.0f;
+
+        //! A private member variable.
+        /*!
+            一辺あたりのセルの個数の逆数
+        */
+        float invncell_ = 0.0f;
+
+        //! A private member variable.
+        /*!
+            セルの原点からの相対座標の配列（x, y, z成分の順）
+        */
+        std::vector<float, boost::alignment::aligned_allocator<float, 64> > local_;
+
+        //! A private member variable.
+        /*!
+            一辺あたりのセルの個数
+        */
+        float ncell_ = 0.0f;
+
+        //! A private member variable.
+        /*!
+            各配列の要素数（64バイトの倍数に切り上げた原子数）
+        */
+        std::size_t stride_ = 0;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        MixedPositions(MixedPositions const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        MixedPositions & operator=(MixedPositions const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif      // _MIXEDPOSITIONS_H_
@@ -0,0 +1,58 @@
+﻿/*! \file pairlist.h
+    \brief 原子のペアリスト（CSR形式）の宣言と実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _PAIRLIST_H_
+#define _PAIRLIST_H_
+
+#pragma once
+
+#include <cstdint>  // for std::int32_t
+#include <vector>   // for std::vector
+
+namespace moleculardynamics {
+    //! A struct.
+    /*!
+        原子のペアリスト（CSR形式のハーフリスト）
+        i番目の原子のペアの相手（j > i）はneighbors[offsets[i]]からneighbors[offsets[i + 1] - 1]に格納される
+        クラスタのペアリストにも使い、その場合は相手のクラスタにi番目のクラスタ自身も含む（j >= i）
+    */
+    struct PairList {
+        //! A public member function.
+        /*!
+            ペアリストを空にする
+        */
+        void clear()
+        {
+            offsets.clear();
+            neighbors.clear();
+        }
+
+        //! A public member function (constant).
+        /*!
+            ペアの個数を求める
+            \return ペアの個数
+        */
+        std::vector<std::int32_t>::size_type size() const
+        {
+            return neighbors.size();
+        }
+
+        //! A public member variable.
+        /*!
+            各原子のペアの相手の先頭のインデックス（要素数は原子数（クラスタ数）+1）
+        */
+        std::vector<std::int32_t> offsets;
+
+        //! A public member variable.
+        /*!
+            ペアの相手の原子の番号
+        */
+        std::vector<std::int32_t> neighbors;
+    };
+}
+
+#endif      // _PAIRLIST_H_
@@ -0,0 +1,52 @@
+﻿/*! \file periodic.h
+    \brief 周期境界条件を扱う関数の宣言と実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _PERIODIC_H_
+#define _PERIODIC_H_
+
+#pragma once
+
+#include <cmath>    // for std::copysign
+#include <cstdint>  // for std::int32_t
+
+namespace moleculardynamics {
+    //! A function.
+    /*!
+        周期境界条件を考慮して、座標の差を最も近いイメージとの差に補正する
+        dv - L * round(dv / L)を分岐なしで計算するので、ベクトル化しやすい
+        \param dv 座標の差の一つの成分
+        \param periodiclen 周期境界条件の長さ
+        \param invperiodiclen 周期境界条件の長さの逆数
+        \return 補正された座標の差
+    */
+    inline double minimum_image(double dv, double periodiclen, double invperiodiclen)
+    {
+        // std::roundはSSE4.1がないと関数呼び出しになるので、
+        // 0.5を足して整数に変換（ゼロ方向に切り捨て）することで四捨五入する
+        auto const s = dv * invperiodiclen;
+        return dv - periodiclen * static_cast<double>(static_cast<std::int32_t>(s + std::copysign(0.5, s)));
+    }
+
+    //! A function.
+    /*!
+        周期境界条件を考慮して、座標を[0, periodiclen)の範囲に戻す
+        分岐を含まないので、ベクトル化しやすい
+        \param r 座標の一つの成分
+        \param periodiclen 周期境界条件の長さ
+        \param invperiodiclen 周期境界条件の長さの逆数
+        \return 範囲内に戻された座標
+    */
+    inline double wrap_periodic(double r, double periodiclen, double invperiodiclen)
+    {
+        // std::floorも同様に、整数への変換で切り捨ててから負の数を補正する
+        auto const s = r * invperiodiclen;
+        auto const t = static_cast<double>(static_cast<std::int32_t>(s));
+        return r - periodiclen * (t - static_cast<double>(t > s));
+    }
+}
+
+#endif      // _PERIODIC_H_
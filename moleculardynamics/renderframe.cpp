@@ -0,0 +1,33 @@
+﻿/*! \file renderframe.cpp
+    \brief 描画用に原子の座標と力の大きさを単精度で書き出す関数の実装（スカラー版）
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "renderframe.h"
+#include <algorithm>    // for std::min
+#include <cmath>        // for std::sqrt
+
+namespace moleculardynamics {
+    void export_frame_scalar(Atoms const & atoms, std::int32_t first, std::int32_t last, double center, float colorratio, float * frame)
+    {
+        auto const fx = atoms.data(Atoms::F, 0);
+        auto const fy = atoms.data(Atoms::F, 1);
+        auto const fz = atoms.data(Atoms::F, 2);
+        auto const rx = atoms.data(Atoms::R, 0);
+        auto const ry = atoms.data(Atoms::R, 1);
+        auto const rz = atoms.data(Atoms::R, 2);
+
+        for (auto i = first; i < last; i++) {
+            // AVX2版と同じく、力の大きさの2乗を単精度にしてから平方根を取る
+            auto const f2 = static_cast<float>(fx[i] * fx[i] + fy[i] * fy[i] + fz[i] * fz[i]);
+
+            auto const p = frame + 4 * static_cast<std::ptrdiff_t>(i);
+            p[0] = static_cast<float>(rx[i] - center);
+            p[1] = static_cast<float>(ry[i] - center);
+            p[2] = static_cast<float>(rz[i] - center);
+            p[3] = std::min(colorratio * std::sqrt(f2), 1.0f);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+﻿/*! \file renderframe.h
+    \brief 描画用に原子の座標と力の大きさを単精度で書き出す関数の宣言
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _RENDERFRAME_H_
+#define _RENDERFRAME_H_
+
+#pragma once
+
+#include "atoms.h"
+#include "forcekernel.h"
+#include <cstdint>  // for std::int32_t
+
+namespace moleculardynamics {
+    //! A function.
+    /*!
+        [first, last)番目の原子について、描画用のレコード(x, y, z, 色)を書き出す
+        座標は箱の中心を原点とし、色は力の大きさにcolorratioを掛けて1で飽和させた値
+        \param atoms 原子
+        \param first 最初の原子の番号
+        \param last 最後の原子の番号の次
+        \param center 箱の中心の座標（箱の一辺の長さの半分）
+        \param colorratio 力の大きさを色に変換する比率
+        \param frame レコードを書き込む配列（原子ごとにfloat 4個、書き込むだけで読み出さない）
+    */
+    void export_frame_scalar(Atoms const & atoms, std::int32_t first, std::int32_t last, double center, float colorratio, float * frame);
+
+    //! A function.
+    /*!
+        AVX2を使って、[first, last)番目の原子について描画用のレコードを書き出す
+        4原子ずつ単精度に変換し、4x4の転置でレコードの並びにしてから書き込む
+        \param atoms 原子
+        \param first 最初の原子の番号
+        \param last 最後の原子の番号の次
+        \param center 箱の中心の座標（箱の一辺の長さの半分）
+        \param colorratio 力の大きさを色に変換する比率
+        \param frame レコードを書き込む配列（原子ごとにfloat 4個、書き込むだけで読み出さない）
+    */
+    LJMD_TARGET_AVX2 void export_frame_avx2(Atoms const & atoms, std::int32_t first, std::int32_t last, double center, float colorratio, float * frame);
+}
+
+#endif      // _RENDERFRAME_H_
@@ -0,0 +1,62 @@
+﻿/*! \file renderframe_avx2.cpp
+    \brief 描画用に原子の座標と力の大きさを単精度で書き出す関数の実装（AVX2版）
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "renderframe.h"
+#include <boost/assert.hpp>     // for BOOST_ASSERT
+
+#ifdef LJMD_X86
+    #include <immintrin.h>      // for AVX2 intrinsics
+#endif
+
+namespace moleculardynamics {
+#ifdef LJMD_X86
+    LJMD_TARGET_AVX2 void export_frame_avx2(Atoms const & atoms, std::int32_t first, std::int32_t last, double center, float colorratio, float * frame)
+    {
+        auto const fx = atoms.data(Atoms::F, 0);
+        auto const fy = atoms.data(Atoms::F, 1);
+        auto const fz = atoms.data(Atoms::F, 2);
+        auto const rx = atoms.data(Atoms::R, 0);
+        auto const ry = atoms.data(Atoms::R, 1);
+        auto const rz = atoms.data(Atoms::R, 2);
+
+        auto const c = _mm256_set1_pd(center);
+        auto const ratio = _mm_set1_ps(colorratio);
+        auto const one = _mm_set1_ps(1.0f);
+
+        auto i = first;
+        for (; i + 4 <= last; i += 4) {
+            auto x = _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(rx + i), c));
+            auto y = _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(ry + i), c));
+            auto z = _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(rz + i), c));
+
+            auto const fxi = _mm256_loadu_pd(fx + i);
+            auto const fyi = _mm256_loadu_pd(fy + i);
+            auto const fzi = _mm256_loadu_pd(fz + i);
+            auto const f2 = _mm256_fmadd_pd(fxi, fxi, _mm256_fmadd_pd(fyi, fyi, _mm256_mul_pd(fzi, fzi)));
+            auto color = _mm_min_ps(_mm_mul_ps(ratio, _mm_sqrt_ps(_mm256_cvtpd_ps(f2))), one);
+
+            // 成分ごとのベクトル4本を、原子ごとのレコード4個に並べ替える
+            _MM_TRANSPOSE4_PS(x, y, z, color);
+
+            auto const p = frame + 4 * static_cast<std::ptrdiff_t>(i);
+            _mm_storeu_ps(p, x);
+            _mm_storeu_ps(p + 4, y);
+            _mm_storeu_ps(p + 8, z);
+            _mm_storeu_ps(p + 12, color);
+        }
+
+        if (i < last) {
+            export_frame_scalar(atoms, i, last, center, colorratio, frame);
+        }
+    }
+#else
+    void export_frame_avx2(Atoms const &, std::int32_t, std::int32_t, double, float, float *)
+    {
+        BOOST_ASSERT(!"AVX2版はx86以外では使えない");
+    }
+#endif
+}
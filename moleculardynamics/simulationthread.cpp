@@ -0,0 +1,152 @@
+﻿/*! \file simulationthread.cpp
+    \brief 分子動力学シミュレーションを専用のスレッドで進め、描画用のスナップショットを受け渡すクラスの実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "simulationthread.h"
+#include <cstddef>  // for std::size_t
+#include <utility>  // for std::swap
+
+namespace moleculardynamics {
+    // #region static public 定数
+
+    std::int32_t const SimulationThread::CAPTUREINTERVAL = 4;
+
+    // #endregion static public 定数
+
+    // #region コンストラクタ・デストラクタ
+
+    SimulationThread::SimulationThread(Ar_moleculardynamics & armd, float colorratio) : armd_(armd), colorratio_(colorratio)
+    {
+    }
+
+    SimulationThread::~SimulationThread()
+    {
+        stop();
+    }
+
+    // #endregion コンストラクタ・デストラクタ
+
+    // #region publicメンバ関数
+
+    void SimulationThread::post(std::function<void(Ar_moleculardynamics &)> const & command)
+    {
+        if (!thread_.joinable()) {
+            command(armd_);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        commands_.push_back(command);
+    }
+
+    Snapshot const & SimulationThread::snapshot() const
+    {
+        return snapshots_.front();
+    }
+
+    void SimulationThread::start()
+    {
+        if (thread_.joinable()) {
+            return;
+        }
+
+        // 最初のフレームから描画できるように、計算を始める前の状態を受け渡しておく
+        capture(snapshots_.back());
+        snapshots_.publish();
+        captured_ = std::chrono::steady_clock::now();
+
+        running_ = true;
+        thread_ = std::thread([this] { run(); });
+    }
+
+    void SimulationThread::stop()
+    {
+        if (!thread_.joinable()) {
+            return;
+        }
+
+        running_ = false;
+        thread_.join();
+
+        // 止めた後に残った操作はその場で実行する
+        drain();
+    }
+
+    bool SimulationThread::update()
+    {
+        return snapshots_.update();
+    }
+
+    // #endregion publicメンバ関数
+
+    // #region privateメンバ関数
+
+    void SimulationThread::capture(Snapshot & snapshot) const
+    {
+        auto const n = armd_.NumAtom();
+
+        // 描画スレッドはこのレコードを頂点バッファにそのまま写す
+        snapshot.frame.resize(4 * static_cast<std::size_t>(n));
+        armd_.exportRenderFrame(snapshot.frame.data(), colorratio_);
+
+        snapshot.deltat = armd_.getDeltat();
+        snapshot.latticeconst = armd_.getLatticeconst();
+        snapshot.MD_iter = armd_.MD_iter();
+        snapshot.Nc = armd_.Nc();
+        snapshot.NumAtom = n;
+        snapshot.periodiclen = armd_.periodiclen();
+        snapshot.Pgiven = armd_.getPgiven();
+        snapshot.pressure = armd_.getPressure();
+        snapshot.Tcalc = armd_.getTcalc();
+        snapshot.Tgiven = armd_.getTgiven();
+        snapshot.Uk = armd_.Uk();
+        snapshot.Up = armd_.Up();
+        snapshot.Utot = armd_.Utot();
+
+        auto const & timings = armd_.getTimings();
+        for (auto i = 0; i < Timings::NUMPHASE; i++) {
+            snapshot.timings[i] = timings.rolling(static_cast<PhaseType>(i));
+        }
+    }
+
+    void SimulationThread::drain()
+    {
+        // ロックしている間に操作を実行しないように、取り出してから実行する
+        std::vector<std::function<void(Ar_moleculardynamics &)> > commands;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::swap(commands, commands_);
+        }
+
+        for (auto const & command : commands) {
+            command(armd_);
+        }
+    }
+
+    void SimulationThread::run()
+    {
+        while (running_) {
+            drain();
+
+            armd_.calculate();
+
+            // 描画スレッドが前のスナップショットをまだ受け取っていなければ、毎ステップ作っても捨てられるだけなので、
+            // CAPTUREINTERVALミリ秒経つまでは作らずに次のステップに進む
+            // （全く作り直さないと、描画スレッドが次に受け取るのは前に受け取った直後のスナップショットになる）
+            auto const now = std::chrono::steady_clock::now();
+            if (snapshots_.pending() && now - captured_ < std::chrono::milliseconds(SimulationThread::CAPTUREINTERVAL)) {
+                continue;
+            }
+
+            // 受け渡し待ちだったバッファには古いスナップショットが残っているので、全体を書き直す
+            capture(snapshots_.back());
+            snapshots_.publish();
+            captured_ = now;
+        }
+    }
+
+    // #endregion privateメンバ関数
+}
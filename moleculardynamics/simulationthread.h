@@ -0,0 +1,296 @@
+﻿/*! \file simulationthread.h
+    \brief 分子動力学シミュレーションを専用のスレッドで進め、描画用のスナップショットを受け渡すクラスの宣言
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _SIMULATIONTHREAD_H_
+#define _SIMULATIONTHREAD_H_
+
+#pragma once
+
+#include "Ar_moleculardynamics.h"
+#include "../utility/triplebuffer.h"
+#include <array>        // for std::array
+#include <atomic>       // for std::atomic
+#include <chrono>       // for std::chrono
+#include <cstdint>      // for std::int32_t
+#include <functional>   // for std::function
+#include <mutex>        // for std::mutex
+#include <thread>       // for std::thread
+#include <vector>       // for std::vector
+
+namespace moleculardynamics {
+    //! A struct.
+    /*!
+        ある時刻のシミュレーションの状態のうち、描画と画面の表示に使うもの
+        エネルギーや温度などの単位はAr_moleculardynamicsのgetterと同じ
+    */
+    struct Snapshot {
+        //! A public member variable.
+        /*!
+            シミュレーションを開始してからの経過時間（ps）
+        */
+        double deltat = 0.0;
+
+        //! A public member variable.
+        /*!
+            描画用の原子のレコード（Ar_moleculardynamics::exportRenderFrame()の出力、原子ごとにfloat 4個）
+        */
+        std::vector<float> frame;
+
+        //! A public member variable.
+        /*!
+            格子定数（nm）
+        */
+        double latticeconst = 0.0;
+
+        //! A public member variable.
+        /*!
+            MDのステップ数
+        */
+        std::int32_t MD_iter = 0;
+
+        //! A public member variable.
+        /*!
+            スーパーセルの個数
+        */
+        std::int32_t Nc = 0;
+
+        //! A public member variable.
+        /*!
+            原子数
+        */
+        std::int32_t NumAtom = 0;
+
+        //! A public member variable.
+        /*!
+            周期境界条件の長さ（無次元単位）
+        */
+        double periodiclen = 0.0;
+
+        //! A public member variable.
+        /*!
+            与えた圧力（atm）
+        */
+        double Pgiven = 0.0;
+
+        //! A public member variable.
+        /*!
+            計算された圧力（atm）
+        */
+        double pressure = 0.0;
+
+        //! A public member variable.
+        /*!
+            計算された温度（K）
+        */
+        double Tcalc = 0.0;
+
+        //! A public member variable.
+        /*!
+            与えた温度（K）
+        */
+        double Tgiven = 0.0;
+
+        //! A public member variable.
+        /*!
+            MDの各段階にかかった時間（直近のステップの平均、秒）
+        */
+        std::array<double, Timings::NUMPHASE> timings = {};
+
+        //! A public member variable.
+        /*!
+            運動エネルギー（Hartree）
+        */
+        double Uk = 0.0;
+
+        //! A public member variable.
+        /*!
+            ポテンシャルエネルギー（Hartree）
+        */
+        double Up = 0.0;
+
+        //! A public member variable.
+        /*!
+            全エネルギー（Hartree）
+        */
+        double Utot = 0.0;
+    };
+
+    //! A class.
+    /*!
+        Ar_moleculardynamicsを専用のスレッドでできるだけ速く進め、
+        ステップの後にスナップショットをトリプルバッファで受け渡すクラス
+        描画側が前のスナップショットをまだ受け取っていないときは、CAPTUREINTERVALミリ秒ごとにだけ作り直して置き換える
+        （毎ステップ作ると捨てられる分が無駄になり、全く作り直さないと描画するスナップショットが描画の間隔1回分古くなる）
+        描画側が受け取るスナップショットは、高々CAPTUREINTERVALミリ秒と1ステップ分だけ古い
+        スレッドが動いている間、Ar_moleculardynamicsにはpost()で渡した関数を通してだけ触ること
+    */
+    class SimulationThread final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+            \param armd スレッドで進めるシミュレーションのオブジェクト
+            \param colorratio 力の大きさを描画する色に変換する比率
+        */
+        SimulationThread(Ar_moleculardynamics & armd, float colorratio);
+
+        //! A destructor.
+        /*!
+            スレッドが動いていれば止める
+        */
+        ~SimulationThread();
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region メンバ関数
+
+        //! A public member function.
+        /*!
+            シミュレーションのオブジェクトへの操作を、次のステップの前に計算スレッドで実行させる
+            スレッドが止まっているときは、その場で実行する
+            \param command シミュレーションのオブジェクトへの操作
+        */
+        void post(std::function<void(Ar_moleculardynamics &)> const & command);
+
+        //! A public member function (constant).
+        /*!
+            最後に受け取ったスナップショットを返す
+            update()と同じスレッドからだけ呼ぶこと
+            \return 最後に受け取ったスナップショット
+        */
+        Snapshot const & snapshot() const;
+
+        //! A public member function.
+        /*!
+            現在の状態のスナップショットを受け渡してから、計算スレッドを開始する
+        */
+        void start();
+
+        //! A public member function.
+        /*!
+            計算スレッドを止め、終わるまで待つ
+        */
+        void stop();
+
+        //! A public member function.
+        /*!
+            新しいスナップショットがあれば受け取る
+            \return 新しいスナップショットを受け取ったらtrue
+        */
+        bool update();
+
+    private:
+        //! A private member function.
+        /*!
+            現在の状態をスナップショットに写す
+            \param snapshot 写す先のスナップショット
+        */
+        void capture(Snapshot & snapshot) const;
+
+        //! A private member function.
+        /*!
+            溜まっている操作を全て実行する
+        */
+        void drain();
+
+        //! A private member function.
+        /*!
+            計算スレッドの本体
+        */
+        void run();
+
+        // #endregion メンバ関数
+
+        // #region メンバ変数
+
+    public:
+        //! A public member variable (constant).
+        /*!
+            受け取られていないスナップショットを作り直す間隔（ミリ秒）
+        */
+        static std::int32_t const CAPTUREINTERVAL;
+
+    private:
+        //! A private member variable.
+        /*!
+            シミュレーションのオブジェクト
+        */
+        Ar_moleculardynamics & armd_;
+
+        //! A private member variable.
+        /*!
+            最後にスナップショットを受け渡した時刻（計算スレッドだけが触る）
+        */
+        std::chrono::steady_clock::time_point captured_;
+
+        //! A private member variable.
+        /*!
+            次のステップの前に実行する操作
+        */
+        std::vector<std::function<void(Ar_moleculardynamics &)> > commands_;
+
+        //! A private member variable (constant).
+        /*!
+            力の大きさを描画する色に変換する比率
+        */
+        float const colorratio_;
+
+        //! A private member variable.
+        /*!
+            commands_を守るミューテックス
+        */
+        std::mutex mutex_;
+
+        //! A private member variable.
+        /*!
+            計算スレッドを続けるならtrue
+        */
+        std::atomic<bool> running_ { false };
+
+        //! A private member variable.
+        /*!
+            スナップショットのトリプルバッファ
+        */
+        utility::TripleBuffer<Snapshot> snapshots_;
+
+        //! A private member variable.
+        /*!
+            計算スレッド
+        */
+        std::thread thread_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        SimulationThread() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        SimulationThread(SimulationThread const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        SimulationThread & operator=(SimulationThread const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif      // _SIMULATIONTHREAD_H_
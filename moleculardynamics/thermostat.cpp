@@ -0,0 +1,242 @@
+﻿/*! \file thermostat.cpp
+    \brief NVTアンサンブルの温度制御を行うクラスの実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "thermostat.h"
+#include <cmath>                        // for std::exp, std::sqrt
+#include <functional>                   // for std::ref
+#include <limits>                       // for std::numeric_limits
+#include <sstream>                      // for std::istringstream, std::ostringstream
+#include <vector>                       // for std::vector
+#include <boost/assert.hpp>             // for BOOST_ASSERT
+#include <boost/range/algorithm.hpp>    // for boost::generate
+
+namespace moleculardynamics {
+    // #region static public 定数
+
+    double const Thermostat::ALPHA = 0.2;
+
+    double const Thermostat::FIRSTTAU = 0.1;
+
+    // #endregion static public 定数
+
+    // #region コンストラクタ
+
+    Thermostat::Thermostat()
+    {
+        // 乱数エンジンの初期化はmyrandom::MyRandと同じ
+        std::random_device rnd;
+        std::vector<std::uint_least32_t> v(64);
+        boost::generate(v, std::ref(rnd));
+        std::seed_seq seq(v.begin(), v.end());
+        randengine_ = std::mt19937(seq);
+
+        reset();
+    }
+
+    // #endregion コンストラクタ
+
+    // #region publicメンバ関数
+
+    double Thermostat::begin_step(double Uk, double Tg, std::int32_t nf, double dt)
+    {
+        switch (type_) {
+        case ThermostatType::WOODCOCK:
+            // T' = Tg + α(T - Tg)
+            return rescale(Uk, Tg, nf, 1.0 - Thermostat::ALPHA);
+
+        case ThermostatType::BERENDSEN:
+            // T' = T + Δt / τ (Tg - T)
+            return rescale(Uk, Tg, nf, dt / tau_);
+
+        case ThermostatType::NOSEHOOVER:
+            return nhc_halfstep(Uk, Tg, nf, dt);
+
+        case ThermostatType::LANGEVIN:
+            return 1.0;
+
+        default:
+            BOOST_ASSERT(!"何かがおかしい！");
+            return 1.0;
+        }
+    }
+
+    double Thermostat::damping(double dt) const
+    {
+        return std::exp(-dt / tau_);
+    }
+
+    double Thermostat::end_step(double Uk, double Tg, std::int32_t nf, double dt)
+    {
+        return type_ == ThermostatType::NOSEHOOVER ? nhc_halfstep(Uk, Tg, nf, dt) : 1.0;
+    }
+
+    double Thermostat::energy(double Tg, std::int32_t nf) const
+    {
+        if (type_ != ThermostatType::NOSEHOOVER) {
+            return 0.0;
+        }
+
+        auto const q = Tg * tau_ * tau_;
+
+        // 最初の熱浴だけは自由度nfの系とつながっている
+        auto e = 0.5 * static_cast<double>(nf) * q * vxi_[0] * vxi_[0] + static_cast<double>(nf) * Tg * xi_[0];
+        for (auto j = 1; j < Thermostat::NCHAIN; j++) {
+            e += 0.5 * q * vxi_[j] * vxi_[j] + Tg * xi_[j];
+        }
+
+        return e;
+    }
+
+    double Thermostat::getTau() const
+    {
+        return tau_;
+    }
+
+    ThermostatType Thermostat::getType() const
+    {
+        return type_;
+    }
+
+    double Thermostat::noise(double Tg, double dt) const
+    {
+        return std::sqrt((1.0 - std::exp(-2.0 * dt / tau_)) * Tg);
+    }
+
+    bool Thermostat::loadState(std::string const & state)
+    {
+        std::istringstream is(state);
+
+        std::int32_t type;
+        double tau;
+        is >> type >> tau;
+
+        std::array<double, Thermostat::NCHAIN> vxi, xi;
+        for (auto j = 0; j < Thermostat::NCHAIN; j++) {
+            is >> vxi[j] >> xi[j];
+        }
+
+        // 乱数エンジンと分布は、標準ライブラリが定めるテキストの形式で読み込む
+        std::mt19937 randengine;
+        std::normal_distribution<double> distribution;
+        is >> randengine >> distribution;
+
+        if (!is || type < static_cast<std::int32_t>(ThermostatType::WOODCOCK) || type > static_cast<std::int32_t>(ThermostatType::LANGEVIN) || !(tau > 0.0)) {
+            return false;
+        }
+
+        type_ = static_cast<ThermostatType>(type);
+        tau_ = tau;
+        vxi_ = vxi;
+        xi_ = xi;
+        randengine_ = randengine;
+        distribution_ = distribution;
+
+        return true;
+    }
+
+    void Thermostat::reset()
+    {
+        vxi_.fill(0.0);
+        xi_.fill(0.0);
+    }
+
+    std::string Thermostat::saveState() const
+    {
+        // 読み込んだときに同じ値に戻るだけの桁数で書き出す
+        std::ostringstream os;
+        os.precision(std::numeric_limits<double>::max_digits10);
+        os << static_cast<std::int32_t>(type_) << ' ' << tau_;
+
+        for (auto j = 0; j < Thermostat::NCHAIN; j++) {
+            os << ' ' << vxi_[j] << ' ' << xi_[j];
+        }
+
+        os << ' ' << randengine_ << ' ' << distribution_;
+
+        return os.str();
+    }
+
+    void Thermostat::setTau(double tau)
+    {
+        BOOST_ASSERT(tau > 0.0);
+
+        tau_ = tau;
+    }
+
+    void Thermostat::setType(ThermostatType type)
+    {
+        type_ = type;
+        reset();
+    }
+
+    // #endregion publicメンバ関数
+
+    // #region privateメンバ関数
+
+    double Thermostat::nhc_halfstep(double Uk, double Tg, std::int32_t nf, double dt)
+    {
+        BOOST_ASSERT(Tg > 0.0);
+
+        // Martyna-Tuckerman-Kleinの方法で、熱浴の変数を半ステップ分（Δt / 2）時間発展させる
+        // 熱浴の質量は、最初の熱浴がnfTτ^2、それ以外はTτ^2
+        std::array<double, Thermostat::NCHAIN> q;
+        q.fill(Tg * tau_ * tau_);
+        q[0] *= static_cast<double>(nf);
+
+        auto const h = 0.5 * dt;
+        auto const h2 = 0.5 * h;
+        auto const h4 = 0.25 * h;
+        auto const kT = Tg;
+        auto twoK = 2.0 * Uk;
+
+        // j番目の熱浴に働く「力」
+        auto const g = [this, &q, &twoK, kT, nf](std::int32_t j) {
+            return j == 0 ?
+                (twoK - static_cast<double>(nf) * kT) / q[0] :
+                (q[j - 1] * vxi_[j - 1] * vxi_[j - 1] - kT) / q[j];
+        };
+
+        // 鎖の端から順に熱浴の速度を更新する
+        auto const last = Thermostat::NCHAIN - 1;
+        vxi_[last] += h2 * g(last);
+        for (auto j = last - 1; j >= 0; j--) {
+            auto const e = std::exp(-h4 * vxi_[j + 1]);
+            vxi_[j] = (vxi_[j] * e + h2 * g(j)) * e;
+        }
+
+        // 原子の速度に掛ける係数
+        auto const s = std::exp(-h * vxi_[0]);
+        twoK *= s * s;
+
+        for (auto j = 0; j < Thermostat::NCHAIN; j++) {
+            xi_[j] += h * vxi_[j];
+        }
+
+        // 鎖の先頭から順に熱浴の速度を更新する
+        for (auto j = 0; j < last; j++) {
+            auto const e = std::exp(-h4 * vxi_[j + 1]);
+            vxi_[j] = (vxi_[j] * e + h2 * g(j)) * e;
+        }
+        vxi_[last] += h2 * g(last);
+
+        return s;
+    }
+
+    double Thermostat::rescale(double Uk, double Tg, std::int32_t nf, double ratio) const
+    {
+        auto const T = 2.0 * Uk / static_cast<double>(nf);
+
+        // 速度が全てゼロのときはスケーリングできない
+        if (T <= 0.0) {
+            return 1.0;
+        }
+
+        return std::sqrt(1.0 + ratio * (Tg / T - 1.0));
+    }
+
+    // #endregion privateメンバ関数
+}
@@ -0,0 +1,276 @@
+﻿/*! \file thermostat.h
+    \brief NVTアンサンブルの温度制御を行うクラスの宣言
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _THERMOSTAT_H_
+#define _THERMOSTAT_H_
+
+#pragma once
+
+#include <array>    // for std::array
+#include <cstdint>  // for std::int32_t
+#include <random>   // for std::mt19937, std::normal_distribution
+#include <string>   // for std::string
+
+namespace moleculardynamics {
+    //! A enumerated type
+    /*!
+        温度制御の方法
+    */
+    enum class ThermostatType : std::int32_t {
+        // Woodcockの速度スケーリング
+        WOODCOCK = 0,
+        // Berendsenの速度スケーリング
+        BERENDSEN = 1,
+        // Nosé-Hooverチェイン
+        NOSEHOOVER = 2,
+        // Langevin熱浴
+        LANGEVIN = 3
+    };
+
+    //! A class.
+    /*!
+        速度Verlet法に組み込む温度制御のクラス
+        速度の更新は原子のループの中で行われるので、このクラスは全ての原子の速度に掛ける係数
+        （Langevin熱浴では摩擦の係数と揺動力の大きさ）を求めるだけで、原子のループを持たない
+    */
+    class Thermostat final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+        */
+        Thermostat();
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~Thermostat() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region メンバ関数
+
+        //! A public member function.
+        /*!
+            速度Verlet法の最初の速度の更新の前に、全ての原子の速度に掛ける係数を求める
+            \param Uk 現在の運動エネルギー（無次元単位）
+            \param Tg 与える温度（無次元単位）
+            \param nf 自由度
+            \param dt 時間刻み
+            \return 速度に掛ける係数
+        */
+        double begin_step(double Uk, double Tg, std::int32_t nf, double dt);
+
+        //! A public member function (constant).
+        /*!
+            Langevin熱浴で、速度Verlet法の最後の速度の更新の後に速度に掛ける摩擦の係数を求める
+            \param dt 時間刻み
+            \return 摩擦の係数exp(-γΔt)
+        */
+        double damping(double dt) const;
+
+        //! A public member function.
+        /*!
+            速度Verlet法の最後の速度の更新の後に、全ての原子の速度に掛ける係数を求める
+            Nosé-Hooverチェインの後半の半ステップに対応し、それ以外では1を返す
+            \param Uk 現在の運動エネルギー（無次元単位）
+            \param Tg 与える温度（無次元単位）
+            \param nf 自由度
+            \param dt 時間刻み
+            \return 速度に掛ける係数
+        */
+        double end_step(double Uk, double Tg, std::int32_t nf, double dt);
+
+        //! A public member function (constant).
+        /*!
+            Nosé-Hooverチェインの熱浴のエネルギーを求める
+            系の全エネルギーとの和が保存量になる（他の方法では0を返す）
+            \param Tg 与える温度（無次元単位）
+            \param nf 自由度
+            \return 熱浴のエネルギー（無次元単位）
+        */
+        double energy(double Tg, std::int32_t nf) const;
+
+        //! A public member function.
+        /*!
+            標準正規分布に従う乱数を生成する
+            \return 標準正規分布に従う乱数
+        */
+        double gaussian()
+        {
+            return distribution_(randengine_);
+        }
+
+        //! A public member function (constant).
+        /*!
+            温度制御の緩和時間を求める
+            \return 緩和時間（無次元単位）
+        */
+        double getTau() const;
+
+        //! A public member function (constant).
+        /*!
+            温度制御の方法を求める
+            \return 温度制御の方法
+        */
+        ThermostatType getType() const;
+
+        //! A public member function (constant).
+        /*!
+            Langevin熱浴で、摩擦の後に加える揺動力（速度の変化）の標準偏差を求める
+            \param Tg 与える温度（無次元単位）
+            \param dt 時間刻み
+            \return 揺動力の標準偏差sqrt((1 - exp(-2γΔt))T)
+        */
+        double noise(double Tg, double dt) const;
+
+        //! A public member function.
+        /*!
+            saveState()で書き出した状態（乱数エンジンの状態を含む）を読み込む
+            読み込めなかったときは状態を変えない
+            \param state 状態を表す文字列
+            \return 読み込めたらtrue
+        */
+        bool loadState(std::string const & state);
+
+        //! A public member function.
+        /*!
+            熱浴の状態を初期化する
+        */
+        void reset();
+
+        //! A public member function (constant).
+        /*!
+            チェックポイントに保存するために、制御の方法、緩和時間と熱浴の状態（乱数エンジンの状態を含む）を文字列に書き出す
+            \return 状態を表す文字列
+        */
+        std::string saveState() const;
+
+        //! A public member function.
+        /*!
+            温度制御の緩和時間を設定する
+            Berendsenの緩和時間、Nosé-Hooverチェインの熱浴の周期、Langevin熱浴の摩擦係数の逆数に使う
+            \param tau 緩和時間（無次元単位）
+        */
+        void setTau(double tau);
+
+        //! A public member function.
+        /*!
+            温度制御の方法を設定する
+            \param type 温度制御の方法
+        */
+        void setType(ThermostatType type);
+
+    private:
+        //! A private member function.
+        /*!
+            Nosé-Hooverチェインの熱浴の変数を半ステップ分時間発展させる
+            \param Uk 現在の運動エネルギー（無次元単位）
+            \param Tg 与える温度（無次元単位）
+            \param nf 自由度
+            \param dt 時間刻み
+            \return 速度に掛ける係数
+        */
+        double nhc_halfstep(double Uk, double Tg, std::int32_t nf, double dt);
+
+        //! A private member function (constant).
+        /*!
+            速度スケーリングの係数を求める
+            \param Uk 現在の運動エネルギー（無次元単位）
+            \param Tg 与える温度（無次元単位）
+            \param nf 自由度
+            \param ratio 1ステップで目標の温度に近づける割合
+            \return 速度に掛ける係数
+        */
+        double rescale(double Uk, double Tg, std::int32_t nf, double ratio) const;
+
+        // #endregion メンバ関数
+
+        // #region メンバ変数
+
+    public:
+        //! A public member variable (constant).
+        /*!
+            Woodcockの温度スケーリングの係数
+        */
+        static double const ALPHA;
+
+        //! A public member variable (constant).
+        /*!
+            初期の緩和時間（無次元単位）
+        */
+        static double const FIRSTTAU;
+
+        //! A public member variable (constant).
+        /*!
+            Nosé-Hooverチェインの長さ
+        */
+        static std::int32_t const NCHAIN = 3;
+
+    private:
+        //! A private member variable.
+        /*!
+            乱数の分布
+        */
+        std::normal_distribution<double> distribution_;
+
+        //! A private member variable.
+        /*!
+            乱数エンジン
+        */
+        std::mt19937 randengine_;
+
+        //! A private member variable.
+        /*!
+            緩和時間
+        */
+        double tau_ = Thermostat::FIRSTTAU;
+
+        //! A private member variable.
+        /*!
+            温度制御の方法
+        */
+        ThermostatType type_ = ThermostatType::WOODCOCK;
+
+        //! A private member variable.
+        /*!
+            Nosé-Hooverチェインの熱浴の速度
+        */
+        std::array<double, Thermostat::NCHAIN> vxi_;
+
+        //! A private member variable.
+        /*!
+            Nosé-Hooverチェインの熱浴の座標
+        */
+        std::array<double, Thermostat::NCHAIN> xi_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        Thermostat(Thermostat const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        Thermostat & operator=(Thermostat const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif      // _THERMOSTAT_H_
@@ -0,0 +1,334 @@
+﻿/*! \file timings.h
+    \brief MDの各段階にかかった時間を記録するクラスの宣言と実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _TIMINGS_H_
+#define _TIMINGS_H_
+
+#pragma once
+
+#include <algorithm>    // for std::min
+#include <array>        // for std::array
+#include <chrono>       // for std::chrono
+#include <cstdint>      // for std::int32_t, std::int64_t
+
+// LJMD_ENABLE_TIMERSが定義されていないときは、計測のコードは何も生成されない
+#ifdef LJMD_ENABLE_TIMERS
+    #define LJMD_TIMER_CONCAT_IMPL(a, b) a##b
+    #define LJMD_TIMER_CONCAT(a, b) LJMD_TIMER_CONCAT_IMPL(a, b)
+    #define LJMD_PHASE_TIMER(timings, phase) \
+        moleculardynamics::ScopedPhaseTimer LJMD_TIMER_CONCAT(ljmd_phase_timer_, __LINE__)(timings, phase)
+    #define LJMD_END_STEP(timings) (timings).endStep()
+#else
+    #define LJMD_PHASE_TIMER(timings, phase) static_cast<void>(0)
+    #define LJMD_END_STEP(timings) static_cast<void>(0)
+#endif
+
+namespace moleculardynamics {
+    //! A enumerated type
+    /*!
+        時間を計測するMDの段階
+    */
+    enum class PhaseType : std::int32_t {
+        // ペアリストの作成（近傍探索）
+        NEIGHBOR = 0,
+        // 原子間力の計算
+        FORCE = 1,
+        // 座標と運動量の更新（積分）
+        INTEGRATION = 2,
+        // スレッドごとのバッファや運動エネルギーの足し合わせ
+        REDUCTION = 3,
+        // 段階の数
+        NUMPHASE = 4
+    };
+
+    //! A class.
+    /*!
+        MDの各段階にかかった時間を、1ステップごとに集計して記録するクラス
+    */
+    class Timings final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+        */
+        Timings()
+        {
+            reset();
+        }
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~Timings() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region メンバ関数
+
+        //! A public member function.
+        /*!
+            現在のステップの段階phaseにかかった時間を加算する
+            \param phase 段階
+            \param seconds かかった時間（秒）
+        */
+        void add(PhaseType phase, double seconds)
+        {
+            current_[index(phase)] += seconds;
+        }
+
+        //! A public member function (constant).
+        /*!
+            段階phaseの1ステップあたりの平均の時間を求める
+            \param phase 段階
+            \return 最初から（reset()してから）の平均の時間（秒）
+        */
+        double average(PhaseType phase) const
+        {
+            return steps_ > 0 ? total_[index(phase)] / static_cast<double>(steps_) : 0.0;
+        }
+
+        //! A public member function.
+        /*!
+            現在のステップを終了し、各段階の時間を集計する
+        */
+        void endStep()
+        {
+            for (auto i = 0; i < Timings::NUMPHASE; i++) {
+                auto const t = current_[i];
+                last_[i] = t;
+                total_[i] += t;
+                windowsum_[i] += t - window_[i][windowpos_];
+                window_[i][windowpos_] = t;
+                current_[i] = 0.0;
+            }
+
+            windowpos_ = (windowpos_ + 1) % Timings::WINDOW;
+            steps_++;
+        }
+
+        //! A public member function (constant).
+        /*!
+            段階phaseの直前のステップの時間を求める
+            \param phase 段階
+            \return 直前のステップの時間（秒）
+        */
+        double last(PhaseType phase) const
+        {
+            return last_[index(phase)];
+        }
+
+        //! A public member function.
+        /*!
+            記録を全て消去する
+        */
+        void reset()
+        {
+            current_.fill(0.0);
+            last_.fill(0.0);
+            total_.fill(0.0);
+            windowsum_.fill(0.0);
+            for (auto && w : window_) {
+                w.fill(0.0);
+            }
+
+            windowpos_ = 0;
+            steps_ = 0;
+        }
+
+        //! A public member function (constant).
+        /*!
+            段階phaseの直近WINDOWステップの平均の時間を求める
+            \param phase 段階
+            \return 直近のステップの平均の時間（秒）
+        */
+        double rolling(PhaseType phase) const
+        {
+            auto const n = std::min(steps_, static_cast<std::int64_t>(Timings::WINDOW));
+            return n > 0 ? windowsum_[index(phase)] / static_cast<double>(n) : 0.0;
+        }
+
+        //! A public member function (constant).
+        /*!
+            集計したステップ数を求める
+            \return 集計したステップ数
+        */
+        std::int64_t steps() const
+        {
+            return steps_;
+        }
+
+        //! A public member function (constant).
+        /*!
+            段階phaseにかかった時間の合計を求める
+            \param phase 段階
+            \return 時間の合計（秒）
+        */
+        double total(PhaseType phase) const
+        {
+            return total_[index(phase)];
+        }
+
+    private:
+        //! A private static member function.
+        /*!
+            段階を配列の添字に変換する
+            \param phase 段階
+            \return 配列の添字
+        */
+        static std::int32_t index(PhaseType phase)
+        {
+            return static_cast<std::int32_t>(phase);
+        }
+
+        // #endregion メンバ関数
+
+        // #region メンバ変数
+
+    public:
+        //! A public member variable (constant).
+        /*!
+            段階の数
+        */
+        static std::int32_t const NUMPHASE = static_cast<std::int32_t>(PhaseType::NUMPHASE);
+
+        //! A public member variable (constant).
+        /*!
+            移動平均を取るステップ数
+        */
+        static std::int32_t const WINDOW = 100;
+
+    private:
+        //! A private member variable.
+        /*!
+            現在のステップの各段階の時間
+        */
+        std::array<double, Timings::NUMPHASE> current_;
+
+        //! A private member variable.
+        /*!
+            直前のステップの各段階の時間
+        */
+        std::array<double, Timings::NUMPHASE> last_;
+
+        //! A private member variable.
+        /*!
+            集計したステップ数
+        */
+        std::int64_t steps_;
+
+        //! A private member variable.
+        /*!
+            各段階の時間の合計
+        */
+        std::array<double, Timings::NUMPHASE> total_;
+
+        //! A private member variable.
+        /*!
+            各段階の直近WINDOWステップの時間
+        */
+        std::array<std::array<double, Timings::WINDOW>, Timings::NUMPHASE> window_;
+
+        //! A private member variable.
+        /*!
+            次に書き込むwindow_の位置
+        */
+        std::int32_t windowpos_;
+
+        //! A private member variable.
+        /*!
+            各段階の直近WINDOWステップの時間の和
+        */
+        std::array<double, Timings::NUMPHASE> windowsum_;
+
+        // #endregion メンバ変数
+    };
+
+    //! A class.
+    /*!
+        スコープを抜けるまでの時間を計測してTimingsに加算するクラス
+        LJMD_PHASE_TIMERマクロを通して使う
+    */
+    class ScopedPhaseTimer final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            唯一のコンストラクタ
+            \param timings 時間を加算するオブジェクト
+            \param phase 段階
+        */
+        ScopedPhaseTimer(Timings & timings, PhaseType phase)
+            : begin_(std::chrono::steady_clock::now()), phase_(phase), timings_(timings)
+        {
+        }
+
+        //! A destructor.
+        /*!
+            デストラクタ
+            経過時間をTimingsに加算する
+        */
+        ~ScopedPhaseTimer()
+        {
+            timings_.add(phase_, std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_).count());
+        }
+
+        // #endregion コンストラクタ・デストラクタ
+
+    private:
+        // #region メンバ変数
+
+        //! A private member variable (constant).
+        /*!
+            計測を開始した時刻
+        */
+        std::chrono::steady_clock::time_point const begin_;
+
+        //! A private member variable (constant).
+        /*!
+            段階
+        */
+        PhaseType const phase_;
+
+        //! A private member variable.
+        /*!
+            時間を加算するオブジェクト
+        */
+        Timings & timings_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        ScopedPhaseTimer() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        ScopedPhaseTimer(ScopedPhaseTimer const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        ScopedPhaseTimer & operator=(ScopedPhaseTimer const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif      // _TIMINGS_H_
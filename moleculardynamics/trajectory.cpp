@@ -0,0 +1,407 @@
+﻿/*! \file trajectory.cpp
+    \brief トラジェクトリ（原子の座標などの時系列）をバックグラウンドのスレッドでファイルに書き出すクラスの実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "trajectory.h"
+#include "compressedtrajectory.h"
+#include "../utility/binaryio.h"
+#include <algorithm>    // for std::replace
+#include <chrono>       // for std::chrono
+#include <cstddef>      // for std::size_t
+#include <cstdio>       // for std::snprintf
+#include <cstring>      // for std::memset
+#include <ostream>      // for std::ostream
+#include <string>       // for std::string
+#include <boost/assert.hpp>  // for BOOST_ASSERT
+
+namespace moleculardynamics {
+    namespace {
+        //! A global variable (constant).
+        /*!
+            1 AKMA時間単位（DCDのヘッダの時間刻みの単位）のps
+        */
+        double const AKMATIME = 0.04888821;
+
+        //! A global variable (constant).
+        /*!
+            RAW形式のファイルの先頭の文字列
+        */
+        char const RAWMAGIC[8] = { 'L', 'J', 'M', 'D', 'T', 'R', 'A', 'J' };
+
+        //! A global variable (constant).
+        /*!
+            RAW形式の版
+        */
+        std::uint32_t const RAWVERSION = 1;
+
+        //! A function.
+        /*!
+            DCD形式のヘッダを書き出す
+            DCDはFortranの書式なしのレコードの並びで、各レコードの前後にレコードのバイト数を置く
+            フレームの数はファイルを閉じるときに書き直す
+            \param os 書き出すストリーム
+            \param frame 最初のフレーム
+            \param interval フレームの間隔（ステップ数）
+        */
+        void put_dcd_header(std::ostream & os, TrajectoryFrame const & frame, std::int32_t interval)
+        {
+            // 1番目のレコード："CORD"と20個の整数（CHARMMの形式）
+            put_le<std::int32_t>(os, 84);
+            os.write("CORD", 4);
+            put_le<std::int32_t>(os, 0);                // フレームの数（閉じるときに書き直す）
+            put_le<std::int32_t>(os, frame.MD_iter);    // 最初のフレームのステップ数
+            put_le<std::int32_t>(os, interval);         // フレームの間隔
+            for (auto i = 0; i < 6; i++) {
+                put_le<std::int32_t>(os, 0);
+            }
+            put_le(os, static_cast<float>(frame.timestep / AKMATIME));
+            put_le<std::int32_t>(os, 1);                // 各フレームに箱の大きさを置く
+            for (auto i = 0; i < 8; i++) {
+                put_le<std::int32_t>(os, 0);
+            }
+            put_le<std::int32_t>(os, 24);               // CHARMMの版
+            put_le<std::int32_t>(os, 84);
+
+            // 2番目のレコード：80文字のタイトル2行
+            char title[2][80];
+            std::memset(title, ' ', sizeof(title));
+            std::snprintf(title[0], sizeof(title[0]), "REMARKS Lennard-Jones argon, LJ_Argon_MD");
+            std::snprintf(title[1], sizeof(title[1]), "REMARKS %d atoms, box %.6f A", frame.NumAtom, frame.box);
+            std::replace(title[0], title[0] + sizeof(title), '\0', ' ');
+            put_le<std::int32_t>(os, 4 + static_cast<std::int32_t>(sizeof(title)));
+            put_le<std::int32_t>(os, 2);
+            os.write(title[0], sizeof(title));
+            put_le<std::int32_t>(os, 4 + static_cast<std::int32_t>(sizeof(title)));
+
+            // 3番目のレコード：原子数
+            put_le<std::int32_t>(os, 4);
+            put_le<std::int32_t>(os, frame.NumAtom);
+            put_le<std::int32_t>(os, 4);
+        }
+
+        //! A function.
+        /*!
+            DCD形式のフレームを書き出す
+            箱の大きさ(A, γ, B, β, α, C)のレコードの後に、x, y, z成分ごとに単精度の座標のレコードが続く
+            \param os 書き出すストリーム
+            \param frame フレーム
+        */
+        void put_dcd_frame(std::ostream & os, TrajectoryFrame const & frame)
+        {
+            double const cell[6] = { frame.box, 90.0, frame.box, 90.0, 90.0, frame.box };
+            put_le<std::int32_t>(os, static_cast<std::int32_t>(sizeof(cell)));
+            put_le(os, cell, 6);
+            put_le<std::int32_t>(os, static_cast<std::int32_t>(sizeof(cell)));
+
+            std::vector<float> buf(frame.NumAtom);
+            auto const bytes = static_cast<std::int32_t>(sizeof(float) * buf.size());
+            for (auto k = 0; k < 3; k++) {
+                for (auto n = 0; n < frame.NumAtom; n++) {
+                    buf[n] = static_cast<float>(frame.position[3 * static_cast<std::size_t>(n) + k]);
+                }
+
+                put_le(os, bytes);
+                put_le(os, buf.data(), buf.size());
+                put_le(os, bytes);
+            }
+        }
+
+        //! A function.
+        /*!
+            RAW形式のヘッダを書き出す
+            "LJMDTRAJ"、版（uint32）、速度と力を含むかのフラグ（uint32、1が速度、2が力）、原子数（int32）、0（int32）
+            \param os 書き出すストリーム
+            \param frame 最初のフレーム
+        */
+        void put_raw_header(std::ostream & os, TrajectoryFrame const & frame)
+        {
+            auto const flags = (frame.velocity.empty() ? 0U : 1U) | (frame.force.empty() ? 0U : 2U);
+
+            os.write(RAWMAGIC, sizeof(RAWMAGIC));
+            put_le(os, RAWVERSION);
+            put_le<std::uint32_t>(os, flags);
+            put_le(os, frame.NumAtom);
+            put_le<std::int32_t>(os, 0);
+        }
+
+        //! A function.
+        /*!
+            RAW形式のフレームを書き出す
+            ステップ数（int32）、0（int32）、時間、箱の一辺の長さ、座標、（速度）、（力）を倍精度で書き出す
+            \param os 書き出すストリーム
+            \param frame フレーム
+        */
+        void put_raw_frame(std::ostream & os, TrajectoryFrame const & frame)
+        {
+            put_le(os, frame.MD_iter);
+            put_le<std::int32_t>(os, 0);
+            put_le(os, frame.time);
+            put_le(os, frame.box);
+            put_le(os, frame.position.data(), frame.position.size());
+            put_le(os, frame.velocity.data(), frame.velocity.size());
+            put_le(os, frame.force.data(), frame.force.size());
+        }
+
+        //! A function.
+        /*!
+            XYZ形式のフレームを書き出す
+            コメント行はextended XYZの書式で、箱、列の意味、時間とステップ数を書く
+            \param os 書き出すストリーム
+            \param frame フレーム
+        */
+        void put_xyz_frame(std::ostream & os, TrajectoryFrame const & frame)
+        {
+            std::string properties("species:S:1:pos:R:3");
+            if (!frame.velocity.empty()) {
+                properties += ":vel:R:3";
+            }
+            if (!frame.force.empty()) {
+                properties += ":forces:R:3";
+            }
+
+            char line[256];
+            std::snprintf(line, sizeof(line), "%d\n", frame.NumAtom);
+            os << line;
+            std::snprintf(
+                line,
+                sizeof(line),
+                "Lattice=\"%.6f 0 0 0 %.6f 0 0 0 %.6f\" Properties=%s Time=%.6f Step=%d pbc=\"T T T\"\n",
+                frame.box, frame.box, frame.box, properties.c_str(), frame.time, frame.MD_iter);
+            os << line;
+
+            // 1行ずつストリームに渡すと遅いので、ある程度溜めてから書き出す
+            std::string buf;
+            buf.reserve(1 << 16);
+            for (auto n = 0; n < frame.NumAtom; n++) {
+                auto const m = 3 * static_cast<std::size_t>(n);
+                auto len = std::snprintf(line, sizeof(line), "Ar %.6f %.6f %.6f", frame.position[m], frame.position[m + 1], frame.position[m + 2]);
+                buf.append(line, len);
+
+                if (!frame.velocity.empty()) {
+                    len = std::snprintf(line, sizeof(line), " %.6f %.6f %.6f", frame.velocity[m], frame.velocity[m + 1], frame.velocity[m + 2]);
+                    buf.append(line, len);
+                }
+
+                if (!frame.force.empty()) {
+                    len = std::snprintf(line, sizeof(line), " %.8e %.8e %.8e", frame.force[m], frame.force[m + 1], frame.force[m + 2]);
+                    buf.append(line, len);
+                }
+
+                buf += '\n';
+                if (buf.size() > (1 << 16) - 256) {
+                    os.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+                    buf.clear();
+                }
+            }
+
+            os.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        }
+    }
+
+    // #region コンストラクタ・デストラクタ
+
+    TrajectoryWriter::TrajectoryWriter(std::string const & filename, TrajectoryFormat format, std::int32_t interval, bool velocity, bool force, std::int32_t capacity, std::int32_t bits)
+        :
+        encoder_(format == TrajectoryFormat::COMPRESSED ? new CompressedTrajectoryEncoder(bits) : nullptr),
+        force_(force),
+        format_(format),
+        interval_(interval),
+        ofs_(filename, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary),
+        velocity_(velocity)
+    {
+        BOOST_ASSERT(interval > 0);
+        BOOST_ASSERT(capacity > 0);
+        BOOST_ASSERT(format == TrajectoryFormat::XYZ || format == TrajectoryFormat::RAW || (!velocity && !force));
+
+        if (!ofs_) {
+            good_ = false;
+            return;
+        }
+
+        frames_.resize(capacity);
+        for (auto i = 0; i < capacity; i++) {
+            free_.push_back(i);
+        }
+
+        thread_ = std::thread([this] { run(); });
+    }
+
+    TrajectoryWriter::~TrajectoryWriter()
+    {
+        close();
+    }
+
+    // #endregion コンストラクタ・デストラクタ
+
+    // #region publicメンバ関数
+
+    void TrajectoryWriter::close()
+    {
+        if (!thread_.joinable()) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closing_ = true;
+        }
+        cvready_.notify_one();
+        thread_.join();
+
+        // DCDのヘッダのフレームの数を書き直す（"CORD"の直後）
+        if (format_ == TrajectoryFormat::DCD && nframe_ > 0) {
+            ofs_.seekp(8);
+            put_le<std::int32_t>(ofs_, nframe_);
+        }
+
+        ofs_.close();
+        if (!ofs_) {
+            good_ = false;
+        }
+    }
+
+    std::int32_t TrajectoryWriter::getFrames() const
+    {
+        return nframe_;
+    }
+
+    std::int32_t TrajectoryWriter::getStalls() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stalls_;
+    }
+
+    double TrajectoryWriter::getStallTime() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stalltime_;
+    }
+
+    bool TrajectoryWriter::good() const
+    {
+        return good_;
+    }
+
+    void TrajectoryWriter::write(Ar_moleculardynamics const & armd)
+    {
+        if (!thread_.joinable()) {
+            return;
+        }
+
+        std::int32_t index;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (free_.empty()) {
+                auto const begin = std::chrono::steady_clock::now();
+                cvfree_.wait(lock, [this] { return !free_.empty(); });
+                stalls_++;
+                stalltime_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            }
+
+            index = free_.front();
+            free_.pop_front();
+        }
+
+        // バッファは書き込みのスレッドから返されたものなので、ロックせずに書き込んでよい
+        armd.exportTrajectoryFrame(frames_[index], velocity_, force_);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_.push_back(index);
+        }
+        cvready_.notify_one();
+    }
+
+    // #endregion publicメンバ関数
+
+    // #region privateメンバ関数
+
+    void TrajectoryWriter::put(TrajectoryFrame const & frame)
+    {
+        // XYZ以外は全てのフレームの原子数が同じでなければならない
+        if (numatom_ == 0) {
+            numatom_ = frame.NumAtom;
+
+            switch (format_) {
+            case TrajectoryFormat::DCD:
+                put_dcd_header(ofs_, frame, interval_);
+                break;
+
+            case TrajectoryFormat::RAW:
+                put_raw_header(ofs_, frame);
+                break;
+
+            default:
+                break;
+            }
+        }
+        else if (frame.NumAtom != numatom_ && format_ != TrajectoryFormat::XYZ) {
+            good_ = false;
+            return;
+        }
+
+        switch (format_) {
+        case TrajectoryFormat::XYZ:
+            put_xyz_frame(ofs_, frame);
+            break;
+
+        case TrajectoryFormat::DCD:
+            put_dcd_frame(ofs_, frame);
+            break;
+
+        case TrajectoryFormat::RAW:
+            put_raw_frame(ofs_, frame);
+            break;
+
+        case TrajectoryFormat::COMPRESSED:
+            encoder_->put(ofs_, frame);
+            break;
+
+        default:
+            BOOST_ASSERT(!"何かがおかしい！");
+            break;
+        }
+
+        if (!ofs_) {
+            good_ = false;
+            return;
+        }
+
+        nframe_++;
+    }
+
+    void TrajectoryWriter::run()
+    {
+        while (true) {
+            std::int32_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cvready_.wait(lock, [this] { return closing_ || !ready_.empty(); });
+
+                // 止めるときも、積まれたフレームは全て書き出してから抜ける
+                if (ready_.empty()) {
+                    return;
+                }
+
+                index = ready_.front();
+                ready_.pop_front();
+            }
+
+            // 書き込みに失敗した後もバッファは返し続けるので、write()が待ち続けることはない
+            if (good_) {
+                put(frames_[index]);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                free_.push_back(index);
+            }
+            cvfree_.notify_one();
+        }
+    }
+
+    // #endregion privateメンバ関数
+}
@@ -0,0 +1,342 @@
+﻿/*! \file trajectory.h
+    \brief トラジェクトリ（原子の座標などの時系列）をバックグラウンドのスレッドでファイルに書き出すクラスの宣言
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _TRAJECTORY_H_
+#define _TRAJECTORY_H_
+
+#pragma once
+
+#include "Ar_moleculardynamics.h"
+#include <atomic>               // for std::atomic
+#include <condition_variable>   // for std::condition_variable
+#include <cstdint>              // for std::int32_t
+#include <deque>                // for std::deque
+#include <fstream>              // for std::ofstream
+#include <memory>               // for std::unique_ptr
+#include <mutex>                // for std::mutex
+#include <string>               // for std::string
+#include <thread>               // for std::thread
+#include <vector>               // for std::vector
+
+namespace moleculardynamics {
+    class CompressedTrajectoryEncoder;
+
+    //! A enumerated type
+    /*!
+        トラジェクトリファイルの形式
+    */
+    enum class TrajectoryFormat : std::int32_t {
+        // XYZ形式のテキスト（コメント行はextended XYZ）
+        XYZ = 0,
+        // CHARMM/NAMD互換のDCD形式（VMDで読める、座標のみ）
+        DCD = 1,
+        // リトルエンディアンの倍精度の生のバイナリ
+        RAW = 2,
+        // XTCと同様に座標を固定精度に量子化して圧縮した形式（座標のみ、CompressedTrajectoryReaderで読める）
+        COMPRESSED = 3
+    };
+
+    //! A struct.
+    /*!
+        トラジェクトリの1フレーム
+        原子は通し番号（Ar_moleculardynamics::getAtomId()）の順に並べ、成分は原子ごとにx, y, zの順に並べる
+        長さはÅ、時間はps、力はHartree/Å
+    */
+    struct TrajectoryFrame {
+        //! A public member variable.
+        /*!
+            箱の一辺の長さ
+        */
+        double box = 0.0;
+
+        //! A public member variable.
+        /*!
+            原子に働く力（書き出さないときは空）
+        */
+        std::vector<double> force;
+
+        //! A public member variable.
+        /*!
+            MDのステップ数
+        */
+        std::int32_t MD_iter = 0;
+
+        //! A public member variable.
+        /*!
+            原子数
+        */
+        std::int32_t NumAtom = 0;
+
+        //! A public member variable.
+        /*!
+            原子の座標
+        */
+        std::vector<double> position;
+
+        //! A public member variable.
+        /*!
+            シミュレーションを開始してからの経過時間
+        */
+        double time = 0.0;
+
+        //! A public member variable.
+        /*!
+            1ステップの時間刻み
+        */
+        double timestep = 0.0;
+
+        //! A public member variable.
+        /*!
+            原子の速度（書き出さないときは空）
+        */
+        std::vector<double> velocity;
+    };
+
+    //! A class.
+    /*!
+        トラジェクトリをファイルに書き出すクラス
+        write()はフレームを上限のあるキューに積むだけで、ファイルへの書き込みはバックグラウンドのスレッドで行う
+        フレームのバッファは使い回すので、キューが満ちていなければMDのステップはディスクを待たない
+        キューが満ちたときはwrite()が空くまで待ち、待った回数と時間を記録する
+    */
+    class TrajectoryWriter final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            ファイルを開き、書き込みのスレッドを開始する
+            開けなかったときはgood()がfalseになり、write()は何もしない
+            \param filename ファイルの名前
+            \param format ファイルの形式
+            \param interval フレームの間隔（ステップ数、DCDのヘッダに書く）
+            \param velocity 速度も書き出すならtrue（XYZとRAWのみ）
+            \param force 力も書き出すならtrue（XYZとRAWのみ）
+            \param capacity キューに積めるフレームの数
+            \param bits 量子化のビット数（COMPRESSEDのみ）
+        */
+        TrajectoryWriter(std::string const & filename, TrajectoryFormat format, std::int32_t interval, bool velocity, bool force, std::int32_t capacity, std::int32_t bits);
+
+        //! A destructor.
+        /*!
+            キューに残ったフレームを書き出してからファイルを閉じる
+        */
+        ~TrajectoryWriter();
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region メンバ関数
+
+        //! A public member function.
+        /*!
+            キューに残ったフレームを全て書き出し、スレッドを止めてファイルを閉じる
+        */
+        void close();
+
+        //! A public member function (constant).
+        /*!
+            これまでに書き出したフレームの数を求める
+        */
+        std::int32_t getFrames() const;
+
+        //! A public member function (constant).
+        /*!
+            キューが満ちていてwrite()が待たされた回数を求める
+        */
+        std::int32_t getStalls() const;
+
+        //! A public member function (constant).
+        /*!
+            キューが満ちていてwrite()が待たされた時間の合計を求める（秒）
+        */
+        double getStallTime() const;
+
+        //! A public member function (constant).
+        /*!
+            ファイルを開けて、これまでの書き込みが全て成功したかどうか
+            \return 成功していればtrue
+        */
+        bool good() const;
+
+        //! A public member function.
+        /*!
+            現在の状態をフレームとしてキューに積む
+            空いているバッファが無いときは、書き込みのスレッドがバッファを返すまで待つ
+            \param armd シミュレーションのオブジェクト
+        */
+        void write(Ar_moleculardynamics const & armd);
+
+    private:
+        //! A private member function.
+        /*!
+            フレームを一つファイルに書き出す
+            最初のフレームの前にはヘッダを書き出す
+            \param frame フレーム
+        */
+        void put(TrajectoryFrame const & frame);
+
+        //! A private member function.
+        /*!
+            書き込みのスレッドの本体
+        */
+        void run();
+
+        // #endregion メンバ関数
+
+        // #region メンバ変数
+
+    public:
+        //! A public member variable (constant).
+        /*!
+            キューに積めるフレームの数の既定値
+        */
+        static std::int32_t const FIRSTCAPACITY = 4;
+
+    private:
+        //! A private member variable.
+        /*!
+            書き込むフレームが積まれたことを知らせる条件変数
+        */
+        std::condition_variable cvready_;
+
+        //! A private member variable.
+        /*!
+            バッファが空いたことを知らせる条件変数
+        */
+        std::condition_variable cvfree_;
+
+        //! A private member variable.
+        /*!
+            書き込みのスレッドを止めるならtrue
+        */
+        bool closing_ = false;
+
+        //! A private member variable.
+        /*!
+            圧縮した形式のエンコーダ（COMPRESSEDでなければnullptr）
+        */
+        std::unique_ptr<CompressedTrajectoryEncoder> encoder_;
+
+        //! A private member variable (constant).
+        /*!
+            力も書き出すならtrue
+        */
+        bool const force_;
+
+        //! A private member variable (constant).
+        /*!
+            ファイルの形式
+        */
+        TrajectoryFormat const format_;
+
+        //! A private member variable.
+        /*!
+            フレームのバッファ
+        */
+        std::vector<TrajectoryFrame> frames_;
+
+        //! A private member variable.
+        /*!
+            空いているバッファの番号
+        */
+        std::deque<std::int32_t> free_;
+
+        //! A private member variable.
+        /*!
+            これまでの書き込みが全て成功していればtrue
+        */
+        std::atomic<bool> good_ { true };
+
+        //! A private member variable (constant).
+        /*!
+            フレームの間隔（ステップ数）
+        */
+        std::int32_t const interval_;
+
+        //! A private member variable.
+        /*!
+            キューとバッファを守るミューテックス
+        */
+        mutable std::mutex mutex_;
+
+        //! A private member variable.
+        /*!
+            これまでに書き出したフレームの数
+        */
+        std::atomic<std::int32_t> nframe_ { 0 };
+
+        //! A private member variable.
+        /*!
+            ヘッダに書いた原子数（ヘッダを書く前は0）
+        */
+        std::int32_t numatom_ = 0;
+
+        //! A private member variable.
+        /*!
+            ファイルのストリーム（書き込みのスレッドだけが触る）
+        */
+        std::ofstream ofs_;
+
+        //! A private member variable.
+        /*!
+            書き込むフレームのバッファの番号（積まれた順）
+        */
+        std::deque<std::int32_t> ready_;
+
+        //! A private member variable.
+        /*!
+            write()が待たされた回数
+        */
+        std::int32_t stalls_ = 0;
+
+        //! A private member variable.
+        /*!
+            write()が待たされた時間の合計（秒）
+        */
+        double stalltime_ = 0.0;
+
+        //! A private member variable.
+        /*!
+            書き込みのスレッド
+        */
+        std::thread thread_;
+
+        //! A private member variable (constant).
+        /*!
+            速度も書き出すならtrue
+        */
+        bool const velocity_;
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private constructor (deleted).
+        /*!
+            デフォルトコンストラクタ（禁止）
+        */
+        TrajectoryWriter() = delete;
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        TrajectoryWriter(TrajectoryWriter const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        TrajectoryWriter & operator=(TrajectoryWriter const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif      // _TRAJECTORY_H_
@@ -5,7 +5,6 @@
     This software is released under the BSD 2-Clause License.
 */
 
-#include "DXUT.h"
 #include "myrand.h"
 #include <boost/range/algorithm.hpp>    // for boost::generate
 
@@ -0,0 +1,49 @@
+﻿/*! \file instance.h
+    \brief インスタンシングで原子を描画するときの、インスタンスのデータの宣言
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _INSTANCE_H_
+#define _INSTANCE_H_
+
+#pragma once
+
+namespace render {
+    //! A struct.
+    /*!
+        一つの原子（球）のインスタンスのデータ
+        頂点バッファのスロット1に、INSTANCEPOS（float3）とINSTANCECOLOR（float）として渡す
+        Ar_moleculardynamics::exportRenderFrame()が書き出すレコードと同じ並び
+    */
+    struct Instance {
+        //! A public member variable.
+        /*!
+            球の中心のx座標（箱の中心が原点）
+        */
+        float x;
+
+        //! A public member variable.
+        /*!
+            球の中心のy座標（箱の中心が原点）
+        */
+        float y;
+
+        //! A public member variable.
+        /*!
+            球の中心のz座標（箱の中心が原点）
+        */
+        float z;
+
+        //! A public member variable.
+        /*!
+            球の色の赤の成分（働いている力の大きさに比例し、1で飽和する）
+        */
+        float color;
+    };
+
+    static_assert(sizeof(Instance) == 16, "Instance must match the records written by exportRenderFrame");
+}
+
+#endif      // _INSTANCE_H_
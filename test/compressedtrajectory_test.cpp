@@ -0,0 +1,225 @@
+﻿/*! \file compressedtrajectory_test.cpp
+    \brief 圧縮したトラジェクトリを読み戻し、同時に書き出した倍精度のトラジェクトリ（RAW形式）と比べるテスト
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "../moleculardynamics/Ar_moleculardynamics.h"
+#include "../moleculardynamics/compressedtrajectory.h"
+#include "../moleculardynamics/trajectory.h"
+#include "../utility/binaryio.h"
+#include <algorithm>            // for std::max
+#include <cmath>                // for std::fabs, std::round
+#include <cstddef>              // for std::size_t
+#include <cstdint>              // for std::int32_t, std::uint32_t
+#include <cstdio>               // for std::remove
+#include <cstdlib>              // for EXIT_SUCCESS, EXIT_FAILURE
+#include <fstream>              // for std::ifstream, std::ofstream
+#include <iostream>             // for std::cerr
+#include <iterator>             // for std::istreambuf_iterator
+#include <memory>               // for std::unique_ptr
+#include <string>               // for std::string
+#include <vector>               // for std::vector
+#include <boost/format.hpp>     // for boost::format
+
+namespace {
+    //! A global variable (constant).
+    /*!
+        書き出すフレームの数（キーフレームを3回含むようにする）
+    */
+    std::int32_t const NUMFRAME = 250;
+
+    //! A global variable (constant).
+    /*!
+        フレームの間隔（ステップ数）
+    */
+    std::int32_t const INTERVAL = 2;
+
+    //! A function.
+    /*!
+        同じ系を同時にRAW形式と圧縮した形式で書き出し、圧縮した方の座標の誤差が
+        箱の一辺の長さ / 2^(bits + 1)以下であることを確かめる
+        \param ensemble アンサンブル（NPTでは箱の一辺の長さがフレームごとに変わる）
+        \param bits 量子化のビット数
+        \return 成功したらtrue
+    */
+    bool test_round_trip(moleculardynamics::EnsembleType ensemble, std::int32_t bits);
+
+    //! A function.
+    /*!
+        途中で切れたファイルを読んだとき、切れたフレームを返さずにgood()がfalseになることを確かめる
+        \return 成功したらtrue
+    */
+    bool test_truncated();
+
+    //! A function.
+    /*!
+        系を動かしながら、圧縮したトラジェクトリと、必要ならRAW形式のトラジェクトリに同じフレームを書き出す
+        \param compressedname 圧縮した形式のファイルの名前
+        \param rawname RAW形式のファイルの名前（空ならRAW形式は書き出さない）
+        \param ensemble アンサンブル
+        \param bits 量子化のビット数
+        \return 書き出せたらtrue
+    */
+    bool write_trajectory(std::string const & compressedname, std::string const & rawname, moleculardynamics::EnsembleType ensemble, std::int32_t bits);
+}
+
+//! A function.
+/*!
+    メイン関数
+    \return 終了コード
+*/
+int main()
+{
+    auto ok = true;
+    for (auto const bits : { moleculardynamics::CompressedTrajectoryEncoder::MINBITS, 16, 24, moleculardynamics::CompressedTrajectoryEncoder::MAXBITS }) {
+        ok = test_round_trip(moleculardynamics::EnsembleType::NVT, bits) && ok;
+    }
+    ok = test_round_trip(moleculardynamics::EnsembleType::NPT, moleculardynamics::CompressedTrajectoryEncoder::FIRSTBITS) && ok;
+    ok = test_truncated() && ok;
+
+    std::cerr << (ok ? "all tests passed\n" : "some tests failed\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+    bool test_round_trip(moleculardynamics::EnsembleType ensemble, std::int32_t bits)
+    {
+        auto const name = (boost::format("%s, %d bits") % (ensemble == moleculardynamics::EnsembleType::NPT ? "NPT" : "NVT") % bits).str();
+        auto const rawname = (boost::format("compressedtrajectory_test_%d.raw") % bits).str();
+        auto const compressedname = (boost::format("compressedtrajectory_test_%d.ctrj") % bits).str();
+
+        // 初期速度は乱数なので、両方の形式を同じ系から一度に書き出す
+        if (!write_trajectory(compressedname, rawname, ensemble, bits)) {
+            std::cerr << boost::format("round trip (%s): cannot write the trajectories\n") % name;
+            return false;
+        }
+
+        std::ifstream raw(rawname, std::ios::binary);
+        moleculardynamics::CompressedTrajectoryReader reader(compressedname);
+
+        // RAW形式のヘッダ：マジックナンバー、版、フラグ、原子数、0
+        char magic[8];
+        std::uint32_t version, flags;
+        std::int32_t numatom, reserved;
+        auto ok = raw.read(magic, sizeof(magic)) &&
+            utility::get_le(raw, version) && utility::get_le(raw, flags) && utility::get_le(raw, numatom) && utility::get_le(raw, reserved) &&
+            flags == 0 && reader.good() && reader.getBits() == bits && reader.getNumAtom() == numatom;
+
+        auto nframe = 0;
+        auto maxerror = 0.0;
+        moleculardynamics::TrajectoryFrame expected, frame;
+        expected.position.resize(3 * static_cast<std::size_t>(numatom));
+        while (ok) {
+            std::int32_t zero;
+            if (!utility::get_le(raw, expected.MD_iter)) {
+                // RAW形式が終わったときは、圧縮した方も同じフレーム数で終わるはず
+                ok = !reader.next(frame) && reader.good();
+                break;
+            }
+
+            ok = utility::get_le(raw, zero) && utility::get_le(raw, expected.time) && utility::get_le(raw, expected.box) &&
+                utility::get_le(raw, expected.position.data(), expected.position.size()) &&
+                reader.next(frame) &&
+                frame.MD_iter == expected.MD_iter && frame.time == expected.time && frame.box == expected.box &&
+                frame.velocity.empty() && frame.force.empty();
+            if (!ok) {
+                std::cerr << boost::format("round trip (%s): frame %d does not match\n") % name % nframe;
+                break;
+            }
+
+            // 読み戻した座標は箱の中に戻してあるので、周期境界条件の下での差を測る
+            auto const unit = expected.box / static_cast<double>(1U << bits);
+            for (auto i = std::size_t(0); i < expected.position.size(); i++) {
+                auto d = frame.position[i] - expected.position[i];
+                d -= expected.box * std::round(d / expected.box);
+                maxerror = std::max(maxerror, std::fabs(d) / unit);
+            }
+
+            nframe++;
+        }
+
+        // 量子化の誤差は半目盛り以下（丸めの誤差の分だけ余裕を見る）
+        ok = ok && nframe == NUMFRAME && maxerror <= 0.5 + 1.0E-6;
+
+        std::cerr << boost::format("round trip (%s): %d frames, max error %.6f of box / 2^%d, %s\n")
+            % name % nframe % maxerror % bits % (ok ? "ok" : "FAILED");
+
+        raw.close();
+        std::remove(rawname.c_str());
+        std::remove(compressedname.c_str());
+        return ok;
+    }
+
+    bool test_truncated()
+    {
+        auto const filename = std::string("compressedtrajectory_test_full.ctrj");
+        auto const truncatedname = std::string("compressedtrajectory_test_truncated.ctrj");
+        if (!write_trajectory(filename, std::string(), moleculardynamics::EnsembleType::NVT, moleculardynamics::CompressedTrajectoryEncoder::FIRSTBITS)) {
+            std::cerr << "truncated file: cannot write the trajectory\n";
+            return false;
+        }
+
+        std::string bytes;
+        {
+            std::ifstream ifs(filename, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        }
+
+        // 最後のフレームの途中で切る
+        {
+            std::ofstream ofs(truncatedname, std::ios::binary);
+            ofs.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 5));
+        }
+
+        moleculardynamics::CompressedTrajectoryReader reader(truncatedname);
+        moleculardynamics::TrajectoryFrame frame;
+        auto nframe = 0;
+        while (reader.next(frame)) {
+            nframe++;
+        }
+
+        auto const ok = nframe == NUMFRAME - 1 && !reader.good();
+        std::cerr << boost::format("truncated file: %d of %d frames read, good() = %s, %s\n")
+            % nframe % NUMFRAME % (reader.good() ? "true" : "false") % (ok ? "ok" : "FAILED");
+
+        std::remove(filename.c_str());
+        std::remove(truncatedname.c_str());
+        return ok;
+    }
+
+    bool write_trajectory(std::string const & compressedname, std::string const & rawname, moleculardynamics::EnsembleType ensemble, std::int32_t bits)
+    {
+        moleculardynamics::Ar_moleculardynamics armd;
+        armd.setEnsemble(ensemble);
+        armd.setNc(3);
+
+        std::vector<std::unique_ptr<moleculardynamics::TrajectoryWriter> > writers;
+        writers.emplace_back(new moleculardynamics::TrajectoryWriter(
+            compressedname, moleculardynamics::TrajectoryFormat::COMPRESSED, INTERVAL, false, false,
+            moleculardynamics::TrajectoryWriter::FIRSTCAPACITY, bits));
+        if (!rawname.empty()) {
+            writers.emplace_back(new moleculardynamics::TrajectoryWriter(
+                rawname, moleculardynamics::TrajectoryFormat::RAW, INTERVAL, false, false,
+                moleculardynamics::TrajectoryWriter::FIRSTCAPACITY, bits));
+        }
+
+        for (auto i = 1; i <= NUMFRAME * INTERVAL; i++) {
+            armd.calculate();
+            if (i % INTERVAL == 0) {
+                for (auto const & writer : writers) {
+                    writer->write(armd);
+                }
+            }
+        }
+
+        auto ok = true;
+        for (auto const & writer : writers) {
+            writer->close();
+            ok = ok && writer->good() && writer->getFrames() == NUMFRAME;
+        }
+
+        return ok;
+    }
+}
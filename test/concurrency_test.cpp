@@ -0,0 +1,290 @@
+﻿/*! \file concurrency_test.cpp
+    \brief TripleBufferとSimulationThreadのスレッド間の受け渡しを確かめるテスト
+    LJMD_ENABLE_TSANを有効にしてビルドすれば、ThreadSanitizerの下で実行される
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "../moleculardynamics/simulationthread.h"
+#include "../utility/triplebuffer.h"
+#include <algorithm>            // for std::sort
+#include <array>                // for std::array
+#include <atomic>               // for std::atomic
+#include <chrono>               // for std::chrono
+#include <cstddef>              // for std::size_t
+#include <cstdint>              // for std::int32_t, std::int64_t
+#include <cstdlib>              // for EXIT_SUCCESS, EXIT_FAILURE
+#include <iostream>             // for std::cerr
+#include <thread>               // for std::thread, std::this_thread
+#include <utility>              // for std::make_pair
+#include <vector>               // for std::vector
+#include <boost/format.hpp>     // for boost::format
+
+namespace {
+    //! A struct.
+    /*!
+        トリプルバッファで受け渡すテスト用のフレーム
+        書き込み側は全ての要素に同じ通し番号を書くので、書きかけのフレームを読めば要素が揃わない
+    */
+    struct Frame {
+        //! A public member variable.
+        /*!
+            フレームの中身（全て通し番号）
+        */
+        std::array<std::int64_t, 256> payload = {};
+
+        //! A public member variable.
+        /*!
+            フレームの通し番号
+        */
+        std::int64_t seq = -1;
+    };
+
+    //! A global variable (constant).
+    /*!
+        トリプルバッファのテストで書き込むフレームの数
+    */
+    std::int64_t const NUMFRAME = 200000;
+
+    //! A function.
+    /*!
+        フレームが書きかけでないかどうか調べる
+        \param frame フレーム
+        \return 全ての要素が通し番号と等しければtrue
+    */
+    bool consistent(Frame const & frame);
+
+    //! A function.
+    /*!
+        描画スレッドがゆっくりスナップショットを受け取るとき、受け取ったスナップショットが
+        描画の間隔よりずっと新しい（高々SimulationThread::CAPTUREINTERVALミリ秒程度古い）ことを確かめる
+        \return 成功したらtrue
+    */
+    bool test_snapshot_latency();
+
+    //! A function.
+    /*!
+        SimulationThreadを動かしながらスナップショットを読み出し、途中でpost()した操作が反映されることを確かめる
+        \return 成功したらtrue
+    */
+    bool test_simulation_thread();
+
+    //! A function.
+    /*!
+        書き込み側と読み出し側を別のスレッドで動かし、フレームが書きかけでなく、順番も逆転しないことを確かめる
+        \param skip pending()がtrueの間は書き込まないならtrue（このときは全てのフレームを順番に受け取るはず）
+        \return 成功したらtrue
+    */
+    bool test_triple_buffer(bool skip);
+}
+
+//! A function.
+/*!
+    メイン関数
+    \return 終了コード
+*/
+int main()
+{
+    auto ok = true;
+    ok = test_triple_buffer(false) && ok;
+    ok = test_triple_buffer(true) && ok;
+    ok = test_simulation_thread() && ok;
+    ok = test_snapshot_latency() && ok;
+
+    std::cerr << (ok ? "all tests passed\n" : "some tests failed\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+    bool consistent(Frame const & frame)
+    {
+        for (auto const v : frame.payload) {
+            if (v != frame.seq) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool test_simulation_thread()
+    {
+        moleculardynamics::Ar_moleculardynamics armd;
+        armd.setNc(3);
+
+        moleculardynamics::SimulationThread simthread(armd, 0.025f);
+        simthread.start();
+
+        auto ok = true;
+        auto received = 0;
+        auto resized = false;
+        auto lastiter = 0;
+        auto const begin = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - begin < std::chrono::seconds(10)) {
+            // 描画スレッドの代わりに、ときどきスナップショットを受け取る
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            if (!simthread.update()) {
+                continue;
+            }
+
+            received++;
+            auto const & snapshot = simthread.snapshot();
+            if (snapshot.NumAtom != 4 * snapshot.Nc * snapshot.Nc * snapshot.Nc ||
+                snapshot.frame.size() != 4 * static_cast<std::size_t>(snapshot.NumAtom)) {
+                std::cerr << boost::format("simulation thread: inconsistent snapshot (Nc = %d, NumAtom = %d, frame = %d)\n")
+                    % snapshot.Nc % snapshot.NumAtom % snapshot.frame.size();
+                ok = false;
+                break;
+            }
+
+            if (snapshot.Nc == 4) {
+                resized = true;
+                break;
+            }
+
+            if (snapshot.MD_iter < lastiter) {
+                std::cerr << boost::format("simulation thread: step went back from %d to %d\n") % lastiter % snapshot.MD_iter;
+                ok = false;
+                break;
+            }
+            lastiter = snapshot.MD_iter;
+
+            if (received == 20) {
+                simthread.post([](moleculardynamics::Ar_moleculardynamics & md) { md.setNc(4); });
+            }
+        }
+
+        simthread.stop();
+
+        if (ok && !resized) {
+            std::cerr << "simulation thread: the posted setNc() never reached a snapshot\n";
+            ok = false;
+        }
+
+        // スレッドを止めた後はarmdに直接触ってよい
+        if (ok && armd.Nc() != 4) {
+            std::cerr << boost::format("simulation thread: Nc = %d after stop()\n") % armd.Nc();
+            ok = false;
+        }
+
+        std::cerr << boost::format("simulation thread: %d snapshots, %s\n") % received % (ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    bool test_snapshot_latency()
+    {
+        // 描画の間隔（ミリ秒）
+        auto const interval = 30;
+
+        moleculardynamics::Ar_moleculardynamics armd;
+        armd.setNc(3);
+
+        moleculardynamics::SimulationThread simthread(armd, 0.025f);
+        simthread.start();
+
+        // 計算スレッドの現在のステップ数を、次のステップの前にpost()した操作で読み出す
+        auto const current = [&simthread] {
+            std::atomic<std::int32_t> iter { -1 };
+            simthread.post([&iter](moleculardynamics::Ar_moleculardynamics & md) { iter = md.MD_iter(); });
+            while (iter < 0) {
+                std::this_thread::yield();
+            }
+
+            return std::make_pair(static_cast<std::int32_t>(iter), std::chrono::steady_clock::now());
+        };
+
+        std::vector<double> latencies;
+        auto last = current();
+        while (latencies.size() < 20) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+            if (!simthread.update()) {
+                continue;
+            }
+
+            auto const snapshotiter = simthread.snapshot().MD_iter;
+            auto const now = current();
+
+            // 直前の間隔の進み方から、スナップショットが何ミリ秒古いかを見積もる
+            auto const elapsed = std::chrono::duration<double, std::milli>(now.second - last.second).count();
+            auto const steps = static_cast<double>(now.first - last.first);
+            if (steps > 0.0) {
+                latencies.push_back(static_cast<double>(now.first - snapshotiter) * elapsed / steps);
+            }
+
+            last = now;
+        }
+
+        simthread.stop();
+
+        // 前のスナップショットを受け取った直後のものを渡していれば、描画の間隔と同じくらい古くなる
+        std::sort(latencies.begin(), latencies.end());
+        auto const median = latencies[latencies.size() / 2];
+        auto const ok = median < 0.5 * interval;
+
+        std::cerr << boost::format("snapshot latency: median %.2f ms with a %d ms render interval (limit %d ms + 1 step), %s\n")
+            % median % interval % static_cast<std::int32_t>(moleculardynamics::SimulationThread::CAPTUREINTERVAL) % (ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    bool test_triple_buffer(bool skip)
+    {
+        utility::TripleBuffer<Frame> buffer;
+
+        std::atomic<bool> done { false };
+        std::thread writer([&buffer, &done, skip] {
+            for (std::int64_t seq = 0; seq < NUMFRAME; seq++) {
+                if (skip) {
+                    while (buffer.pending()) {
+                        std::this_thread::yield();
+                    }
+                }
+
+                auto & frame = buffer.back();
+                frame.payload.fill(seq);
+                frame.seq = seq;
+                buffer.publish();
+            }
+
+            done = true;
+        });
+
+        auto ok = true;
+        std::int64_t last = -1;
+        std::int64_t received = 0;
+        while (last != NUMFRAME - 1) {
+            if (!buffer.update()) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            auto const & frame = buffer.front();
+            received++;
+            if (!consistent(frame)) {
+                std::cerr << boost::format("triple buffer: torn frame %d\n") % frame.seq;
+                ok = false;
+                break;
+            }
+
+            // pending()を待つときは一つも捨てられないので、通し番号は1ずつ増える
+            if (frame.seq <= last || (skip && frame.seq != last + 1)) {
+                std::cerr << boost::format("triple buffer: frame %d after %d\n") % frame.seq % last;
+                ok = false;
+                break;
+            }
+
+            last = frame.seq;
+        }
+
+        // 失敗して途中で抜けたときも、書き込み側がpending()で待ち続けないように、終わるまで受け取り続ける
+        while (!done) {
+            buffer.update();
+        }
+
+        writer.join();
+
+        std::cerr << boost::format("triple buffer (%s): %d of %d frames received, %s\n")
+            % (skip ? "skip while pending" : "overwrite") % received % NUMFRAME % (ok ? "ok" : "FAILED");
+        return ok;
+    }
+}
@@ -0,0 +1,168 @@
+﻿/*! \file forcekernel_test.cpp
+    \brief 原子間力のカーネル（ForceKernelType）の結果を参照実装と比べるテスト
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "../moleculardynamics/Ar_moleculardynamics.h"
+#include "../moleculardynamics/forcekernel.h"
+#include "../moleculardynamics/trajectory.h"
+#include <algorithm>            // for std::max
+#include <cmath>                // for std::fabs, std::sqrt
+#include <cstddef>              // for std::size_t
+#include <cstdint>              // for std::int32_t
+#include <cstdlib>              // for EXIT_SUCCESS, EXIT_FAILURE
+#include <iostream>             // for std::cerr
+#include <boost/format.hpp>     // for boost::format
+#include <tbb/task_arena.h>     // for tbb::task_arena
+
+namespace {
+    //! A struct.
+    /*!
+        1回の原子間力の計算の結果
+    */
+    struct ForceResult {
+        //! A public member variable.
+        /*!
+            原子に働く力（通し番号の順、Hartree/Å）
+        */
+        moleculardynamics::TrajectoryFrame frame;
+
+        //! A public member variable.
+        /*!
+            圧力（運動エネルギーは変えないので、ビリアルの違いがそのまま出る）
+        */
+        double pressure = 0.0;
+
+        //! A public member variable.
+        /*!
+            ポテンシャルエネルギー
+        */
+        double Up = 0.0;
+    };
+
+    //! A global variable (constant).
+    /*!
+        系の大きさ（原子数は4 * NC^3）
+    */
+    std::int32_t const NC = 6;
+
+    //! A global variable (constant).
+    /*!
+        比べる前に系を動かすステップ数（格子からずらしてペアリストを何度か作り直させる）
+    */
+    std::int32_t const WARMUP = 200;
+
+    //! A function.
+    /*!
+        指定したカーネルと精度で原子間力を計算し、力・ポテンシャルエネルギー・圧力を求める
+        \param armd 系（力とポテンシャルエネルギーは上書きされる）
+        \param type カーネルの種類
+        \param precision 精度
+        \return 計算した結果
+    */
+    ForceResult calculate(moleculardynamics::Ar_moleculardynamics & armd, moleculardynamics::ForceKernelType type, moleculardynamics::PrecisionType precision);
+
+    //! A function.
+    /*!
+        同じ配置について、各カーネルの結果が参照実装（ForceKernelType::REFERENCE）と許容誤差の範囲で一致することを確かめる
+        \param threads 使うスレッドの数（1なら逐次版、2以上ならスレッドごとのバッファを使う並列版を通す）
+        \return 成功したらtrue
+    */
+    bool test_kernels(std::int32_t threads);
+}
+
+//! A function.
+/*!
+    メイン関数
+    \return 終了コード
+*/
+int main()
+{
+    auto ok = true;
+    ok = test_kernels(1) && ok;
+    ok = test_kernels(4) && ok;
+
+    std::cerr << (ok ? "all tests passed\n" : "some tests failed\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+    ForceResult calculate(moleculardynamics::Ar_moleculardynamics & armd, moleculardynamics::ForceKernelType type, moleculardynamics::PrecisionType precision)
+    {
+        armd.setForceKernel(type);
+        armd.setPrecision(precision);
+        armd.calculate_force_pair(true);
+
+        ForceResult result;
+        armd.exportTrajectoryFrame(result.frame, false, true);
+        result.pressure = armd.getPressure();
+        result.Up = armd.Up;
+
+        return result;
+    }
+
+    bool test_kernels(std::int32_t threads)
+    {
+        struct Case {
+            char const * name;
+            moleculardynamics::ForceKernelType type;
+            moleculardynamics::PrecisionType precision;
+            double tolerance;
+        };
+
+        // 倍精度のカーネルは足し算の順序の違いだけ、混合精度は単精度の相対座標の丸めの分だけずれる
+        Case const cases[] = {
+            { "scalar", moleculardynamics::ForceKernelType::SCALAR, moleculardynamics::PrecisionType::DOUBLE, 1.0E-10 },
+            { "avx2", moleculardynamics::ForceKernelType::AVX2, moleculardynamics::PrecisionType::DOUBLE, 1.0E-10 },
+            { "avx512", moleculardynamics::ForceKernelType::AVX512, moleculardynamics::PrecisionType::DOUBLE, 1.0E-10 },
+            { "avx2 mixed", moleculardynamics::ForceKernelType::AVX2, moleculardynamics::PrecisionType::MIXED, 1.0E-5 },
+            { "avx512 mixed", moleculardynamics::ForceKernelType::AVX512, moleculardynamics::PrecisionType::MIXED, 1.0E-5 }
+        };
+
+        auto ok = true;
+        tbb::task_arena arena(threads);
+        arena.execute([&ok, threads, &cases] {
+            moleculardynamics::Ar_moleculardynamics armd;
+            armd.setNc(NC);
+            for (auto i = 0; i < WARMUP; i++) {
+                armd.calculate();
+            }
+
+            auto const reference = calculate(armd, moleculardynamics::ForceKernelType::REFERENCE, moleculardynamics::PrecisionType::DOUBLE);
+
+            // 力の誤差は、一番大きな力に対する比で測る
+            auto fmax = 0.0;
+            auto const & fref = reference.frame.force;
+            for (auto i = std::size_t(0); i < fref.size(); i += 3) {
+                fmax = std::max(fmax, std::sqrt(fref[i] * fref[i] + fref[i + 1] * fref[i + 1] + fref[i + 2] * fref[i + 2]));
+            }
+
+            for (auto const & c : cases) {
+                if (!moleculardynamics::isSupported(c.type)) {
+                    std::cerr << boost::format("%d threads, %s: not supported on this CPU, skipped\n") % threads % c.name;
+                    continue;
+                }
+
+                auto const result = calculate(armd, c.type, c.precision);
+
+                auto ferror = 0.0;
+                auto const & f = result.frame.force;
+                for (auto i = std::size_t(0); i < f.size(); i++) {
+                    ferror = std::max(ferror, std::fabs(f[i] - fref[i]) / fmax);
+                }
+
+                auto const Uperror = std::fabs(result.Up - reference.Up) / std::fabs(reference.Up);
+                auto const Perror = std::fabs(result.pressure - reference.pressure) / std::max(std::fabs(reference.pressure), 1.0);
+                auto const passed = f.size() == fref.size() && ferror <= c.tolerance && Uperror <= c.tolerance && Perror <= c.tolerance;
+
+                std::cerr << boost::format("%d threads, %s: force %.3e, Up %.3e, pressure %.3e (tolerance %.0e), %s\n")
+                    % threads % c.name % ferror % Uperror % Perror % c.tolerance % (passed ? "ok" : "FAILED");
+                ok = passed && ok;
+            }
+        });
+
+        return ok;
+    }
+}
@@ -0,0 +1,171 @@
+﻿/*! \file renderframe_test.cpp
+    \brief 描画用のインスタンスのレコード（render::Instance）を書き出す関数を確かめるテスト
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#include "../moleculardynamics/Ar_moleculardynamics.h"
+#include "../moleculardynamics/renderframe.h"
+#include "../render/instance.h"
+#include <algorithm>            // for std::min
+#include <cmath>                // for std::sqrt
+#include <cstddef>              // for std::size_t
+#include <cstdint>              // for std::int32_t
+#include <cstdlib>              // for EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>              // for std::memcmp, std::memcpy
+#include <iostream>             // for std::cerr
+#include <random>               // for std::mt19937, std::uniform_real_distribution
+#include <vector>               // for std::vector
+#include <boost/format.hpp>     // for boost::format
+
+namespace {
+    //! A global variable (constant).
+    /*!
+        力の大きさを色に変換する比率（LJ_Argon_MD.cppと同じ値）
+    */
+    float const COLORRATIO = 0.025f;
+
+    //! A global variable (constant).
+    /*!
+        テストに使う原子数（4の倍数でない数にして、AVX2版の端数の処理も通す）
+    */
+    std::int32_t const NUMATOM = 1003;
+
+    //! A function.
+    /*!
+        乱数で作った原子について、スカラー版が仕様どおりのレコードを書き出し、
+        AVX2版がいろいろな範囲でスカラー版とビット単位で一致することを確かめる
+        \return 成功したらtrue
+    */
+    bool test_export_frame();
+
+    //! A function.
+    /*!
+        Ar_moleculardynamics::exportRenderFrame()の出力が、実際の系の原子についてスカラー版と一致することを確かめる
+        \return 成功したらtrue
+    */
+    bool test_export_render_frame();
+}
+
+//! A function.
+/*!
+    メイン関数
+    \return 終了コード
+*/
+int main()
+{
+    auto ok = true;
+    ok = test_export_frame() && ok;
+    ok = test_export_render_frame() && ok;
+
+    std::cerr << (ok ? "all tests passed\n" : "some tests failed\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+    bool test_export_frame()
+    {
+        auto const box = 10.0;
+        moleculardynamics::Atoms atoms(NUMATOM);
+
+        std::mt19937 mt(12345);
+        std::uniform_real_distribution<double> position(0.0, box);
+        std::uniform_real_distribution<double> force(-100.0, 100.0);
+        for (auto k = 0; k < 3; k++) {
+            auto const r = atoms.data(moleculardynamics::Atoms::R, k);
+            auto const f = atoms.data(moleculardynamics::Atoms::F, k);
+            for (auto i = 0; i < NUMATOM; i++) {
+                r[i] = position(mt);
+
+                // 小さい力（色が飽和しない）と大きい力（飽和する）を混ぜる
+                f[i] = i % 3 == 0 ? force(mt) : 0.1 * force(mt);
+            }
+        }
+
+        auto const size = 4 * static_cast<std::size_t>(NUMATOM);
+        std::vector<float> scalar(size);
+        moleculardynamics::export_frame_scalar(atoms, 0, NUMATOM, 0.5 * box, COLORRATIO, scalar.data());
+
+        auto ok = true;
+        for (auto i = 0; ok && i < NUMATOM; i++) {
+            auto const v = atoms[i];
+            auto const f2 = static_cast<float>(v.f[0] * v.f[0] + v.f[1] * v.f[1] + v.f[2] * v.f[2]);
+            float const expected[4] = {
+                static_cast<float>(v.r[0] - 0.5 * box),
+                static_cast<float>(v.r[1] - 0.5 * box),
+                static_cast<float>(v.r[2] - 0.5 * box),
+                std::min(COLORRATIO * std::sqrt(f2), 1.0f)
+            };
+
+            if (std::memcmp(expected, scalar.data() + 4 * static_cast<std::size_t>(i), sizeof(expected)) != 0) {
+                std::cerr << boost::format("export_frame_scalar: wrong record for atom %d\n") % i;
+                ok = false;
+            }
+        }
+
+        std::cerr << boost::format("export_frame_scalar: %s\n") % (ok ? "ok" : "FAILED");
+
+        if (!moleculardynamics::isSupported(moleculardynamics::ForceKernelType::AVX2)) {
+            std::cerr << "export_frame_avx2: skipped (no AVX2)\n";
+            return ok;
+        }
+
+        // 端数のある範囲や、4原子に満たない範囲も試す
+        std::int32_t const ranges[][2] = { { 0, NUMATOM }, { 1, NUMATOM - 2 }, { 5, 7 }, { 8, 12 }, { 0, 3 } };
+        auto avx2ok = true;
+        for (auto const & range : ranges) {
+            // 範囲の外に書き込まないことも確かめるため、あり得ない値で埋めておく
+            std::vector<float> avx2(size, -12345.0f);
+            moleculardynamics::export_frame_avx2(atoms, range[0], range[1], 0.5 * box, COLORRATIO, avx2.data());
+
+            for (auto i = 0; i < NUMATOM; i++) {
+                auto const p = avx2.data() + 4 * static_cast<std::size_t>(i);
+                auto const inside = i >= range[0] && i < range[1];
+                if (inside ?
+                    std::memcmp(p, scalar.data() + 4 * static_cast<std::size_t>(i), 4 * sizeof(float)) != 0 :
+                    (p[0] != -12345.0f || p[1] != -12345.0f || p[2] != -12345.0f || p[3] != -12345.0f)) {
+                    std::cerr << boost::format("export_frame_avx2: atom %d differs for the range [%d, %d)\n") % i % range[0] % range[1];
+                    avx2ok = false;
+                    break;
+                }
+            }
+        }
+
+        std::cerr << boost::format("export_frame_avx2: %s\n") % (avx2ok ? "ok" : "FAILED");
+        return ok && avx2ok;
+    }
+
+    bool test_export_render_frame()
+    {
+        moleculardynamics::Ar_moleculardynamics armd;
+        armd.setNc(3);
+        for (auto i = 0; i < 10; i++) {
+            armd.calculate();
+        }
+
+        auto const n = armd.NumAtom();
+        std::vector<float> frame(4 * static_cast<std::size_t>(n));
+        std::vector<float> expected(4 * static_cast<std::size_t>(n));
+        armd.exportRenderFrame(frame.data(), COLORRATIO);
+        moleculardynamics::export_frame_scalar(armd.atoms(), 0, n, 0.5 * armd.periodiclen(), COLORRATIO, expected.data());
+
+        // 描画側はレコードをそのままrender::Instanceの配列として頂点バッファに写す
+        std::vector<render::Instance> instances(static_cast<std::size_t>(n));
+        std::memcpy(instances.data(), frame.data(), frame.size() * sizeof(float));
+
+        auto ok = std::memcmp(frame.data(), expected.data(), frame.size() * sizeof(float)) == 0;
+        for (auto i = 0; ok && i < n; i++) {
+            auto const & inst = instances[i];
+            auto const half = static_cast<float>(0.5 * armd.periodiclen());
+            if (!(inst.x >= -half && inst.x <= half && inst.y >= -half && inst.y <= half && inst.z >= -half && inst.z <= half &&
+                  inst.color >= 0.0f && inst.color <= 1.0f)) {
+                std::cerr << boost::format("exportRenderFrame: atom %d is outside the box or has a bad color\n") % i;
+                ok = false;
+            }
+        }
+
+        std::cerr << boost::format("exportRenderFrame: %d atoms, %s\n") % n % (ok ? "ok" : "FAILED");
+        return ok;
+    }
+}
@@ -0,0 +1,122 @@
+﻿/*! \file binaryio.h
+    \brief 値をリトルエンディアンでストリームに読み書きする関数の宣言と実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _BINARYIO_H_
+#define _BINARYIO_H_
+
+#pragma once
+
+#include <algorithm>    // for std::reverse
+#include <cstddef>      // for std::size_t
+#include <cstdint>      // for std::uint16_t
+#include <cstring>      // for std::memcpy
+#include <istream>      // for std::istream
+#include <ostream>      // for std::ostream
+
+namespace utility {
+    //! A function.
+    /*!
+        このマシンのバイトオーダーがリトルエンディアンかどうか
+        \return リトルエンディアンならtrue
+    */
+    inline bool little_endian()
+    {
+        std::uint16_t const one = 1;
+        unsigned char c;
+        std::memcpy(&c, &one, 1);
+        return c == 1;
+    }
+
+    template <typename T>
+    //! A template function.
+    /*!
+        リトルエンディアンで書かれた値を読み込む
+        \param is 読み込むストリーム
+        \param value 読み込んだ値（失敗したときは不定）
+        \return 読み込めたらtrue
+    */
+    bool get_le(std::istream & is, T & value)
+    {
+        char buf[sizeof(T)];
+        if (!is.read(buf, sizeof(T))) {
+            return false;
+        }
+
+        if (!little_endian()) {
+            std::reverse(buf, buf + sizeof(T));
+        }
+
+        std::memcpy(&value, buf, sizeof(T));
+        return true;
+    }
+
+    template <typename T>
+    //! A template function.
+    /*!
+        リトルエンディアンで書かれた配列を読み込む
+        リトルエンディアンのマシンでは一度にまとめて読み込む
+        \param is 読み込むストリーム
+        \param data 配列の先頭
+        \param n 要素の数
+        \return 読み込めたらtrue
+    */
+    bool get_le(std::istream & is, T * data, std::size_t n)
+    {
+        if (little_endian()) {
+            return static_cast<bool>(is.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(n * sizeof(T))));
+        }
+
+        for (auto i = std::size_t(0); i < n; i++) {
+            if (!get_le(is, data[i])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    //! A template function.
+    /*!
+        値をリトルエンディアンで書き出す
+        \param os 書き出すストリーム
+        \param value 値
+    */
+    void put_le(std::ostream & os, T value)
+    {
+        char buf[sizeof(T)];
+        std::memcpy(buf, &value, sizeof(T));
+        if (!little_endian()) {
+            std::reverse(buf, buf + sizeof(T));
+        }
+
+        os.write(buf, sizeof(T));
+    }
+
+    template <typename T>
+    //! A template function.
+    /*!
+        配列をリトルエンディアンで書き出す
+        リトルエンディアンのマシンでは一度にまとめて書き出す
+        \param os 書き出すストリーム
+        \param data 配列の先頭
+        \param n 要素の数
+    */
+    void put_le(std::ostream & os, T const * data, std::size_t n)
+    {
+        if (little_endian()) {
+            os.write(reinterpret_cast<char const *>(data), static_cast<std::streamsize>(n * sizeof(T)));
+            return;
+        }
+
+        for (auto i = std::size_t(0); i < n; i++) {
+            put_le(os, data[i]);
+        }
+    }
+}
+
+#endif      // _BINARYIO_H_
@@ -0,0 +1,176 @@
+﻿/*! \file triplebuffer.h
+    \brief 一つのスレッドが書き込み、別の一つのスレッドが最新の値を読み出すロックフリーなトリプルバッファの宣言と実装
+
+    Copyright ©  2015 @dc1394 All Rights Reserved.
+    This software is released under the BSD 2-Clause License.
+*/
+
+#ifndef _TRIPLEBUFFER_H_
+#define _TRIPLEBUFFER_H_
+
+#pragma once
+
+#include <array>    // for std::array
+#include <atomic>   // for std::atomic
+#include <cstdint>  // for std::uint8_t
+
+namespace utility {
+    template <typename T>
+    //! A template class.
+    /*!
+        書き込み側（一つのスレッド）と読み出し側（別の一つのスレッド）の間で値を受け渡すトリプルバッファ
+        三つのバッファを、書き込み中・受け渡し待ち・読み出し中の三つの役割で持ち回る
+        役割の交換は受け渡し待ちのバッファの番号を一つのatomic変数と交換するだけなので、どちらの側も待たされない
+        DXUTLockFreePipeと違って途中の値は捨てられ、読み出し側は常に最後に書き込まれた値を受け取る
+        \tparam T バッファの型（デフォルトコンストラクタを持つこと）
+    */
+    class TripleBuffer final {
+        // #region コンストラクタ・デストラクタ
+
+    public:
+        //! A constructor.
+        /*!
+            デフォルトコンストラクタ
+        */
+        TripleBuffer() = default;
+
+        //! A destructor.
+        /*!
+            デフォルトデストラクタ
+        */
+        ~TripleBuffer() = default;
+
+        // #endregion コンストラクタ・デストラクタ
+
+        // #region メンバ関数
+
+        //! A public member function.
+        /*!
+            書き込み側が値を書き込むバッファを返す
+            書き込み側のスレッドからだけ呼ぶこと
+            \return 書き込み中のバッファ
+        */
+        T & back()
+        {
+            return buffers_[back_];
+        }
+
+        //! A public member function (constant).
+        /*!
+            読み出し側が値を読み出すバッファを返す
+            読み出し側のスレッドからだけ呼ぶこと
+            \return 読み出し中のバッファ
+        */
+        T const & front() const
+        {
+            return buffers_[front_];
+        }
+
+        //! A public member function (constant).
+        /*!
+            前にpublish()した値が、まだ読み出し側に受け取られずに受け渡し待ちになっているかどうか
+            書き込み側のスレッドからだけ呼ぶこと
+            trueのときにpublish()すると、受け渡し待ちの値は読み出されないまま捨てられる
+            trueの間publish()しないと、読み出し側が次に受け取る値は前に受け取った直後に書き込まれた値になり、
+            読み出す間隔の分だけ古くなる（最新の値を受け取れるようにするなら、ときどき書き直すこと）
+            \return 受け取られていなければtrue
+        */
+        bool pending() const
+        {
+            return (middle_.load(std::memory_order_acquire) & TripleBuffer::FRESH) != 0;
+        }
+
+        //! A public member function.
+        /*!
+            書き込み中のバッファを受け渡し待ちにし、前の受け渡し待ちのバッファを次の書き込みに使う
+            書き込み側のスレッドからだけ呼ぶこと
+            （受け渡し待ちだったバッファには古い値が残っているので、書き込み側は全体を書き直すこと）
+        */
+        void publish()
+        {
+            auto const old = middle_.exchange(static_cast<std::uint8_t>(back_ | TripleBuffer::FRESH), std::memory_order_acq_rel);
+            back_ = static_cast<std::uint8_t>(old & TripleBuffer::INDEXMASK);
+        }
+
+        //! A public member function.
+        /*!
+            新しい値が受け渡し待ちになっていれば、読み出し中のバッファと交換する
+            読み出し側のスレッドからだけ呼ぶこと
+            \return 新しい値を受け取ったらtrue（falseならfront()は前と同じ値）
+        */
+        bool update()
+        {
+            if (!(middle_.load(std::memory_order_acquire) & TripleBuffer::FRESH)) {
+                return false;
+            }
+
+            // load()とexchange()の間にpublish()されても、より新しい値を受け取るだけなので問題ない
+            auto const old = middle_.exchange(front_, std::memory_order_acq_rel);
+            front_ = static_cast<std::uint8_t>(old & TripleBuffer::INDEXMASK);
+            return true;
+        }
+
+        // #endregion メンバ関数
+
+        // #region メンバ変数
+
+    private:
+        //! A private member variable (constant).
+        /*!
+            受け渡し待ちのバッファが、まだ読み出されていない新しい値であることを示すビット
+        */
+        static std::uint8_t const FRESH = 0x4;
+
+        //! A private member variable (constant).
+        /*!
+            バッファの番号を取り出すマスク
+        */
+        static std::uint8_t const INDEXMASK = 0x3;
+
+        //! A private member variable.
+        /*!
+            書き込み中のバッファの番号（書き込み側だけが触る）
+        */
+        std::uint8_t back_ = 0;
+
+        //! A private member variable.
+        /*!
+            三つのバッファ
+        */
+        std::array<T, 3> buffers_;
+
+        //! A private member variable.
+        /*!
+            読み出し中のバッファの番号（読み出し側だけが触る）
+        */
+        std::uint8_t front_ = 1;
+
+        //! A private member variable.
+        /*!
+            受け渡し待ちのバッファの番号と、FRESHのビット
+        */
+        std::atomic<std::uint8_t> middle_ { 2 };
+
+        // #endregion メンバ変数
+
+        // #region 禁止されたコンストラクタ・メンバ関数
+
+        //! A private copy constructor (deleted).
+        /*!
+            コピーコンストラクタ（禁止）
+        */
+        TripleBuffer(TripleBuffer const &) = delete;
+
+        //! A private member function (deleted).
+        /*!
+            operator=()の宣言（禁止）
+            \param コピー元のオブジェクト（未使用）
+            \return コピー元のオブジェクト
+        */
+        TripleBuffer & operator=(TripleBuffer const &) = delete;
+
+        // #endregion 禁止されたコンストラクタ・メンバ関数
+    };
+}
+
+#endif      // _TRIPLEBUFFER_H_